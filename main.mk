@@ -43,6 +43,38 @@ SRC_INCDIRS := ${GP_BASE_DIR} ${GP_BASE_DIR}/util
 SOURCES := \
 	${GP_BASE_DIR}/dbg_util.cpp \
 	${GP_BASE_DIR}/is_utf8.cpp \
+	${GP_BASE_DIR}/zo_scan.cpp \
+	${GP_BASE_DIR}/zo_ignore.cpp \
+	${GP_BASE_DIR}/zo_snapshot.cpp \
+	${GP_BASE_DIR}/zo_saved_plan.cpp \
+	${GP_BASE_DIR}/zo_stats.cpp \
+	${GP_BASE_DIR}/zo_trace.cpp \
+	${GP_BASE_DIR}/zo_progress.cpp \
+	${GP_BASE_DIR}/zo_log.cpp \
+	${GP_BASE_DIR}/zo_mem.cpp \
+	${GP_BASE_DIR}/zo_vfs.cpp \
+	${GP_BASE_DIR}/zo_uring.cpp \
+	${GP_BASE_DIR}/zo_pool.cpp \
+	${GP_BASE_DIR}/zo_prefetch.cpp \
+	${GP_BASE_DIR}/zo_dir_trie.cpp \
+	${GP_BASE_DIR}/zo_spill.cpp \
 	${GP_BASE_DIR}/sfz_org.cpp \
+	${GP_BASE_DIR}/sfz_main.cpp \
 
 
+
+SUBMAKEFILES := \
+	${GP_BASE_DIR}/bench/gen.mk \
+	${GP_BASE_DIR}/bench/bench.mk \
+
+
+.DEFAULT_GOAL := all
+
+BENCH_BASELINE := ${GP_BASE_DIR}/bench/bench_baseline.txt
+
+.PHONY: bench bench_baseline
+bench: build/sfz_bench
+	./build/sfz_bench --baseline ${BENCH_BASELINE}
+
+bench_baseline: build/sfz_bench
+	./build/sfz_bench --save ${BENCH_BASELINE}
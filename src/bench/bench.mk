@@ -0,0 +1,35 @@
+
+# microbenchmarks of the hot kernels. Run with 'make bench'
+
+TARGET := build/sfz_bench
+
+TGT_LDFLAGS := -pthread
+TGT_LDLIBS := -lstdc++fs
+
+TGT_POSTMAKE := printf "====================================\nFinished building "$(TARGET)"\n\n\n"
+
+SRC_CXXFLAGS := ${CXX_BASE_FLAGS} ${GP_DBG_FLAG} -pthread
+
+SRC_INCDIRS := ..
+
+SOURCES := \
+	../dbg_util.cpp \
+	../is_utf8.cpp \
+	../zo_scan.cpp \
+	../zo_ignore.cpp \
+	../zo_snapshot.cpp \
+	../zo_saved_plan.cpp \
+	../zo_stats.cpp \
+	../zo_trace.cpp \
+	../zo_progress.cpp \
+	../zo_log.cpp \
+	../zo_mem.cpp \
+	../zo_vfs.cpp \
+	../zo_uring.cpp \
+	../zo_pool.cpp \
+	../zo_prefetch.cpp \
+	../zo_dir_trie.cpp \
+	../zo_spill.cpp \
+	../sfz_org.cpp \
+	zo_bench.cpp \
+
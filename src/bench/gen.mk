@@ -0,0 +1,15 @@
+
+# synthetic sfz library generator. Used by src/bench/run_bench.sh
+
+TARGET := build/sfz_gen
+
+TGT_LDFLAGS := -pthread
+TGT_LDLIBS := -lstdc++fs
+
+TGT_POSTMAKE := printf "====================================\nFinished building "$(TARGET)"\n\n\n"
+
+SRC_CXXFLAGS := ${CXX_BASE_FLAGS} -pthread
+
+SOURCES := \
+	sfz_gen.cpp \
+
@@ -0,0 +1,98 @@
+#!/bin/bash
+
+# end to end benchmark of sfz_organizer on synthetic libraries.
+#
+# usage: run_bench.sh [-o results.json] [-r runs] [-w work_dir] [-- sfz_gen options]
+#
+# Each scenario runs on a freshly generated library (same seed, so the
+# same library) and the --stats report of every run is kept in the results.
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+BASE_DIR="$( cd "$SCRIPT_DIR/../.." && pwd )"
+
+ORGANIZER=${ORGANIZER:-$BASE_DIR/build/sfz_organizer}
+GENERATOR=${GENERATOR:-$BASE_DIR/build/sfz_gen}
+
+OUT_FILE=bench_results.json
+RUNS=3
+WORK_DIR=""
+
+while [ $# -gt 0 ]; do
+	case "$1" in
+		-o) OUT_FILE="$2"; shift 2;;
+		-r) RUNS="$2"; shift 2;;
+		-w) WORK_DIR="$2"; shift 2;;
+		--) shift; break;;
+		*) echo "Unknown option '$1'"; exit 1;;
+	esac
+done
+GEN_ARGS=("$@")
+
+if [ ! -x "$ORGANIZER" ] || [ ! -x "$GENERATOR" ]; then
+	echo "Build first (make). Missing $ORGANIZER or $GENERATOR"
+	exit 1
+fi
+
+if [ -z "$WORK_DIR" ]; then
+	WORK_DIR=$(mktemp -d)
+	trap 'rm -rf "$WORK_DIR"' EXIT
+fi
+LIB_DIR="$WORK_DIR/lib"
+
+SCENARIOS=(
+	"list_normalize|-N -r -l"
+	"normalize|-N -r -F"
+	"purge|-p -r -F"
+	"copy|-c -r -F -t $LIB_DIR/zz_copy"
+	"move|-m -r -F -t $LIB_DIR/zz_move"
+)
+
+new_library(){
+	rm -rf "$LIB_DIR"
+	"$GENERATOR" --out "$LIB_DIR" "${GEN_ARGS[@]}" > "$WORK_DIR/gen.json" || exit 1
+	mkdir -p "$LIB_DIR/zz_copy" "$LIB_DIR/zz_move"
+}
+
+now_ns(){
+	date +%s%N
+}
+
+new_library
+{
+	echo "{"
+	echo "\"date\": \"$(date -u +%Y-%m-%dT%H:%M:%SZ)\","
+	echo "\"host\": \"$(uname -n)\","
+	echo "\"runs\": $RUNS,"
+	echo "\"library\": $(cat "$WORK_DIR/gen.json"),"
+	echo "\"scenarios\": ["
+} > "$OUT_FILE"
+
+FST_SCN=1
+for SCN in "${SCENARIOS[@]}"; do
+	NAM=${SCN%%|*}
+	ARGS=${SCN#*|}
+	[ $FST_SCN -eq 1 ] || echo "," >> "$OUT_FILE"
+	FST_SCN=0
+	echo "{\"name\": \"$NAM\", \"args\": \"$ARGS\", \"all_runs\": [" >> "$OUT_FILE"
+	for (( RR=0; RR<RUNS; RR++ )); do
+		new_library
+		T0=$(now_ns)
+		(cd "$LIB_DIR" && "$ORGANIZER" $ARGS -q --stats "$WORK_DIR/stats.json" > /dev/null 2> "$WORK_DIR/err.txt")
+		T1=$(now_ns)
+		WALL_MS=$(( (T1 - T0) / 1000000 ))
+		echo "$NAM run $RR: $WALL_MS ms"
+		[ $RR -eq 0 ] || echo "," >> "$OUT_FILE"
+		echo "{\"wall_ms\": $WALL_MS, \"stats\": " >> "$OUT_FILE"
+		if [ -s "$WORK_DIR/stats.json" ]; then
+			cat "$WORK_DIR/stats.json" >> "$OUT_FILE"
+		else
+			echo "null" >> "$OUT_FILE"
+		fi
+		echo "}" >> "$OUT_FILE"
+		rm -f "$WORK_DIR/stats.json"
+	done
+	echo "]}" >> "$OUT_FILE"
+done
+
+echo "]}" >> "$OUT_FILE"
+echo "Results in $OUT_FILE"
@@ -0,0 +1,283 @@
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#ifdef HAS_FILESYSTEM
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+using zo_string = std::string;
+using zo_str_vec = std::vector<std::string>;
+using zo_path = fs::path;
+
+// deterministic generator of synthetic sfz libraries for benchmarks.
+
+class zo_gen_params {
+public:
+	zo_string 	out_dir{""};
+	long 		tot_sfz{100};
+	long 		tot_spl{1000};
+	long 		refs_per_sfz{10};
+	long 		depth{2};
+	long 		fanout{3};
+	long 		ctl_pct{20};		// sfz files using <control> default_path
+	long 		collide_pct{5};		// samples with a sibling that normalizes to the same name
+	long 		bad_ref_pct{2};		// references to missing samples
+	long 		backslash_pct{10};	// references written with '\' separators
+	long 		sample_bytes{64};
+	unsigned long seed{12345};
+};
+
+class zo_rand {
+public:
+	unsigned long 	st;
+
+	zo_rand(unsigned long sd){
+		st = (sd == 0)?(0x9E3779B97F4A7C15UL):(sd);
+	}
+
+	unsigned long next(){
+		st ^= st << 13;
+		st ^= st >> 7;
+		st ^= st << 17;
+		return st;
+	}
+
+	long below(long nn){
+		return (nn <= 0)?(0):((long)(next() % (unsigned long)nn));
+	}
+
+	bool pct(long pp){
+		return (below(100) < pp);
+	}
+};
+
+class zo_gen_dir {
+public:
+	zo_str_vec 	parts;		// relative to out_dir
+};
+
+class zo_gen_sample {
+public:
+	long 		dir{0};
+	zo_string 	name{""};
+};
+
+zo_string
+join_parts(const zo_str_vec& parts, long upto, char sep){
+	zo_string pth = "";
+	for(long aa = 0; aa < upto; aa++){
+		if(aa > 0){
+			pth += sep;
+		}
+		pth += parts[aa];
+	}
+	return pth;
+}
+
+zo_string
+rel_dir_path(const zo_gen_dir& from, const zo_gen_dir& to, char sep){
+	long cm = 0;
+	while((cm < (long)from.parts.size()) && (cm < (long)to.parts.size()) && (from.parts[cm] == to.parts[cm])){
+		cm++;
+	}
+	zo_string rel = "";
+	for(long aa = cm; aa < (long)from.parts.size(); aa++){
+		rel += "..";
+		rel += sep;
+	}
+	for(long aa = cm; aa < (long)to.parts.size(); aa++){
+		rel += to.parts[aa];
+		rel += sep;
+	}
+	return rel;
+}
+
+void
+make_dirs(const zo_gen_params& prm, std::vector<zo_gen_dir>& all_dir){
+	all_dir.push_back(zo_gen_dir{});
+	long fst = 0;
+	for(long dd = 0; dd < prm.depth; dd++){
+		long lst = (long)all_dir.size();
+		for(long aa = fst; aa < lst; aa++){
+			for(long ff = 0; ff < prm.fanout; ff++){
+				zo_gen_dir nw = all_dir[aa];
+				nw.parts.push_back("Dir " + std::to_string(dd) + "-" + std::to_string(ff));
+				all_dir.push_back(nw);
+			}
+		}
+		fst = lst;
+	}
+}
+
+bool
+write_file(const zo_path& pth, const zo_string& content){
+	std::ofstream ostm;
+	ostm.open(pth.c_str(), std::ios::binary);
+	if(! ostm.good() || ! ostm.is_open()){
+		fprintf(stderr, "Cannot open file:'%s'\n", pth.c_str());
+		return false;
+	}
+	ostm << content;
+	return ostm.good();
+}
+
+void
+print_help(const char* prg){
+	fprintf(stdout,
+R"help(
+%s --out <dir> [options]
+
+Writes a deterministic synthetic sfz library under <dir> (that must not exist) and prints a JSON summary.
+
+	--sfz <n>            number of sfz files (100)
+	--samples <n>        number of samples (1000)
+	--refs <n>           sample references per sfz (10)
+	--depth <n>          directory depth (2)
+	--fanout <n>         subdirectories per directory (3)
+	--ctl_pct <n>        percent of sfz files with a <control> default_path (20)
+	--collide_pct <n>    percent of samples with a sibling that normalizes to the same name (5)
+	--bad_ref_pct <n>    percent of references to missing samples (2)
+	--backslash_pct <n>  percent of references written with '\' separators (10)
+	--sample_bytes <n>   size of each sample (64)
+	--seed <n>           random seed (12345)
+
+)help", prg);
+}
+
+bool
+get_params(int argc, char** argv, zo_gen_params& prm){
+	for(int aa = 1; aa < argc; aa++){
+		zo_string ar = argv[aa];
+		if(ar == "--help"){
+			return false;
+		}
+		if((aa + 1) >= argc){
+			fprintf(stderr, "Missing value for '%s'\n", ar.c_str());
+			return false;
+		}
+		zo_string vv = argv[++aa];
+		long nn = atol(vv.c_str());
+		if(ar == "--out"){ prm.out_dir = vv; }
+		else if(ar == "--sfz"){ prm.tot_sfz = nn; }
+		else if(ar == "--samples"){ prm.tot_spl = nn; }
+		else if(ar == "--refs"){ prm.refs_per_sfz = nn; }
+		else if(ar == "--depth"){ prm.depth = nn; }
+		else if(ar == "--fanout"){ prm.fanout = nn; }
+		else if(ar == "--ctl_pct"){ prm.ctl_pct = nn; }
+		else if(ar == "--collide_pct"){ prm.collide_pct = nn; }
+		else if(ar == "--bad_ref_pct"){ prm.bad_ref_pct = nn; }
+		else if(ar == "--backslash_pct"){ prm.backslash_pct = nn; }
+		else if(ar == "--sample_bytes"){ prm.sample_bytes = nn; }
+		else if(ar == "--seed"){ prm.seed = strtoul(vv.c_str(), NULL, 10); }
+		else {
+			fprintf(stderr, "Unknown option '%s'\n", ar.c_str());
+			return false;
+		}
+	}
+	return ! prm.out_dir.empty() && (prm.tot_spl > 0) && (prm.fanout > 0);
+}
+
+int
+main(int argc, char** argv){
+	zo_gen_params prm;
+	if(! get_params(argc, argv, prm)){
+		print_help(argv[0]);
+		return 1;
+	}
+	zo_path base = prm.out_dir;
+	if(fs::exists(base)){
+		fprintf(stderr, "'%s' already exists\n", base.c_str());
+		return 1;
+	}
+	zo_rand rnd(prm.seed);
+
+	std::vector<zo_gen_dir> all_dir;
+	make_dirs(prm, all_dir);
+	for(const auto& dd : all_dir){
+		fs::create_directories(base / join_parts(dd.parts, dd.parts.size(), '/'));
+	}
+
+	zo_string spl_data(prm.sample_bytes, '\0');
+	for(long aa = 0; aa < prm.sample_bytes; aa++){
+		spl_data[aa] = (char)rnd.below(256);
+	}
+
+	std::vector<zo_gen_sample> all_spl;
+	long tot_collide = 0;
+	for(long aa = 0; (long)all_spl.size() < prm.tot_spl; aa++){
+		zo_gen_sample sp;
+		sp.dir = rnd.below(all_dir.size());
+		sp.name = "Smp " + std::to_string(aa) + " (v1).wav";
+		all_spl.push_back(sp);
+		if(((long)all_spl.size() < prm.tot_spl) && rnd.pct(prm.collide_pct)){
+			sp.name = "Smp_" + std::to_string(aa) + "__v1_.wav";	// normalizes like the previous one
+			all_spl.push_back(sp);
+			tot_collide++;
+		}
+	}
+	for(const auto& sp : all_spl){
+		const zo_gen_dir& dd = all_dir[sp.dir];
+		if(! write_file(base / join_parts(dd.parts, dd.parts.size(), '/') / sp.name, spl_data)){
+			return 1;
+		}
+	}
+
+	std::vector<std::vector<long>> spl_by_dir(all_dir.size());
+	for(long aa = 0; aa < (long)all_spl.size(); aa++){
+		spl_by_dir[all_spl[aa].dir].push_back(aa);
+	}
+
+	long tot_refs = 0;
+	long tot_bad = 0;
+	long tot_ctl = 0;
+	for(long ss = 0; ss < prm.tot_sfz; ss++){
+		long sdir = rnd.below(all_dir.size());
+		const zo_gen_dir& sfd = all_dir[sdir];
+		zo_string txt = "// synthetic sfz " + std::to_string(ss) + "\n";
+
+		long ctl_dir = -1;
+		if(rnd.pct(prm.ctl_pct)){
+			ctl_dir = all_spl[rnd.below(all_spl.size())].dir;
+			txt += "<control>\ndefault_path=" + rel_dir_path(sfd, all_dir[ctl_dir], '/') + "\n";
+			tot_ctl++;
+		}
+		txt += "<group> lovel=0 hivel=127\n";
+		for(long rr = 0; rr < prm.refs_per_sfz; rr++){
+			zo_string ref = "";
+			if(rnd.pct(prm.bad_ref_pct)){
+				ref = "missing/Missing " + std::to_string(ss) + "-" + std::to_string(rr) + ".wav";
+				tot_bad++;
+			} else if(ctl_dir >= 0){
+				const std::vector<long>& in_dir = spl_by_dir[ctl_dir];
+				ref = all_spl[in_dir[rnd.below(in_dir.size())]].name;
+			} else {
+				const zo_gen_sample& sp = all_spl[rnd.below(all_spl.size())];
+				char sep = (rnd.pct(prm.backslash_pct))?('\\'):('/');
+				ref = rel_dir_path(sfd, all_dir[sp.dir], sep) + sp.name;
+			}
+			txt += "<region> sample=" + ref + " key=" + std::to_string(36 + (rr % 60)) + "\n";
+			tot_refs++;
+		}
+		zo_string nm = "Sfz " + std::to_string(ss) + ((ss % 7 == 0)?(" (copy).sfz"):(".sfz"));
+		if(! write_file(base / join_parts(sfd.parts, sfd.parts.size(), '/') / nm, txt)){
+			return 1;
+		}
+	}
+
+	fprintf(stdout, "{\"out\": \"%s\", \"seed\": %lu, \"dirs\": %ld, \"sfz\": %ld, \"samples\": %ld, "
+			"\"colliding_samples\": %ld, \"refs\": %ld, \"bad_refs\": %ld, \"control_sfz\": %ld}\n",
+			base.c_str(), prm.seed, (long)all_dir.size(), prm.tot_sfz, (long)all_spl.size(),
+			tot_collide, tot_refs, tot_bad, tot_ctl);
+	return 0;
+}
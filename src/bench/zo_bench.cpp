@@ -0,0 +1,368 @@
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <functional>
+#include <map>
+
+#include "is_utf8.h"
+#include "sfz_org.h"
+
+// microbenchmarks of the hot kernels on in-memory inputs. Run with 'make bench'.
+
+class zo_bench_res {
+public:
+	zo_string 	name{""};
+	long 		iters{0};
+	double 		ns_op{0};
+	double 		bytes_op{0};
+	double 		allocs_op{0};
+};
+
+using zo_bench_fn = std::function<void(long)>;
+using zo_bench_base = std::map<zo_string, zo_bench_res>;
+
+class zo_bench_rand {
+public:
+	unsigned long 	st{88172645463325252UL};
+
+	unsigned long next(){
+		st ^= st << 13;
+		st ^= st >> 7;
+		st ^= st << 17;
+		return st;
+	}
+
+	long below(long nn){
+		return (long)(next() % (unsigned long)nn);
+	}
+};
+
+constexpr long ZO_BENCH_TOT_INPUTS = 1024;
+constexpr long ZO_BENCH_COLLIDE_BATCH = 64;
+constexpr long ZO_BENCH_UTF8_SZ = 16 * 1024;
+constexpr int ZO_BENCH_REPS = 3;
+
+static
+void
+mem_totals(long& bytes, long& allocs){
+	bytes = 0;
+	allocs = 0;
+	for(auto& tg : ZO_MEM.all_tag){
+		bytes += tg.bytes.load();
+		allocs += tg.allocs.load();
+	}
+}
+
+// best of ZO_BENCH_REPS timed runs of iters ops, after a short warm up.
+zo_bench_res
+run_bench(const char* nam, long iters, zo_bench_fn fn){
+	zo_bench_res res;
+	res.name = nam;
+	res.iters = iters;
+	for(long aa = 0; aa < (iters / 10); aa++){
+		fn(aa);
+	}
+	for(int rr = 0; rr < ZO_BENCH_REPS; rr++){
+		long b0, a0, b1, a1;
+		mem_totals(b0, a0);
+		long t0 = zo_wall_ns();
+		for(long aa = 0; aa < iters; aa++){
+			fn(aa);
+		}
+		long t1 = zo_wall_ns();
+		mem_totals(b1, a1);
+		double ns_op = (double)(t1 - t0) / iters;
+		if((rr == 0) || (ns_op < res.ns_op)){
+			res.ns_op = ns_op;
+		}
+		res.bytes_op = (double)(b1 - b0) / iters;
+		res.allocs_op = (double)(a1 - a0) / iters;
+	}
+	return res;
+}
+
+zo_str_vec
+make_names(zo_bench_rand& rnd){
+	const char* seps = " _-()+.";
+	zo_str_vec all_nm;
+	for(long aa = 0; aa < ZO_BENCH_TOT_INPUTS; aa++){
+		zo_string nm = "Piano";
+		long tot_parts = 2 + rnd.below(4);
+		for(long pp = 0; pp < tot_parts; pp++){
+			nm += seps[rnd.below(7)];
+			nm += "Vel" + std::to_string(rnd.below(128));
+		}
+		nm += ((aa % 3) == 0)?("_c" + std::to_string(aa) + ".wav"):(".wav");
+		all_nm.push_back(nm);
+	}
+	return all_nm;
+}
+
+zo_str_vec
+make_dir_paths(zo_bench_rand& rnd, long depth){
+	zo_str_vec all_pth;
+	for(long aa = 0; aa < ZO_BENCH_TOT_INPUTS; aa++){
+		zo_string pth = "/home/user/sfz";
+		long dd = 1 + rnd.below(depth);
+		for(long pp = 0; pp < dd; pp++){
+			pth += "/Dir " + std::to_string(rnd.below(3)) + "-" + std::to_string(pp);
+		}
+		all_pth.push_back(pth);
+	}
+	return all_pth;
+}
+
+// names that all normalize to the same one. Differ only in the non alphanumeric chars.
+zo_str_vec
+make_colliding_names(const zo_path& dir){
+	const char* seps = " _-()+";
+	zo_str_vec all_nm;
+	for(long aa = 0; aa < ZO_BENCH_COLLIDE_BATCH; aa++){
+		zo_string nm = "Smp";
+		nm += seps[aa % 6];
+		nm += "1";
+		nm += seps[(aa / 6) % 6];
+		nm += seps[(aa / 36) % 6];
+		nm += "v1";
+		nm += seps[(aa * 5) % 6];
+		nm += ".wav";
+		all_nm.push_back(dir / nm);
+	}
+	return all_nm;
+}
+
+bool
+write_bench_file(const zo_path& pth, const zo_string& content){
+	std::ofstream ostm;
+	ostm.open(pth.c_str(), std::ios::binary);
+	if(! ostm.good() || ! ostm.is_open()){
+		fprintf(stderr, "Cannot open file:'%s'\n", pth.c_str());
+		return false;
+	}
+	ostm << content;
+	return ostm.good();
+}
+
+// an sfz with a <control> header, comments, backslashes and regions under 'smp'.
+bool
+make_sfz_input(const zo_path& dir, zo_path& sfz_pth){
+	fs::create_directories(dir / "smp");
+	for(long aa = 0; aa < 16; aa++){
+		if(! write_bench_file(dir / "smp" / ("Smp " + std::to_string(aa) + ".wav"), "RIFF")){
+			return false;
+		}
+	}
+	zo_string txt = "// bench sfz\n<group> lovel=0 hivel=127 // velocity layer\n";
+	for(long aa = 0; aa < 48; aa++){
+		zo_string sep = ((aa % 5) == 0)?("\\"):("/");
+		txt += "<region> sample=smp" + sep + "Smp " + std::to_string(aa % 16) + ".wav key=" +
+			std::to_string(36 + aa) + " // note\n";
+	}
+	txt += "<control>\ndefault_path=smp/\n";
+	for(long aa = 0; aa < 16; aa++){
+		txt += "<region> sample=Smp " + std::to_string(aa) + ".wav lokey=" + std::to_string(aa) + "\n";
+	}
+	sfz_pth = dir / "bench.sfz";
+	return write_bench_file(sfz_pth, txt);
+}
+
+void
+free_sfont(zo_sfont_pt sf){
+	for(auto ct : sf->all_ctl){ delete ct; }
+	delete sf;
+}
+
+void
+free_conflicts(zo_orga& org){
+	std::set<zo_last_confl_pt> all_cfl;
+	for(auto& cc : org.all_unique_nxt){ all_cfl.insert(cc.second); }
+	for(auto cf : all_cfl){ delete cf; }
+	org.all_unique_nxt.clear();
+	org.all_conflict.clear();
+}
+
+bool
+load_baseline(const zo_string& fnam, zo_bench_base& all_base){
+	std::ifstream istm;
+	istm.open(fnam.c_str(), std::ios::binary);
+	if(! istm.good() || ! istm.is_open()){
+		fprintf(stderr, "Cannot open baseline file:'%s'\n", fnam.c_str());
+		return false;
+	}
+	zo_string ln;
+	for(;getline(istm, ln);){
+		if(ln.empty() || (ln[0] == '#')){
+			continue;
+		}
+		zo_bench_res rr;
+		char nam[256];
+		if(sscanf(ln.c_str(), "%255s %ld %lf %lf %lf", nam, &rr.iters, &rr.ns_op, &rr.bytes_op, &rr.allocs_op) == 5){
+			rr.name = nam;
+			all_base[rr.name] = rr;
+		}
+	}
+	return true;
+}
+
+bool
+save_results(const zo_string& fnam, const std::vector<zo_bench_res>& all_res){
+	FILE* ff = fopen(fnam.c_str(), "w");
+	if(ff == zo_null){
+		fprintf(stderr, "Cannot open file:'%s'\n", fnam.c_str());
+		return false;
+	}
+	fprintf(ff, "# name iters ns_op bytes_op allocs_op\n");
+	for(const auto& rr : all_res){
+		fprintf(ff, "%s %ld %.1f %.1f %.2f\n", rr.name.c_str(), rr.iters, rr.ns_op, rr.bytes_op, rr.allocs_op);
+	}
+	return (fclose(ff) == 0);
+}
+
+void
+print_results(const std::vector<zo_bench_res>& all_res, const zo_bench_base& all_base){
+	fprintf(stdout, "%-24s %10s %12s %12s %10s %10s\n", "kernel", "iters", "ns/op", "bytes/op", "allocs/op", "vs_base");
+	for(const auto& rr : all_res){
+		fprintf(stdout, "%-24s %10ld %12.1f %12.1f %10.2f ", rr.name.c_str(), rr.iters, rr.ns_op, rr.bytes_op, rr.allocs_op);
+		auto it = all_base.find(rr.name);
+		if((it != all_base.end()) && (it->second.ns_op > 0)){
+			fprintf(stdout, "%9.2fx\n", rr.ns_op / it->second.ns_op);
+		} else {
+			fprintf(stdout, "%10s\n", "-");
+		}
+	}
+}
+
+void
+print_help(const char* prg){
+	fprintf(stdout,
+R"help(
+%s [--baseline <file>] [--save <file>] [--scale <n>] [--only <kernel>]
+
+Runs each kernel a fixed number of times (times <n>) and prints ns/op, bytes/op and allocs/op.
+With --baseline the ns/op ratio to the baseline file is printed (below 1.00x is faster).
+With --save the results are written in the baseline file format.
+
+)help", prg);
+}
+
+int
+main(int argc, char** argv){
+	zo_string base_nam = "";
+	zo_string save_nam = "";
+	zo_string only_nam = "";
+	long scale = 1;
+	for(int aa = 1; aa < argc; aa++){
+		zo_string ar = argv[aa];
+		if(((aa + 1) < argc) && (ar == "--baseline")){ base_nam = argv[++aa]; }
+		else if(((aa + 1) < argc) && (ar == "--save")){ save_nam = argv[++aa]; }
+		else if(((aa + 1) < argc) && (ar == "--only")){ only_nam = argv[++aa]; }
+		else if(((aa + 1) < argc) && (ar == "--scale")){ scale = std::max(1L, atol(argv[++aa])); }
+		else {
+			print_help(argv[0]);
+			return 1;
+		}
+	}
+
+	zo_bench_base all_base;
+	if(! base_nam.empty() && ! load_baseline(base_nam, all_base)){
+		return 1;
+	}
+
+	zo_path work_dir = fs::temp_directory_path() / ("zo_bench_" + std::to_string(getpid()));
+	fs::create_directories(work_dir);
+	work_dir = fs::canonical(work_dir);
+	zo_path sfz_pth;
+	if(! make_sfz_input(work_dir, sfz_pth)){
+		return 1;
+	}
+
+	zo_bench_rand rnd;
+	zo_str_vec all_nm = make_names(rnd);
+	zo_str_vec all_dir = make_dir_paths(rnd, 6);
+	zo_str_vec all_dir2 = make_dir_paths(rnd, 6);
+	zo_str_vec all_win;
+	for(const auto& pth : all_dir){
+		zo_string ww = pth;
+		std::replace(ww.begin(), ww.end(), '/', ((rnd.below(2) == 0)?('\\'):('/')));
+		all_win.push_back(ww);
+	}
+	zo_string utf8_txt;
+	while((long)utf8_txt.size() < ZO_BENCH_UTF8_SZ){
+		utf8_txt += "<region> sample=Gr\xC3\xBC\xC3\x9F\x65 \xE2\x99\xAA/Smp 1.wav key=60\n";
+	}
+	utf8_txt.resize(ZO_BENCH_UTF8_SZ);
+	zo_str_vec all_collide = make_colliding_names(work_dir);
+
+	zo_orga org;
+	org.oper = zo_action::normalize;
+	org.dir_from = work_dir;
+	org.dir_to = work_dir;
+
+	ZO_MEM.is_on = true;
+
+	zo_string nm;
+	nm.reserve(512);
+	std::vector<zo_bench_res> all_res;
+	auto add_bench = [&](const char* nam, long iters, zo_bench_fn fn){
+		if(! only_nam.empty() && (only_nam != nam)){
+			return;
+		}
+		all_res.push_back(run_bench(nam, iters * scale, fn));
+	};
+
+	add_bench("normalize_name", 200000, [&](long ii){
+		nm = all_nm[ii % ZO_BENCH_TOT_INPUTS];
+		normalize_name(nm);
+	});
+	add_bench("set_num_name", 20000, [&](long ii){
+		nm = all_nm[ii % ZO_BENCH_TOT_INPUTS];
+		set_num_name(nm, ii);
+	});
+	add_bench("fix_seps_path", 200000, [&](long ii){
+		nm = all_win[ii % ZO_BENCH_TOT_INPUTS];
+		fix_seps_path(nm);
+	});
+	add_bench("is_utf8_16k", 2000, [&](long ii){
+		zo_string msg;
+		int faulty_bytes = 0;
+		is_utf8((unsigned char*)utf8_txt.data(), utf8_txt.size(), msg, faulty_bytes);
+	});
+	add_bench("find_relative", 50000, [&](long ii){
+		std::error_code ec;
+		zo_path rel = find_relative(all_dir[ii % ZO_BENCH_TOT_INPUTS], all_dir2[(ii * 7) % ZO_BENCH_TOT_INPUTS], ec, false);
+	});
+	add_bench("get_rel_sample_path", 50000, [&](long ii){
+		std::error_code ec;
+		zo_path sf_pth = zo_path{all_dir[ii % ZO_BENCH_TOT_INPUTS]} / "Piano.sfz";
+		zo_path rf_pth = zo_path{all_dir2[(ii * 7) % ZO_BENCH_TOT_INPUTS]} / all_nm[ii % ZO_BENCH_TOT_INPUTS];
+		zo_string rel = get_rel_sample_path(sf_pth, rf_pth, ec, false);
+	});
+	add_bench("calc_next_collide_64", 20000, [&](long ii){
+		long nn = ii % ZO_BENCH_COLLIDE_BATCH;
+		if(nn == 0){
+			free_conflicts(org);
+		}
+		zo_fname fpth;
+		fpth.orig_pth = all_collide[nn];
+		fpth.calc_next(org, false);
+	});
+	free_conflicts(org);
+	add_bench("get_opcodes_64_refs", 500, [&](long ii){
+		zo_sfont_pt sf = make_sfont_pt(sfz_pth);
+		sf->get_opcodes(org);
+		free_sfont(sf);
+	});
+
+	ZO_MEM.is_on = false;
+	fs::remove_all(work_dir);
+
+	print_results(all_res, all_base);
+	if(! save_nam.empty() && ! save_results(save_nam, all_res)){
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,11 @@
+
+
+#include "sfz_org.h"
+
+int main(int argc, char* argv[]){
+	return sfz_organizer_main(argc, argv);
+	//return test_fix(argc, argv);
+	//return test_fs(argc, argv);
+	//return test_rx(argc, argv);
+	// create_directories
+}
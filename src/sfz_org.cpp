@@ -1,6 +1,7 @@
 
 
 #include <stdio.h>
+#include <string.h>
 
 #include <algorithm> 
 #include <cctype>
@@ -8,9 +9,11 @@
 #include <regex>
 #include <vector>
 #include <array>
+#include <sstream>
 
 #include <chrono>
 
+
 #include "is_utf8.h"
 #include "sfz_org.h"
 
@@ -92,39 +95,46 @@ unsigned char ZO_BUFFER[ZO_BUFFER_SZ];
 std::regex ZO_SAMPLE_LINE_PATTERN{R"(sample\s*=)"};
 std::regex ZO_OPCODE_PATTERN{R"((\w*)\s*=)"};
 
+// relative paths come from ZO_DIR_TRIE. Directories that passed the checks are not checked again.
 zo_path 
-find_relative(const zo_path& pth, const zo_path& base, std::error_code& ec, bool do_checks = true){
+find_relative(const zo_path& pth, const zo_path& base, std::error_code& ec, bool do_checks){
 	if(do_checks){
 		if(! pth.is_absolute()){
-			fprintf(stdout, "sfz_pth_not_absolute:'%s'\n", pth.c_str());
+			ZO_MSG(error, "sfz_pth_not_absolute:'%s'\n", pth.c_str());
 			ec = make_zo_err(sfz_pth_not_absolute);
 			return "";
 		}
-		if(! fs::exists(pth)){
-			fprintf(stdout, "sfz_pth_not_exists:'%s'\n", pth.c_str());
-			ec = make_zo_err(sfz_pth_not_exists);
-			return "";
-		}
-		if(! fs::is_directory(pth)){
-			fprintf(stdout, "sfz_pth_not_directory:'%s'\n", pth.c_str());
-			ec = make_zo_err(sfz_pth_not_directory);
-			return "";
+		if(! ZO_DIR_TRIE.is_checked(pth)){
+			if(! ZO_VFS->exists(pth)){
+				ZO_MSG(error, "sfz_pth_not_exists:'%s'\n", pth.c_str());
+				ec = make_zo_err(sfz_pth_not_exists);
+				return "";
+			}
+			if(! ZO_VFS->is_directory(pth)){
+				ZO_MSG(error, "sfz_pth_not_directory:'%s'\n", pth.c_str());
+				ec = make_zo_err(sfz_pth_not_directory);
+				return "";
+			}
+			ZO_DIR_TRIE.set_checked(pth);
 		}
 
 		if(! base.is_absolute()){
-			fprintf(stdout, "sfz_base_not_absolute:'%s'\n", base.c_str());
+			ZO_MSG(error, "sfz_base_not_absolute:'%s'\n", base.c_str());
 			ec = make_zo_err(sfz_base_not_absolute);
 			return "";
 		}
-		if(! fs::exists(base)){
-			fprintf(stdout, "sfz_base_not_exists:'%s'\n", base.c_str());
-			ec = make_zo_err(sfz_base_not_exists);
-			return "";
-		}
-		if(! fs::is_directory(base)){
-			fprintf(stdout, "sfz_base_not_directory:'%s'\n", base.c_str());
-			ec = make_zo_err(sfz_base_not_directory);
-			return "";
+		if(! ZO_DIR_TRIE.is_checked(base)){
+			if(! ZO_VFS->exists(base)){
+				ZO_MSG(error, "sfz_base_not_exists:'%s'\n", base.c_str());
+				ec = make_zo_err(sfz_base_not_exists);
+				return "";
+			}
+			if(! ZO_VFS->is_directory(base)){
+				ZO_MSG(error, "sfz_base_not_directory:'%s'\n", base.c_str());
+				ec = make_zo_err(sfz_base_not_directory);
+				return "";
+			}
+			ZO_DIR_TRIE.set_checked(base);
 		}
 	}
 
@@ -134,40 +144,71 @@ find_relative(const zo_path& pth, const zo_path& base, std::error_code& ec, bool
 	
 	//fprintf(stdout, "pth:%s\n", pth.c_str()); // dbg_prt
 	//fprintf(stdout, "base:%s\n", base.c_str()); // dbg_prt
+	return ZO_DIR_TRIE.get_relative(pth, base);
+}
 
-	zo_path result;
-
-	auto itr_path = pth.begin();
-	auto itr_bs = base.begin();
-	while(itr_path != pth.end() && itr_bs != base.end() && ((*itr_path) == (*itr_bs)) ) {
-		++itr_path;
-		++itr_bs;
-	}
+void
+zo_ref_table::reserve(long tot_ref, long tot_txt){
+	ZO_MEM_SCOPE(ref);
+	all_spl.reserve(tot_ref);
+	all_line.reserve(tot_ref);
+	all_ctl.reserve(tot_ref);
+	all_flag.reserve(tot_ref);
+	all_prefix.reserve(tot_ref);
+	all_suffix.reserve(tot_ref);
+	ZO_MEM_SCOPE(ref_strings);
+	txt.reserve(tot_txt);
+}
 
-	while(itr_bs != base.end() ) {
-		result /= "..";
-		++itr_bs;
-	}
+long
+zo_ref_table::add(long lnum, zo_sample_pt spl){
+	ZO_CK(spl != zo_null);
+	ZO_MEM_SCOPE(ref);
+	all_spl.push_back(spl);
+	all_line.push_back(lnum);
+	all_ctl.push_back(ZO_NO_CTL);
+	all_flag.push_back(0);
+	all_prefix.emplace_back();
+	all_suffix.emplace_back();
+	return size() - 1;
+}
 
-	while( itr_path != pth.end() ) {
-		result /= *itr_path;
-		++itr_path;
-	}
+zo_span
+zo_ref_table::add_text(const zo_string& str){
+	zo_span sp;
+	if(str.empty()){
+		return sp;
+	}
+	ZO_CK((txt.size() + str.size()) < UINT32_MAX);
+	ZO_MEM_SCOPE(ref_strings);
+	sp.off = (uint32_t)txt.size();
+	sp.len = (uint32_t)str.size();
+	txt += str;
+	return sp;
+}
 
-	//fprintf(stdout, "result:%s\n", result.c_str()); // dbg_prt
-	return result;
+// releases the memory of all columns.
+void
+zo_ref_table::clear(){
+	std::vector<zo_sample_pt>().swap(all_spl);
+	std::vector<long>().swap(all_line);
+	std::vector<long>().swap(all_ctl);
+	std::vector<uint8_t>().swap(all_flag);
+	std::vector<zo_span>().swap(all_prefix);
+	std::vector<zo_span>().swap(all_suffix);
+	zo_string().swap(txt);
 }
 
 const zo_string&
 zo_ref::get_orig(){
-	ZO_CK(sref != zo_null);
-	return sref->get_orig();
+	ZO_CK(sref() != zo_null);
+	return sref()->get_orig();
 }
 
 const zo_string& 
 zo_ref::get_next(){
-	ZO_CK(sref != zo_null);
-	return sref->get_next();
+	ZO_CK(sref() != zo_null);
+	return sref()->get_next();
 }
 
 const zo_string
@@ -186,7 +227,7 @@ get_rel_sample_path(zo_path& sf_pth, zo_path& rf_pth, std::error_code& ec, bool
 const zo_string
 zo_ref::get_orig_rel(){
 	ZO_CK(owner != zo_null);
-	ZO_CK(sref != zo_null);
+	ZO_CK(sref() != zo_null);
 	zo_path sf_pth = owner->get_orig();
 	zo_path rf_pth = get_orig();
 	
@@ -199,7 +240,7 @@ zo_ref::get_orig_rel(){
 const zo_string
 zo_ref::get_next_rel(){
 	ZO_CK(owner != zo_null);
-	ZO_CK(sref != zo_null);
+	ZO_CK(sref() != zo_null);
 	zo_path sf_pth = owner->get_next();
 	if(sf_pth.empty()){
 		sf_pth = owner->get_orig();
@@ -239,25 +280,25 @@ fix_ref_path(const zo_string& rpth, const zo_path& fpth, std::error_code& ec, bo
 	zo_string fx = rpth;
 	std::replace(fx.begin(), fx.end(), '\\', '/');
 	fixed = (rpth != fx);
-	zo_path fxp = fs::canonical(fs::absolute(fx, pnt), ec);
+	zo_path fxp = ZO_VFS->canonical(fs::absolute(fx, pnt), ec);
 	return fxp;
 }
 
 bool
 is_text_file(zo_path pth){
-	std::ifstream istm;
-	istm.open(pth.c_str(), std::ios::binary);
-	if(! istm.good() || ! istm.is_open()){
-		fprintf(stdout, "Cannot open file:'%s'\n", pth.c_str());
+	zo_istream_pt istm = ZO_VFS->open_read(pth);
+	if(! istm){
+		ZO_MSG(error, "Cannot open file:'%s'\n", pth.c_str());
 		std::cerr << "Error: " << strerror(errno) << "\n\n";
 		exit(0);
 		//ZO_CK(false);
 		//throw sfz_exception(sfz_cannot_open, pth);
 	}
 	
-	istm.read((char*)ZO_BUFFER, ZO_BUFFER_SZ);
+	istm->read((char*)ZO_BUFFER, ZO_BUFFER_SZ);
 
-	long tot_read = istm.gcount();
+	long tot_read = istm->gcount();
+	ZO_STAT_ADD(bytes_read, tot_read);
 	
 	std::string msg;
 	int faulty_bytes = 0;
@@ -269,11 +310,10 @@ is_text_file(zo_path pth){
 void
 zo_sfont::get_samples(zo_orga& org){
 	zo_sfont_pt fl = this;
-	std::ifstream istm;
 	zo_path fl_orig = fl->get_orig();
-	istm.open(fl_orig.c_str(), std::ios::binary);
-	if(! istm.good() || ! istm.is_open()){
-		fprintf(stdout, "Cannot open file:'%s'\n", fl_orig.c_str());
+	zo_istream_pt istm = ZO_VFS->open_read(fl_orig);
+	if(! istm){
+		ZO_MSG(error, "Cannot open file:'%s'\n", fl_orig.c_str());
 		std::cerr << "Error: " << strerror(errno) << "\n\n";
 		exit(0);
 		//ZO_CK(false);
@@ -286,7 +326,7 @@ zo_sfont::get_samples(zo_orga& org){
 	std::smatch opcode_matches;
 	long lnum = 0;
 	zo_string ln;
-	for(;getline(istm, ln);){
+	for(;getline(*istm, ln);){
 		lnum++;
 		std::size_t pos_spl = ln.find(ZO_SAMPLE_STR);
 		bool has_spl = (pos_spl != std::string::npos);
@@ -351,19 +391,20 @@ zo_sfont::get_samples(zo_orga& org){
 		
 		spl->all_bk_ref[fl_orig] = fl;
 		
-		auto nw_ref = make_ref_pt(fl, lnum, spl);
-		fl->all_ref.push_back(nw_ref);
+		zo_ref_table& tb = fl->all_ref;
+		long ri = tb.add(lnum, spl);
 		
 		if(ec){
-			nw_ref->bad_pth = ln;
+			tb.all_flag[ri] = ZO_REF_BAD;
+			tb.all_prefix[ri] = tb.add_text(ln);
 			fprintf(stderr, "bad_ref_line %ld:'%s' in file %s\n", lnum, ln.c_str(), fl_orig.c_str());
 		} else {
-			nw_ref->prefix = lprefix;
-			nw_ref->suffix = lsuffix;
-			nw_ref->fixed = fixed;
+			tb.all_prefix[ri] = tb.add_text(lprefix);
+			tb.all_suffix[ri] = tb.add_text(lsuffix);
+			tb.all_flag[ri] = (fixed)?(ZO_REF_FIXED):(0);
 		}
 	}
-	
+	count_diff_refs();
 }
 
 bool
@@ -382,24 +423,33 @@ has_sfz_ext(const zo_path& pth){
 
 void 
 zo_orga::read_file(const zo_path& pth, const zo_ftype ft, const bool only_with_ref){
-	zo_orga& org = *this;
-	ZO_CK(! only_with_ref || (ft == zo_ftype::soundfont));
-	if(! fs::exists(pth)){
+	std::error_code ec;
+	auto apth = zo_path{ZO_VFS->canonical(pth, ec)};
+	if(ec){
 		return;
 	}
-	auto apth = zo_path{fs::canonical(pth)};
+	read_canon_file(apth, ft, only_with_ref, has_sfz_ext(pth));	// by the name given, not the link target
+}
+
+void 
+zo_orga::read_canon_file(const zo_path& apth, const zo_ftype ft, const bool only_with_ref, const bool is_sfz, 
+						 const zo_inode_key& ino_key)
+{
+	zo_orga& org = *this;
+	ZO_CK(! only_with_ref || (ft == zo_ftype::soundfont));
+	ZO_CK(apth.is_absolute());
+	ZO_STAT_INC(files_scanned);
 	bool is_nw = false;
-	bool is_sfz = has_sfz_ext(pth);
 	
 	auto igt = all_to_ignore.find(apth);
 	if(igt != all_to_ignore.end()){
-		std::cout << "IGNORING " << apth << "\n";
+		ZO_EVENT(info, "IGNORING", apth.c_str(), zo_log_qt::pquote);
 		return;
 	}
 	
 	bool is_hdn = is_hidden(apth.filename());
 	if(is_hdn && ! hidden_too){
-		std::cout << "Hidden_file_ignored " << apth << "\n";
+		ZO_EVENT(info, "Hidden_file_ignored", apth.c_str(), zo_log_qt::pquote);
 		return;
 	}
 
@@ -407,11 +457,16 @@ zo_orga::read_file(const zo_path& pth, const zo_ftype ft, const bool only_with_r
 		zo_string nm = apth.filename();
 		std::smatch fname_matches;
 		if(! regex_search(nm, fname_matches, select_rx)){
-			std::cout << "File_not_matching_regex_ignored " << apth << "\n";
+			ZO_EVENT(info, "File_not_matching_regex_ignored", apth.c_str(), zo_log_qt::pquote);
 			return;
 		}
 	}
 	
+	if(strm != zo_null){
+		stream_file(apth, ft, only_with_ref, is_sfz);
+		return;
+	}
+	
 	bool adding_ext = (oper == zo_action::add_sfz);
 	if(adding_ext){
 		zo_sfont_pt sf = get_read_soundfont(apth, is_nw);
@@ -419,17 +474,22 @@ zo_orga::read_file(const zo_path& pth, const zo_ftype ft, const bool only_with_r
 			bool is_txt = is_text_file(apth);
 			if(is_txt){
 				get_selected_soundfont(apth, sf, is_nw);
+				if(pipe != zo_null){
+					pipe_plan_selected();
+				}
 			}
 		}
 		return;
 	}
-	bool purging = (oper == zo_action::purge);
+	bool purging = (oper == zo_action::purge) || chain_scan;
 	bool normal_sfz = true;
 	
 	if((ft == zo_ftype::soundfont) && is_sfz){
 		zo_sfont_pt sf = get_read_soundfont(apth, is_nw);
-		sf->can_move = ! only_with_ref;
-		sf->cmd_sel = ! only_with_ref;
+		if(is_nw || ! chain_scan){	// --actions keeps the selection of the walk for copy
+			sf->can_move = ! only_with_ref;
+			sf->cmd_sel = ! only_with_ref;
+		}
 		if(purging){
 			sf->is_txt = is_text_file(apth);
 			normal_sfz = sf->is_txt;
@@ -438,6 +498,9 @@ zo_orga::read_file(const zo_path& pth, const zo_ftype ft, const bool only_with_r
 			if(do_old){
 				ZO_CK(false);
 				sf->get_samples(org);
+			} else if(pipe != zo_null){
+				ZO_CK(! only_with_ref);
+				pipe_parse(sf);
 			} else {
 				sf->get_opcodes(org);
 			}
@@ -446,6 +509,9 @@ zo_orga::read_file(const zo_path& pth, const zo_ftype ft, const bool only_with_r
 		if(! only_with_ref || has_ref){
 			ZO_CK(! ((oper == zo_action::copy) && only_with_ref));
 			get_selected_soundfont(apth, sf, is_nw);
+			if(pipe != zo_null){
+				pipe_plan_selected();
+			}
 		}
 		return;
 	}
@@ -453,7 +519,16 @@ zo_orga::read_file(const zo_path& pth, const zo_ftype ft, const bool only_with_r
 		zo_sample_pt sp = get_read_sample(apth, is_nw);
 		sp->cmd_sel = true;
 		ZO_CK(sp != zo_null);
+		if(ino_key.is_valid()){
+			sp->ino_key = ino_key;
+		}
+		if(chain_scan && is_nw && has_step(zo_action::add_sfz)){
+			sp->is_txt = is_text_file(apth);
+		}
 		get_selected_sample(apth, sp, is_nw, true);
+		if(pipe != zo_null){
+			pipe_plan_selected();
+		}
 		return;
 	}
 }
@@ -463,93 +538,409 @@ void
 zo_orga::read_dir_files(zo_path pth_dir, const zo_ftype ft, const bool only_with_ref){
 	auto igt = all_to_ignore.find(pth_dir);
 	if(igt != all_to_ignore.end()){
-		std::cout << "IGNORING " << pth_dir << "\n";
+		ZO_EVENT(info, "IGNORING", pth_dir.c_str(), zo_log_qt::pquote);
 		return;
 	}
 	bool is_hdn = is_hidden(pth_dir.filename());
 	if(is_hdn && ! hidden_too){
-		std::cout << "Hidden_directory_ignored " << pth_dir << "\n";
+		ZO_EVENT(info, "Hidden_directory_ignored", pth_dir.c_str(), zo_log_qt::pquote);
 		return;
 	}
 	
-	if(fs::is_symlink(pth_dir)){
-		if(! follw_symlk){
-			std::cout << "Symlink_ignored " << pth_dir << "\n";
-			return;
+	bool is_lnk = ZO_VFS->is_symlink(pth_dir);
+	if(is_lnk && ! follw_symlk){
+		ZO_EVENT(info, "Symlink_ignored", pth_dir.c_str(), zo_log_qt::pquote);
+		return;
+	}
+	std::error_code ec;
+	zo_path apth = ZO_VFS->canonical(pth_dir, ec);
+	if(ec){
+		return;
+	}
+	long tot_rls = push_ignore_rules(apth);
+	read_canon_dir(apth, ft, only_with_ref);
+	for(long aa = 0; aa < tot_rls; aa++){
+		ignore_stk.pop();
+	}
+}
+
+long
+zo_orga::push_ignore_rules(const zo_string& apth){
+	long tot_rls = 0;
+	if(! root_rules.empty()){
+		ignore_stk.push(zo_ignore_rules{root_rules});
+		tot_rls++;
+	}
+	
+	zo_string dfrom = dir_from;
+	if(dfrom.empty() || (apth.rfind(dfrom, 0) != 0)){
+		return tot_rls;
+	}
+	bool at_sep = ((apth.size() == dfrom.size()) || (dfrom.back() == '/') || (apth[dfrom.size()] == '/'));
+	if(! at_sep){
+		return tot_rls;	// '/x/abc' is not under '/x/ab'
+	}
+	zo_path rel = apth.substr(dfrom.size());
+	zo_path dir = dfrom;
+	for(const auto& part : rel){
+		if(part == "/"){
+			continue;
+		}
+		zo_path ign_pth = dir / ZO_IGNORE_FNAM;
+		zo_ignore_rules rls;
+		rls.base_dir = dir;
+		if(rls.load(ign_pth) && ! rls.empty()){
+			ignore_stk.push(std::move(rls));
+			tot_rls++;
+		}
+		dir /= part;
+	}
+	return tot_rls;
+}
+
+void 
+zo_orga::read_canon_dir(const zo_string& pth_dir, const zo_ftype ft, const bool only_with_ref){
+	zo_dir_ent_vec all_ent;
+	zo_inode_key dir_key;
+	zo_scan_res sres = zo_scan_res::ok;
+	{
+		zo_trace_span spn("list_dir", "read", pth_dir);
+		ZO_MEM_SCOPE(dir_listing);
+		if(dir_snap.is_active()){
+			sres = dir_snap.scan_dir(pth_dir, all_ent, &all_visited_dir, &dir_key);
+		} else {
+			sres = ZO_VFS->scan_dir(pth_dir, all_ent, &all_visited_dir, &dir_key);
+		}
+	}
+	if(sres == zo_scan_res::visited){
+		ZO_EVENT(info, "ALREADY_VISITED_DIR", pth_dir.c_str(), zo_log_qt::dquote);
+		return;
+	}
+	ZO_EVENT(info, "ENTERING_DIR", pth_dir.c_str(), zo_log_qt::dquote);
+	if(sres != zo_scan_res::ok){
+		return;
+	}
+	
+	bool has_rls = false;
+	for(const auto& ent : all_ent){
+		if((ent.typ == zo_ent_type::regular) && (ent.name == ZO_IGNORE_FNAM)){
+			zo_ignore_rules rls;
+			rls.base_dir = pth_dir;
+			if(rls.load(zo_join_path(pth_dir, ent.name)) && ! rls.empty()){
+				ignore_stk.push(std::move(rls));
+				has_rls = true;
+			}
+			break;
 		}
-		pth_dir = fs::read_symlink(pth_dir);
 	}
-	std::cout << "ENTERING_DIR " << pth_dir << "\n";
-	if(fs::exists(pth_dir) && fs::is_directory(pth_dir)){
-		for (const auto& entry : fs::directory_iterator(pth_dir)){
-			zo_path pth = entry.path();
-			auto st = entry.status();
-			if(fs::is_directory(st)){
-				read_dir_files(entry, ft, only_with_ref);
-			} else if(fs::is_regular_file(st)){
+	bool ck_rls = ! ignore_stk.all_frames.empty();
+	if(pf_vfs != zo_null){
+		prefetch_accepted(pth_dir, all_ent, ck_rls);
+	}
+	
+	for(const auto& ent : all_ent){
+		if((pipe != zo_null) && pipe->stopped){
+			break;
+		}
+		zo_string pth = zo_join_path(pth_dir, ent.name);
+		bool is_dir = (ent.typ == zo_ent_type::directory);
+		if(ck_rls && ignore_stk.is_ignored(pth, ent.name, is_dir)){
+			ZO_EVENT(info, "IGNORING_BY_RULE", pth.c_str(), zo_log_qt::dquote);
+			continue;
+		}
+		if(is_dir){
+			if(! check_sub_dir(pth, ent)){
+				continue;
+			}
+			if(ent.is_lnk){
+				std::error_code ec;
+				zo_string apth = ZO_VFS->canonical(pth, ec);
+				if(! ec){
+					read_canon_dir(apth, ft, only_with_ref);
+				}
+				continue;
+			}
+			read_canon_dir(pth, ft, only_with_ref);
+		} else if(ent.typ == zo_ent_type::regular){
+			if(ent.is_lnk){
 				read_file(pth, ft, only_with_ref);
-			} 
+				continue;
+			}
+			zo_inode_key f_key;
+			f_key.dev = dir_key.dev;
+			f_key.ino = ent.ino;
+			read_canon_file(pth, ft, only_with_ref, has_sfz_ext(ent.name), f_key);
+		}
+	}
+	
+	if(has_rls){
+		ignore_stk.pop();
+	}
+}
+
+// --prefetch. Queues only the sub directories and sfz files the walk will enter or read.
+void
+zo_orga::prefetch_accepted(const zo_string& pth_dir, const zo_dir_ent_vec& all_ent, bool ck_rls){
+	for(const auto& ent : all_ent){
+		bool is_dir = (ent.typ == zo_ent_type::directory);
+		if(ent.is_lnk || (! is_dir && ((ent.typ != zo_ent_type::regular) || ! has_sfz_ext(ent.name)))){
+			continue;
+		}
+		if(is_hidden(ent.name) && ! hidden_too){
+			continue;
+		}
+		zo_string pth = zo_join_path(pth_dir, ent.name);
+		if((all_to_ignore.count(pth) > 0) || (ck_rls && ignore_stk.is_ignored(pth, ent.name, is_dir))){
+			continue;
+		}
+		if(is_dir){
+			pf_vfs->queue_list(pth);
+		} else {
+			pf_vfs->queue_read_sfz(pth);
 		}
 	}
 }
 
+bool
+zo_orga::check_sub_dir(const zo_string& pth, const zo_dir_ent& ent){
+	auto igt = all_to_ignore.find(pth);
+	if(igt != all_to_ignore.end()){
+		ZO_EVENT(info, "IGNORING", pth.c_str(), zo_log_qt::dquote);
+		return false;
+	}
+	if(is_hidden(ent.name) && ! hidden_too){
+		ZO_EVENT(info, "Hidden_directory_ignored", pth.c_str(), zo_log_qt::dquote);
+		return false;
+	}
+	if(ent.is_lnk && ! follw_symlk){
+		ZO_EVENT(info, "Symlink_ignored", pth.c_str(), zo_log_qt::dquote);
+		return false;
+	}
+	return true;
+}
+
 void 
 fill_files(const zo_path& pth_dir, zo_str_vec& names){
-	ZO_CK(fs::exists(pth_dir));
-	ZO_CK(fs::is_directory(pth_dir));
-	for (const auto& entry : fs::directory_iterator(pth_dir)){
-		zo_path pth = entry.path();
-		names.push_back(pth);
+	zo_dir_ent_vec all_ent;
+	zo_scan_res sres = ZO_VFS->scan_dir(pth_dir, all_ent);
+	ZO_CK(sres == zo_scan_res::ok);
+	for(const auto& ent : all_ent){
+		names.push_back(zo_join_path(pth_dir, ent.name));
 	}
 }
 
 void 
 zo_orga::read_files(const zo_str_vec& all_pth, const zo_ftype ft){
+	all_visited_dir.clear();
 	for(auto nm : all_pth){
 		zo_path f_pth = nm;
-		if(! fs::exists(f_pth)){
+		zo_vfs_stat st;
+		if(! ZO_VFS->stat(f_pth, st)){
 			continue;
 		}
-		if(fs::is_directory(f_pth)){
+		if(st.typ == zo_ent_type::directory){
 			if(! recursive){
 				continue;
 			}
 			read_dir_files(f_pth, ft, false);
-		} else if(fs::is_regular_file(f_pth)){
+		} else if(st.typ == zo_ent_type::regular){
 			read_file(f_pth, ft, false);
 		} 
 	}
 }
 
-void 
-zo_orga::read_selected(){
-	if(f_names.empty() && ! gave_names){
-		fill_files(dir_from, f_names);
+constexpr long ZO_FILES_FROM_CHUNK_SZ = 4096;
+constexpr long ZO_FILES_FROM_BUFF_SZ = 64 * 1024;
+constexpr long ZO_MAX_SUMMARY_EXAMPLES = 10;
+
+void
+zo_listed_summary::add_unsupported(long& counter, const zo_string& pth, const char* why){
+	counter++;
+	if((long)all_examples.size() < ZO_MAX_SUMMARY_EXAMPLES){
+		all_examples.push_back(zo_string(why) + " '" + pth + "'");
 	}
-	
+}
+
+void
+zo_listed_summary::print(FILE* out){
+	fprintf(out, "Files listed: %ld. Read: %ld. Not found: %ld. Directories skipped (no --recursive): %ld. Not regular files: %ld\n", 
+			tot_listed, tot_read, tot_not_found, tot_dirs_skipped, tot_not_regular);
+	for(const auto& ex : all_examples){
+		fprintf(out, "\t%s\n", ex.c_str());
+	}
+	long tot_bad = tot_not_found + tot_dirs_skipped + tot_not_regular;
+	if(tot_bad > (long)all_examples.size()){
+		fprintf(out, "\t... and %ld more\n", tot_bad - (long)all_examples.size());
+	}
+}
+
+void
+zo_listed_summary::print_json(){
+	ZO_LOGGER.json_begin(zo_log_lev::info, "FILES_FROM_SUMMARY");
+	ZO_LOGGER.json_field("listed", tot_listed);
+	ZO_LOGGER.json_field("read", tot_read);
+	ZO_LOGGER.json_field("not_found", tot_not_found);
+	ZO_LOGGER.json_field("dirs_skipped", tot_dirs_skipped);
+	ZO_LOGGER.json_field("not_regular", tot_not_regular);
+	ZO_LOGGER.json_end();
+}
+
+void 
+zo_orga::read_listed_files(const zo_str_vec& all_pth, zo_listed_summary& summ){
 	bool adding_ext = (oper == zo_action::add_sfz);
-	if(! only_sfz && ! adding_ext){
-		read_files(f_names, zo_ftype::sample);
+	bool do_spl = (! only_sfz && ! adding_ext);
+	bool do_sfz = ! only_samples;
+	for(const auto& nm : all_pth){
+		summ.tot_listed++;
+		zo_path f_pth = nm;
+		zo_vfs_stat st;
+		if(! ZO_VFS->stat(f_pth, st)){
+			summ.add_unsupported(summ.tot_not_found, nm, "NOT_FOUND");
+			continue;
+		}
+		if(st.typ == zo_ent_type::directory){
+			if(! recursive){
+				summ.add_unsupported(summ.tot_dirs_skipped, nm, "DIRECTORY");
+				continue;
+			}
+			if(do_spl){
+				all_visited_dir.clear();
+				read_dir_files(f_pth, zo_ftype::sample, false);
+			}
+			if(do_sfz){
+				all_visited_dir.clear();
+				read_dir_files(f_pth, zo_ftype::soundfont, false);
+			}
+			summ.tot_read++;
+			continue;
+		} 
+		if(st.typ != zo_ent_type::regular){
+			summ.add_unsupported(summ.tot_not_regular, nm, "NOT_REGULAR");
+			continue;
+		}
+		if(do_spl){
+			read_file(f_pth, zo_ftype::sample, false);
+		}
+		if(do_sfz){
+			read_file(f_pth, zo_ftype::soundfont, false);
+		}
+		summ.tot_read++;
+	}
+}
+
+void 
+zo_orga::read_files_from(const zo_string& f_nam){
+	bool is_stdin = (f_nam == "-");
+	FILE* in_fl = (is_stdin)?(stdin):(fopen(f_nam.c_str(), "rb"));
+	if(in_fl == zo_null){
+		ZO_MSG(error, "Cannot open file:'%s'\n", f_nam.c_str());
+		std::cerr << "Error: " << strerror(errno) << "\n\n";
+		exit(0);
 	}
 	
-	if(! only_samples){
-		read_files(f_names, zo_ftype::soundfont);
+	zo_listed_summary summ;
+	zo_str_vec chunk;
+	chunk.reserve(ZO_FILES_FROM_CHUNK_SZ);
+	std::vector<char> buff(ZO_FILES_FROM_BUFF_SZ);
+	zo_string curr = "";
+	char sep = 0;
+	bool has_sep = false;
+	for(;;){
+		size_t tot_rd = fread(buff.data(), 1, buff.size(), in_fl);
+		if(tot_rd == 0){
+			break;
+		}
+		if(! has_sep){
+			has_sep = true;
+			bool has_nul = (memchr(buff.data(), '\0', tot_rd) != zo_null);
+			sep = (has_nul)?('\0'):('\n');
+		}
+		const char* pt = buff.data();
+		const char* end = pt + tot_rd;
+		while(pt < end){
+			const char* nx = (const char*)memchr(pt, sep, end - pt);
+			if(nx == zo_null){
+				curr.append(pt, end - pt);
+				break;
+			}
+			curr.append(pt, nx - pt);
+			pt = nx + 1;
+			if(! curr.empty()){
+				chunk.push_back(std::move(curr));
+			}
+			curr.clear();
+			if((long)chunk.size() >= ZO_FILES_FROM_CHUNK_SZ){
+				read_listed_files(chunk, summ);
+				chunk.clear();
+			}
+		}
+	}
+	if(! curr.empty()){
+		chunk.push_back(curr);
+	}
+	read_listed_files(chunk, summ);
+	if(! is_stdin){
+		fclose(in_fl);
+	}
+	if(ZO_LOGGER.ndjson){
+		summ.print_json();
+	} else {
+		summ.print(ZO_LOGGER.out);
+	}
+}
+
+void 
+zo_orga::read_selected(){
+	if(! files_from.empty()){
+		read_files_from(files_from);
+	} else {
+		read_given_names();
 	}
 	
+	bool adding_ext = (oper == zo_action::add_sfz);
 	if(adding_ext){
 		return;
 	}
 	
 	long tot_spl = (long)all_selected_spl.size();
-	fprintf(stdout, "tot_selected_samples = %ld\n", tot_spl);
+	if(strm != zo_null){
+		tot_spl = strm->spl_w.tot_rec;
+	}
+	ZO_MSG(info, "tot_selected_samples = %ld\n", tot_spl);
 	
 	bool is_cp = (oper == zo_action::copy);
 	if(! is_cp && (tot_spl > 0)){
 		ZO_CK(! base_pth.empty());
+		all_visited_dir.clear();
 		read_dir_files(base_pth, zo_ftype::soundfont, true);
 	}
 }
 
+// read_selected, then --prefetch stops queueing. Lookups after the scan are done by the caller, still cached.
+void 
+zo_orga::scan_selected(){
+	read_selected();
+	if(pf_vfs != zo_null){
+		pf_vfs->stop();
+	}
+}
+
+void 
+zo_orga::read_given_names(){
+	if(f_names.empty() && ! gave_names){
+		fill_files(dir_from, f_names);
+	}
+	
+	bool adding_ext = (oper == zo_action::add_sfz);
+	if(! only_sfz && ! adding_ext){
+		read_files(f_names, zo_ftype::sample);
+	}
+	
+	if(! only_samples){
+		read_files(f_names, zo_ftype::soundfont);
+	}
+}
+
 int test_fs(int argc, char* argv[]){
 	//fs::path pth1 = fs::path("/home/jose/Video");
 	fs::path pth1 = fs::current_path();
@@ -602,14 +993,16 @@ int test_rx(int argc, char* argv[]){
 	} else {
 		fl->get_opcodes(org);
 	}
-	for(zo_ref_pt ii : fl->all_ref){ 
-		zo_path orig = ii->get_orig();
+	for(long aa = 0; aa < fl->all_ref.size(); aa++){ 
+		zo_ref ii{fl, aa};
+		zo_path orig = ii.get_orig();
 		//ZO_CK(orig.is_absolute());
 		//zo_path cano = fs::canonical(orig);
 		fprintf(stdout, "=======================\n\tpfx:'%s'\n\torg:'%s'\n\torel:'%s'\n\tsfx:'%s'\n", 
-				ii->prefix.c_str(), ii->get_orig().c_str(), ii->get_orig_rel().c_str(), ii->suffix.c_str()); 
-		if(ii->ctrl != zo_null){
-			zo_control_path_pt ctl = ii->ctrl;
+				zo_string(ii.prefix()).c_str(), ii.get_orig().c_str(), ii.get_orig_rel().c_str(), 
+				zo_string(ii.suffix()).c_str()); 
+		if(ii.ctrl() != zo_null){
+			zo_control_path_pt ctl = ii.ctrl();
 			fprintf(stdout, "\t-------default_path:\n\tdpfx:'%s'\n\tdpth:'%s'\n\tdsfx:'%s'\n", 
 				ctl->prefix.c_str(), ctl->def_path.c_str(), ctl->suffix.c_str()); 
 		}
@@ -662,6 +1055,7 @@ The purpose of %s is to move and copy sfz soundfonts while preserving consistenc
 		Use --match and --substitute toghether with --move if more control is desired.  
 	-i --ignore <file>  
 		Do not select this file or anything under it if it is a directory.  
+		If <file> does not exist it is used as a gitignore style pattern (see note 13).  
 	-d --hidden  
 		Read also hidden files.  
 		Any file or directory name that starts with '.' is considdered hidden and by default it is not read.  
@@ -677,6 +1071,7 @@ The purpose of %s is to move and copy sfz soundfonts while preserving consistenc
 		Copy samples too.  
 		In a  --copy, if the --to directory is under of the --from directory copy the samples too. By default it will only change the references in
 		copied sfz soundfonts to the existing samples (to keep reference consistency).  
+		Copied samples that are hardlinks of an already copied sample are hardlinked in the destination instead of copied again.  
 	-K --keep  
 		keep the destination file when it already exists.  
 	-P --replace  
@@ -701,12 +1096,93 @@ The purpose of %s is to move and copy sfz soundfonts while preserving consistenc
 		Only select files with '.sfz' extension.   
 	-L --follow_symlinks  
 		Follow symlinks when reading directories.  
+		Each physical directory is read only once, so symlink cycles are not followed again.  
 	-F --force_action  
 		Execute action solving all conflicts with different names.  
 	--only_samples  
 		Only select files without '.sfz' extension.   
 	--skip_normalize  
 		Do not normalize names. Not recomended because it deactivates conflict solving.  
+	--files-from <file>  
+		Select the files (and directories with --recursive) listed in <file> instead of the [FILE] ... portion of the command line.  
+		Paths are separated by new lines, or by NUL characters when the file has any. Use '-' to read them from standard input.  
+		Listed paths that do not exist or cannot be selected are reported in a summary at the end of reading.  
+	--snapshot <file>  
+		Keep directory listings in <file> between runs.  
+		A directory whose path, mtime and link count did not change since the last run is not listed again.  
+		Directories modified too close to the last run (or with coarse timestamps) are always listed again.  
+	--stats <file>  
+		Write a JSON report to <file> with wall and cpu time per phase, counters (files scanned, sfz parsed, references, conflicts, bytes)  
+		and syscalls by kind. Also accepted as --stats=<file>.  
+	--trace <file>  
+		Write a Chrome / Perfetto trace-event JSON to <file> with a span for each phase, directory listing, parsed sfz,  
+		written sfz and copied or moved sample. Also accepted as --trace=<file>.  
+	-q --quiet  
+		Only print errors, the actions listed with --list and the actions that could not be done as asked.  
+	-v --verbose  
+		Print also debug messages.  
+	--log_format <text|ndjson>  
+		Format of printed events and actions. 'ndjson' prints one JSON object per line (fields "lvl", "evt", "path", ...).  
+		Also accepted as --log_format=<format>.  
+	--mem_stats  
+		Count allocations, bytes and peak live memory per phase and per object type. Reported in the --stats file.  
+	--progress  
+		Show a status line on stderr (only when it is a terminal) with files done/total, MB written, rate and ETA.  
+	--metrics <file>  
+		Rewrite <file> atomically with Prometheus text format metrics (counters, phase, rate, ETA) while running.  
+		Also accepted as --metrics=<file>.  
+	--metrics_interval <seconds>  
+		Seconds between rewrites of the --metrics file. Default 10.  
+	--vfs_memory <dir>  
+		Load the tree under <dir> into memory and run there. Nothing is written to disk. Files over 64KB that are not sfz  
+		keep only their first 4KB, and copies of them count only those bytes in --stats. Symlinks are skipped. For  
+		reproducible benchmarks. Also accepted as --vfs_memory=<dir>.  
+	--vfs_latency <spec>  
+		Add a delay to each filesystem call, to emulate NFS or SMB. <spec> is microseconds for all calls or a comma  
+		separated list of <kind>=<microseconds> with the syscall kinds of --stats (e.g. stat=300,open=500,getdents64=800).  
+		Also accepted as --vfs_latency=<spec>.  
+	--prefetch <threads>  
+		Look up file metadata (directory listings, sfz files and the canonical path of each referenced sample) with  
+		<threads> threads ahead of the scan, so high latency mounts (NFS) are bound by concurrency instead of round  
+		trips. Also accepted as --prefetch=<threads>.  
+	--io_uring <depth>  
+		Read sfz files and copy samples with io_uring, keeping up to <depth> chunk reads and writes in flight (for NVMe  
+		arrays). Falls back to blocking I/O when the kernel has no io_uring. Also accepted as --io_uring=<depth>.  
+	--pipeline <threads>  
+		Only for --copy and --add_sfz_ext, without --files-from. Parse, plan and do the actions while the directories  
+		are still being read, with <threads> parser threads and <threads> threads doing actions. Stops at the first  
+		name conflict (actions already done are kept) unless --force_action is given, in which case '_cN' suffixes  
+		follow the order files were found and may differ from a run without --pipeline. With --list, each action is printed as soon as its  
+		file is planned (in the order files are found, flushed at least every 0.2 seconds), so the first lines do not  
+		wait for the whole library. All conflicts are listed, with '_cN' names in the order files were found. With  
+		--files-from the actions are printed after planning all the files, as without --pipeline.  
+		Also accepted as --pipeline=<threads>.  
+	--plan_threads <threads>  
+		Find the next name of the selected files with <threads> threads. Conflicts are still solved in the same order,  
+		so the '_cN' names do not change. Also accepted as --plan_threads=<threads>.  
+	--max_memory <megabytes>  
+		Only for --purge. Keep about <megabytes> of file names in memory. The rest is written to sorted run files in  
+		the temp directory (TMPDIR) and merged to plan and purge in batches, so libraries larger than RAM can be  
+		purged. The sfz files are read once. Also accepted as --max_memory=<megabytes>.  
+	--external_conflicts  
+		Find name conflicts by sorting hashes of the next names in run files of the temp directory (TMPDIR) instead of  
+		keeping every next name in memory. Only names that may conflict are kept. The '_cN' names do not change. Run  
+		files take about 64 megabytes of memory, or 1/8 of --max_memory when it is given. Not used by --purge with  
+		--max_memory, which plans in batches.  
+	--actions <action>,<action>,...  
+		Do several actions in the given order reading the files only once. Actions are add_sfz_ext, purge, normalize  
+		and copy (to the --to directory). Each action sees the names and references left by the ones before.  
+		Works on the whole --from directory (as if --recursive and no files were selected). Stops at the first action  
+		with conflicts unless --force_action is given. Copies are not seen by later actions, so copy must be last.  
+		Also accepted as --actions=<action>,<action>,...  
+	--save-plan <file>  
+		List the actions (as --list) and save them in <file>: each file to move or copy with its size and mtime,  
+		and the new text of each sfz line to rewrite. Not saved when there are conflicts, unless --force_action is  
+		given. Does not work with --actions. Also accepted as --save-plan=<file>.  
+	--apply-plan <file>  
+		Do the actions saved by --save-plan without reading the directories. Only the files of the plan are checked.  
+		If any of them is missing or its size or mtime changed, nothing is done. Give no action option, the one of the  
+		plan is used. With --list only prints them. Also accepted as --apply-plan=<file>.  
 	--help   
 	--version   
 
@@ -749,12 +1225,16 @@ The purpose of %s is to move and copy sfz soundfonts while preserving consistenc
   
 9. The default policy is --keep.  
   
-10. If more than one action (--move, --copy, --purge, --add_sfz_ext, --normalize) is given, only the last one will be executed.  
+10. If more than one action (--move, --copy, --purge, --add_sfz_ext, --normalize) is given, only the last one will be executed. Use --actions to do several.  
   
 11. The most common error is: 'Cannot open file ...' because of lack of permissions. Give the user write permissions.  
   
 12. The name "purged" is reserved. A subdirectory under --from called "purged" is always ignored.  
   
+13. A '.sfzignore' file in any directory has gitignore style rules for files and directories under it.  
+	'#' starts a comment, '!' negates, a trailing '/' matches only directories and a rule with a '/' is relative to the '.sfzignore' directory.  
+	'*', '?', '[...]' and '**' work as in gitignore. Rules in deeper directories take precedence. Ignored directories are never read.  
+  
 
 ## Examples:  
 ============  
@@ -793,15 +1273,170 @@ directory '../per2' is attempted.
 void
 zo_orga::ignore_purged_dir(){
 	zo_path pth = "purged";
-	if(fs::exists(pth)){
+	if(ZO_VFS->exists(pth)){
 		std::error_code ec;
-		auto apth = zo_path{fs::canonical(pth, ec)};
+		auto apth = zo_path{ZO_VFS->canonical(pth, ec)};
 		if(! ec){
 			all_to_ignore.insert(apth);
 		}
 	}
 }
 
+bool
+get_opt_eq(const zo_string& ar, const zo_string& opt_eq, zo_string& val){
+	if(ar.compare(0, opt_eq.size(), opt_eq) != 0){
+		return false;
+	}
+	val = ar.substr(opt_eq.size());
+	return true;
+}
+
+// the actions of --actions, by the name of their option.
+static
+bool
+get_action_list(const zo_string& str, std::vector<zo_action>& all_ac){
+	const zo_action all_ok[] = { zo_action::add_sfz, zo_action::purge, zo_action::normalize, zo_action::copy };
+	all_ac.clear();
+	std::size_t pos = 0;
+	while(pos <= str.size()){
+		std::size_t end = str.find(',', pos);
+		if(end == std::string::npos){
+			end = str.size();
+		}
+		zo_string nm = str.substr(pos, end - pos);
+		pos = end + 1;
+		bool found = false;
+		for(zo_action ac : all_ok){
+			zo_string ac_nm = (ac == zo_action::add_sfz)?("add_sfz_ext"):(get_action_str(ac));
+			if(nm == ac_nm){
+				all_ac.push_back(ac);
+				found = true;
+				break;
+			}
+		}
+		if(! found){
+			return false;
+		}
+	}
+	return ! all_ac.empty();
+}
+
+// options of get_args whose value is the next argument, so get_log_args and get_vfs_args 
+// do not take a value like '-t -q' for an option.
+static
+bool
+takes_value(const zo_string& ar){
+	const char* all_opt[] = {
+		"-i", "--ignore", "-f", "--from", "-t", "--to", "-E", "--regex", "-M", "--match", "-S", "--substitute", 
+		"--files-from", "--snapshot", "--stats", "--trace", "--pipeline", "--plan_threads", "--actions", 
+		"--save-plan", "--apply-plan", "--max_memory", "--log_format", "--vfs_memory", "--vfs_latency", 
+		"--prefetch", "--io_uring", "--metrics", "--metrics_interval"
+	};
+	for(const char* op : all_opt){
+		if(ar == op){
+			return true;
+		}
+	}
+	return false;
+}
+
+void
+zo_orga::get_log_args(const zo_str_vec& args){
+	zo_string fmt = "text";
+	for(auto it = args.begin(); it != args.end(); it++){
+		const zo_string& ar = *it;
+		bool has_val = ((it + 1) != args.end());
+		if((ar == "-q") || (ar == "--quiet")){
+			ZO_LOGGER.level = zo_log_lev::plan;
+		}
+		else if((ar == "-v") || (ar == "--verbose")){
+			ZO_LOGGER.level = zo_log_lev::debug;
+		}
+		else if(ar == "--log_format"){
+			if(has_val){ fmt = *(it + 1); it++; }
+		}
+		else if(! get_opt_eq(ar, "--log_format=", fmt) && takes_value(ar) && has_val){
+			it++;
+		}
+	}
+	ZO_LOGGER.ndjson = (fmt == "ndjson");
+	ZO_LOGGER.init();
+}
+
+bool
+zo_orga::get_vfs_args(const zo_str_vec& args){
+	zo_string mem_dir = "";
+	zo_string lat_spec = "";
+	zo_string pf_thds = "";
+	zo_string ur_dpth = "";
+	for(auto it = args.begin(); it != args.end(); it++){
+		const zo_string& ar = *it;
+		bool has_val = ((it + 1) != args.end());
+		if(ar == "--vfs_memory"){
+			if(has_val){ mem_dir = *(it + 1); it++; }
+		}
+		else if(ar == "--vfs_latency"){
+			if(has_val){ lat_spec = *(it + 1); it++; }
+		}
+		else if(ar == "--prefetch"){
+			if(has_val){ pf_thds = *(it + 1); it++; }
+		}
+		else if(ar == "--io_uring"){
+			if(has_val){ ur_dpth = *(it + 1); it++; }
+		}
+		else if(! get_opt_eq(ar, "--vfs_memory=", mem_dir) && ! get_opt_eq(ar, "--vfs_latency=", lat_spec) &&
+				! get_opt_eq(ar, "--prefetch=", pf_thds) && ! get_opt_eq(ar, "--io_uring=", ur_dpth))
+		{
+			if(takes_value(ar) && has_val){ it++; }
+		}
+	}
+	if(! ur_dpth.empty()){
+		long dpth = atol(ur_dpth.c_str());
+		zo_string why = "";
+		if(dpth <= 0){
+			fprintf(stderr, "option --io_uring needs a queue depth\n");
+			return false;
+		}
+		if(! mem_dir.empty()){
+			fprintf(stderr, "option --io_uring ignored with --vfs_memory\n");
+		} else if(! zo_uring_supported(why)){
+			fprintf(stderr, "io_uring not available (%s). Using blocking I/O\n", why.c_str());
+		} else {
+			ZO_MSG(info, "Using io_uring with queue depth %ld\n", dpth);
+			ZO_VFS = new zo_uring_vfs(dpth);
+		}
+	}
+	if(! mem_dir.empty()){
+		zo_mem_vfs* mem_vfs = new zo_mem_vfs();
+		if(! mem_vfs->load_tree(mem_dir)){
+			fprintf(stderr, "directory %s given in option --vfs_memory cannot be loaded\n", mem_dir.c_str());
+			return false;
+		}
+		ZO_MSG(info, "Using in-memory filesystem with %ld files from '%s'\n", mem_vfs->tot_loaded, mem_dir.c_str());
+		ZO_VFS = mem_vfs;
+	}
+	if(! lat_spec.empty()){
+		zo_latency_vfs* lat_vfs = new zo_latency_vfs(ZO_VFS);
+		if(! lat_vfs->set_latency(lat_spec)){
+			return false;
+		}
+		ZO_MSG(info, "Using filesystem latency '%s'\n", lat_spec.c_str());
+		ZO_VFS = lat_vfs;
+	}
+	if(! pf_thds.empty()){
+		long tot_thd = atol(pf_thds.c_str());
+		if(tot_thd <= 0){
+			fprintf(stderr, "option --prefetch needs a number of threads\n");
+			return false;
+		}
+		pf_vfs = new zo_prefetch_vfs(ZO_VFS, tot_thd);
+		pf_vfs->ref_paths_fn = zo_get_ref_paths;
+		ZO_MSG(info, "Prefetching metadata with %ld threads\n", tot_thd);
+		ZO_VFS = pf_vfs;
+	}
+	return true;
+}
+
 bool
 zo_orga::get_args(const zo_str_vec& args){
 	ZO_CK(! args.empty());
@@ -811,16 +1446,26 @@ zo_orga::get_args(const zo_str_vec& args){
 		return false;
 	}
 	
+	get_log_args(args);
+	if(! get_vfs_args(args)){
+		return false;
+	}
+	
 	ignore_purged_dir();
 	
 	last_pth = "";
 	gave_names = false;
 	
+	zo_string snap_nam = "";
+	zo_string pipe_str = "";
+	zo_string plan_str = "";
+	zo_string mem_str = "";
+	zo_string acts_str = "";
 	bool is_fst = true;
 	auto it = args.begin();
 	for(; it != args.end(); it++){
 		auto ar = *it;
-		fprintf(stdout, ">'%s'\n", ar.c_str());
+		ZO_MSG(info, ">'%s'\n", ar.c_str());
 		if(is_fst){
 			is_fst = false;
 			continue;
@@ -847,12 +1492,14 @@ zo_orga::get_args(const zo_str_vec& args){
 		else if((ar == "-i") || (ar == "--ignore")){
 			it++; if(it == args.end()){ break; }
 			zo_path pth = *it;
-			if(fs::exists(pth)){
+			if(ZO_VFS->exists(pth)){
 				std::error_code ec;
-				auto apth = zo_path{fs::canonical(pth, ec)};
+				auto apth = zo_path{ZO_VFS->canonical(pth, ec)};
 				if(! ec){
 					all_to_ignore.insert(apth);
 				}
+			} else {
+				root_rules.add_rule(pth);
 			}
 		}
 		else if((ar == "-f") || (ar == "--from")){
@@ -906,32 +1553,198 @@ zo_orga::get_args(const zo_str_vec& args){
 		else if(ar == "--skip_normalize"){
 			skip_normalize = true;
 		}
-		else if(ar == "--old"){
-			do_old = true;
+		else if(ar == "--files-from"){
+			it++; if(it == args.end()){ break; }
+			files_from = *it;
 		}
-		else if(ar == "--help"){
-			print_help(args);
-			return false;
+		else if(ar == "--snapshot"){
+			it++; if(it == args.end()){ break; }
+			snap_nam = *it;
 		}
-		else if(ar == "--version"){
-			print_version(args);
-			return false;
+		else if((ar == "--stats") || get_opt_eq(ar, "--stats=", stats_nam)){
+			if(ar == "--stats"){
+				it++; if(it == args.end()){ break; }
+				stats_nam = *it;
+			}
+		}
+		else if((ar == "--trace") || get_opt_eq(ar, "--trace=", trace_nam)){
+			if(ar == "--trace"){
+				it++; if(it == args.end()){ break; }
+				trace_nam = *it;
+			}
+		}
+		else if((ar == "--pipeline") || get_opt_eq(ar, "--pipeline=", pipe_str)){
+			if(ar == "--pipeline"){
+				it++; if(it == args.end()){ break; }
+				pipe_str = *it;
+			}
+		}
+		else if((ar == "--plan_threads") || get_opt_eq(ar, "--plan_threads=", plan_str)){
+			if(ar == "--plan_threads"){
+				it++; if(it == args.end()){ break; }
+				plan_str = *it;
+			}
+		}
+		else if((ar == "--actions") || get_opt_eq(ar, "--actions=", acts_str)){
+			if(ar == "--actions"){
+				it++; if(it == args.end()){ break; }
+				acts_str = *it;
+			}
+		}
+		else if((ar == "--save-plan") || get_opt_eq(ar, "--save-plan=", save_nam)){
+			if(ar == "--save-plan"){
+				it++; if(it == args.end()){ break; }
+				save_nam = *it;
+			}
+		}
+		else if((ar == "--apply-plan") || get_opt_eq(ar, "--apply-plan=", apply_nam)){
+			if(ar == "--apply-plan"){
+				it++; if(it == args.end()){ break; }
+				apply_nam = *it;
+			}
+		}
+		else if(ar == "--external_conflicts"){
+			ext_confl = true;
+		}
+		else if((ar == "--max_memory") || get_opt_eq(ar, "--max_memory=", mem_str)){
+			if(ar == "--max_memory"){
+				it++; if(it == args.end()){ break; }
+				mem_str = *it;
+			}
+		}
+		else if((ar == "-q") || (ar == "--quiet") || (ar == "-v") || (ar == "--verbose")){
+			// read by get_log_args
+		}
+		else if((ar == "--log_format") || (ar.compare(0, 13, "--log_format=") == 0)){
+			// read by get_log_args
+			if(ar == "--log_format"){
+				it++; if(it == args.end()){ break; }
+			}
+		}
+		else if((ar == "--vfs_memory") || (ar == "--vfs_latency") || (ar == "--prefetch") || (ar == "--io_uring")){
+			// read by get_vfs_args
+			it++; if(it == args.end()){ break; }
+		}
+		else if((ar.compare(0, 13, "--vfs_memory=") == 0) || (ar.compare(0, 14, "--vfs_latency=") == 0) || 
+				(ar.compare(0, 11, "--prefetch=") == 0) || (ar.compare(0, 11, "--io_uring=") == 0))
+		{
+			// read by get_vfs_args
+		}
+		else if(ar == "--mem_stats"){
+			ZO_MEM.is_on = true;
+		}
+		else if(ar == "--progress"){
+			ZO_PROGRESS.show_line = true;
+		}
+		else if((ar == "--metrics") || get_opt_eq(ar, "--metrics=", ZO_PROGRESS.metrics_nam)){
+			if(ar == "--metrics"){
+				it++; if(it == args.end()){ break; }
+				ZO_PROGRESS.metrics_nam = *it;
+			}
+		}
+		else if(ar == "--metrics_interval"){
+			it++; if(it == args.end()){ break; }
+			ZO_PROGRESS.metrics_secs = atol((*it).c_str());
+		}
+		else if(ar == "--old"){
+			do_old = true;
+		}
+		else if(ar == "--help"){
+			print_help(args);
+			return false;
+		}
+		else if(ar == "--version"){
+			print_version(args);
+			return false;
 		}
 		else{
-			fprintf(stdout, ":'%s'\n", ar.c_str());
+			ZO_MSG(info, ":'%s'\n", ar.c_str());
 			last_pth = ar;
-			if(fs::exists(last_pth)){
+			if(ZO_VFS->exists(last_pth)){
 				f_names.push_back(last_pth);
 			}
 			gave_names = true;
 		}
 	}
 	
+	if(! pipe_str.empty()){
+		pipe_thds = atol(pipe_str.c_str());
+		if(pipe_thds <= 0){
+			fprintf(stderr, "option --pipeline needs a number of threads\n");
+			return false;
+		}
+	}
+	
+	if(! plan_str.empty()){
+		plan_thds = atol(plan_str.c_str());
+		if(plan_thds <= 0){
+			fprintf(stderr, "option --plan_threads needs a number of threads\n");
+			return false;
+		}
+	}
+	
+	if(! mem_str.empty()){
+		max_mem = atol(mem_str.c_str()) * 1024 * 1024;
+		if(max_mem <= 0){
+			fprintf(stderr, "option --max_memory needs a number of megabytes\n");
+			return false;
+		}
+	}
+	
+	if(! acts_str.empty()){
+		if(! get_action_list(acts_str, all_step)){
+			fprintf(stderr, "option --actions needs a comma separated list of add_sfz_ext, purge, normalize and copy\n");
+			return false;
+		}
+		auto cp_it = std::find(all_step.begin(), all_step.end(), zo_action::copy);
+		if((cp_it != all_step.end()) && ((cp_it + 1) != all_step.end())){
+			fprintf(stderr, "option --actions needs copy as the last action. Later actions would not see the copies\n");
+			return false;
+		}
+		oper = zo_action::normalize;	// selects the files for all steps
+		if(! f_names.empty() || ! files_from.empty()){
+			ZO_MSG(info, "Ignoring selected files. --actions works on the whole --from directory\n");
+			f_names.clear();
+			files_from = "";
+		}
+		if(pipe_thds > 0){
+			ZO_MSG(info, "Ignoring --pipeline. --actions plans each action with all the files\n");
+			pipe_thds = 0;
+		}
+		recursive = true;
+	}
 	if(oper == zo_action::purge){
 		f_names.clear();
+		if(! files_from.empty()){
+			ZO_MSG(info, "Ignoring --files-from. Purge works on the whole --from directory\n");
+			files_from = "";
+		}
 		recursive = true;
 	}
-	if(oper == zo_action::nothing){
+	if(ext_confl && (max_mem > 0) && (oper == zo_action::purge)){
+		ZO_MSG(info, "Ignoring --external_conflicts. --max_memory purge plans in batches, each with the names before\n");
+		ext_confl = false;
+	}
+	if((max_mem > 0) && (oper != zo_action::purge) && ! ext_confl){
+		ZO_MSG(info, "Ignoring --max_memory. Only --purge and --external_conflicts use it\n");
+		max_mem = 0;
+	}
+	if(! save_nam.empty()){
+		if(! all_step.empty() || ! apply_nam.empty()){
+			fprintf(stderr, "option --save-plan does not work with --actions or --apply-plan\n");
+			return false;
+		}
+		if(max_mem > 0){
+			ZO_MSG(info, "Ignoring --max_memory. --save-plan keeps the whole plan in memory\n");
+			max_mem = 0;
+		}
+		just_list = true;
+	}
+	if(! apply_nam.empty() && (oper != zo_action::nothing)){
+		fprintf(stderr, "option --apply-plan does the action saved in the plan. Do not give one\n");
+		return false;
+	}
+	if((oper == zo_action::nothing) && apply_nam.empty()){
 		just_list = true;
 	}
 	
@@ -946,72 +1759,89 @@ zo_orga::get_args(const zo_str_vec& args){
 	if(oper == zo_action::copy){
 		bool ok = calc_target(had_dir_to);
 		if(! ok){
-			fprintf(stdout, "Invalid target\n");
+			ZO_MSG(error, "Invalid target\n");
 			return false;
 		}
 	}
 	if(oper == zo_action::move){
 		bool ok = calc_target(had_dir_to);
 		if(! ok){
-			fprintf(stdout, "Invalid target\n");
+			ZO_MSG(error, "Invalid target\n");
 			return false;
 		}
 	}
 	
-	if(! fs::exists(dir_from)){
+	if(! ZO_VFS->exists(dir_from)){
 		fprintf(stderr, "directory %s given in option --from does not exist\n", dir_from.c_str());
 		return false;
 	}
-	if(! fs::exists(dir_to)){
+	if(! ZO_VFS->exists(dir_to)){
 		fprintf(stderr, "directory %s given in option --to does not exist\n", dir_to.c_str());
 		return false;
 	}
-	dir_from = fs::canonical(dir_from);
-	dir_to = fs::canonical(dir_to);
+	std::error_code ec;
+	dir_from = ZO_VFS->canonical(dir_from, ec);
+	dir_to = ZO_VFS->canonical(dir_to, ec);
 	
-	fprintf(stdout, "Using dir from '%s'\n", dir_from.c_str());
-	fprintf(stdout, "Using dir to '%s'\n", dir_to.c_str());
+	ZO_MSG(info, "Using dir from '%s'\n", dir_from.c_str());
+	ZO_MSG(info, "Using dir to '%s'\n", dir_to.c_str());
 	
 	base_pth = dir_from;
+	root_rules.base_dir = dir_from;
 	tmp_pth = base_pth / tmp_nam;
-	fs::create_directories(tmp_pth.parent_path());
-	fprintf(stdout, "Using temp file path '%s'\n", tmp_pth.c_str());
-	fprintf(stdout, "Using target name '%s'\n", target.c_str());
+	ZO_VFS->create_directories(tmp_pth.parent_path());
+	ZO_MSG(info, "Using temp file path '%s'\n", tmp_pth.c_str());
+	ZO_MSG(info, "Using target name '%s'\n", target.c_str());
+	
+	if(! snap_nam.empty()){
+		zo_path snap_pth = fs::absolute(snap_nam);
+		dir_snap.load(snap_pth);
+		ZO_MSG(info, "Using snapshot '%s' with %ld directories\n", snap_pth.c_str(), (long)dir_snap.all_old.size());
+	}
+	if(! trace_nam.empty()){
+		ZO_TRACE.start(trace_nam);
+	}
+	ZO_PROGRESS.start();
 	
 	if(! regex_str.empty()){
+		ZO_MEM_SCOPE(regex);
 		select_rx = regex_str;
-		fprintf(stdout, "Using regex_str '%s'\n", regex_str.c_str());
+		ZO_MSG(info, "Using regex_str '%s'\n", regex_str.c_str());
 	}
 	
 	if(has_subst){
+		ZO_MEM_SCOPE(regex);
 		match_rx = match_str;
-		fprintf(stdout, "Using match_str '%s'\n", match_str.c_str());
-		fprintf(stdout, "Using subst_str '%s'\n", subst_str.c_str());
+		ZO_MSG(info, "Using match_str '%s'\n", match_str.c_str());
+		ZO_MSG(info, "Using subst_str '%s'\n", subst_str.c_str());
 	}
 	
 	zo_string dto = dir_to;
 	bool is_under = (dto.rfind(dir_from, 0) == 0);
 	if(! is_under && (oper == zo_action::move)){
-		fprintf(stdout, "Dir 'to' is not under dir 'from' CHANGING action to copy\n");
+		ZO_MSG(info, "Dir 'to' is not under dir 'from' CHANGING action to copy\n");
 		oper = zo_action::copy;
 	}
 	if(oper == zo_action::copy){
 		samples_too = samples_too || ! is_under;
 	}
 
-	fprintf(stdout, "Using target %s\n", target.c_str());
+	ZO_MSG(info, "Using target %s\n", target.c_str());
 	if(samples_too){
-		fprintf(stdout, "Copying samples_too\n");
+		ZO_MSG(info, "Copying samples_too\n");
 	}
 	if(gave_names){
-		fprintf(stdout, "gave_names\n");
+		ZO_MSG(info, "gave_names\n");
 	}
 	
 	zo_string ac_str = get_action_str(oper);
+	if(! all_step.empty()){
+		ac_str = acts_str;
+	}
 	if(just_list){
-		fprintf(stdout, "simulating action: %s\n", ac_str.c_str());
+		ZO_MSG(info, "simulating action: %s\n", ac_str.c_str());
 	} else {
-		fprintf(stdout, "executing action: %s\n", ac_str.c_str());
+		ZO_MSG(info, "executing action: %s\n", ac_str.c_str());
 	}
 	
 	return true;
@@ -1022,63 +1852,129 @@ zo_fname::print_actions(zo_orga& org, bool only_orig){
 	bool purging = (org.oper == zo_action::purge);
 	if(nxt_pth.empty()){
 		if(! purging){
-			fprintf(stdout, "SKIP '%s'\n", orig_pth.c_str());
+			ZO_EVENT(plan, "SKIP", orig_pth.c_str());
 		}
 		return;
 	}
 	if(only_orig){
-		fprintf(stdout, "'%s'\n", orig_pth.c_str());
+		if(ZO_LOGGER.ndjson){
+			ZO_LOGGER.json_begin(zo_log_lev::plan, "FILE");
+			ZO_LOGGER.json_field("path", orig_pth.c_str());
+			ZO_LOGGER.json_end();
+			return;
+		}
+		fprintf(ZO_LOGGER.out, "'%s'\n", orig_pth.c_str());
 		return;
 	}
-	if((orig_pth != nxt_pth) && fs::exists(nxt_pth) && (org.pol == zo_policy::keep)){
-		fprintf(stdout, "KEEPING_EXISTING_FILE '%s'\n", nxt_pth.c_str());
+	if((orig_pth != nxt_pth) && org.file_exists(nxt_pth) && (org.pol == zo_policy::keep)){
+		ZO_EVENT(plan, "KEEPING_EXISTING_FILE", nxt_pth.c_str());
 		return;
 	}
 	
 	bool is_mv = org.is_move();
 	zo_string act = (is_mv)?("MOVE_FILE"):("COPY_FILE");
+	if(ZO_LOGGER.ndjson){
+		ZO_LOGGER.json_begin(zo_log_lev::plan, act.c_str());
+		ZO_LOGGER.json_field("path", orig_pth.c_str());
+		ZO_LOGGER.json_field("to", nxt_pth.c_str());
+		ZO_LOGGER.json_field("conflict", (long)is_confl);
+		ZO_LOGGER.json_end();
+		return;
+	}
 	zo_string cfl = (is_confl)?(" THAT_WAS_IN_CONFLICT"):("");
-	fprintf(stdout, "%s%s '%s' to '%s'\n", act.c_str(), cfl.c_str(), orig_pth.c_str(), nxt_pth.c_str());
+	fprintf(ZO_LOGGER.out, "%s%s '%s' to '%s'\n", act.c_str(), cfl.c_str(), orig_pth.c_str(), nxt_pth.c_str());
 	
 }
 
 void
 zo_ref::print_actions(zo_orga& org){
 	ZO_CK(org.oper != zo_action::purge);
+	if(ZO_LOGGER.ndjson){
+		print_json();
+		return;
+	}
 	fprintf(stdout, "----------\n");
-	if(! bad_pth.empty()){
+	if(is_bad()){
 		zo_string sf_pth = owner->get_orig();
-		fprintf(stdout, "BAD_REF_line %ld:'%s' in file %s SKIPPED\n", num_line, bad_pth.c_str(), sf_pth.c_str());
+		fprintf(stdout, "BAD_REF_line %ld:'%s' in file %s SKIPPED\n", num_line(), zo_string(bad_pth()).c_str(), sf_pth.c_str());
 		return;
 	}
 	fprintf(stdout, "original_sample: %s\n", get_orig().c_str());
 	fprintf(stdout, "original_rel_sample: %s\n", get_orig_rel().c_str());
 	if(is_same()){
-		fprintf(stdout, "KEEPING_ORIG_LINE %ld. zo_ref::is_same()\n", num_line);
+		fprintf(stdout, "KEEPING_ORIG_LINE %ld. zo_ref::is_same()\n", num_line());
 		return;
 	}
-	fprintf(stdout, "replace_line %ld with:\n", num_line);
-	if(! prefix.empty()){
-		fprintf(stdout, "%s\n", prefix.c_str());
+	fprintf(stdout, "replace_line %ld with:\n", num_line());
+	if(! prefix().empty()){
+		fprintf(stdout, "%s\n", zo_string(prefix()).c_str());
 	}
 	fprintf(stdout, "sample=%s\n", get_next_rel().c_str());
-	if(! suffix.empty()){
-		fprintf(stdout, "%s\n", suffix.c_str());
+	if(! suffix().empty()){
+		fprintf(stdout, "%s\n", zo_string(suffix()).c_str());
+	}
+}
+
+void
+zo_ref::print_json(){
+	zo_string sf_pth = owner->get_orig();
+	if(is_bad()){
+		ZO_LOGGER.json_begin(zo_log_lev::plan, "BAD_REF");
+		ZO_LOGGER.json_field("sfz", sf_pth.c_str());
+		ZO_LOGGER.json_field("line", num_line());
+		ZO_LOGGER.json_field("text", zo_string(bad_pth()).c_str());
+		ZO_LOGGER.json_end();
+		return;
 	}
+	bool keep = is_same();
+	ZO_LOGGER.json_begin(zo_log_lev::plan, (keep)?("KEEP_REF"):("REPLACE_REF"));
+	ZO_LOGGER.json_field("sfz", sf_pth.c_str());
+	ZO_LOGGER.json_field("line", num_line());
+	ZO_LOGGER.json_field("sample", get_orig().c_str());
+	ZO_LOGGER.json_field("rel_sample", get_orig_rel().c_str());
+	if(! keep){
+		ZO_LOGGER.json_field("next_rel_sample", get_next_rel().c_str());
+		ZO_LOGGER.json_field("prefix", zo_string(prefix()).c_str());
+		ZO_LOGGER.json_field("suffix", zo_string(suffix()).c_str());
+	}
+	ZO_LOGGER.json_end();
+}
+
+void
+print_plan_note(const char* note, const zo_path& pth){
+	if(ZO_LOGGER.ndjson){
+		ZO_LOGGER.json_begin(zo_log_lev::plan, note);
+		ZO_LOGGER.json_field("path", pth.c_str());
+		ZO_LOGGER.json_end();
+		return;
+	}
+	fprintf(ZO_LOGGER.out, "%s\n", note);
 }
 
 void
 print_separator_line(const char* sep){
+	if(ZO_LOGGER.ndjson){
+		return;
+	}
 	for(int aa = 0; aa < 100; aa++){ 
 		fprintf(stdout, "%s", sep); 
 	} 
 	fprintf(stdout, "\n");  
 }
 
+void
+print_title(const char* sep, const char* title){
+	print_separator_line(sep);
+	if(! ZO_LOGGER.ndjson){
+		fprintf(stdout, "%s\n", title);  
+	}
+	print_separator_line(sep);
+}
+
 void
 zo_sfont::print_actions(zo_orga& org){
 	if(is_same()){
-		fprintf(stdout, "UNCHANGED SOUNDFONT '%s' (skipping)\n", get_orig().c_str());
+		ZO_EVENT(plan, "UNCHANGED SOUNDFONT", get_orig().c_str(), zo_log_qt::squote, " (skipping)");
 		return;
 	}
 	bool purging = (org.oper == zo_action::purge);
@@ -1089,22 +1985,23 @@ zo_sfont::print_actions(zo_orga& org){
 	
 	if(purging){
 		if(! is_txt){
-			fprintf(stdout, "NON_UTF8\n");
+			print_plan_note("NON_UTF8", get_orig());
 		} else
 		if(tot_spl_ref == 0){
-			fprintf(stdout, "NO_VALID_SAMPLES_FOUND\n");
+			print_plan_note("NO_VALID_SAMPLES_FOUND", get_orig());
 		}
 		return;
 	}
-	for(auto rf: all_ref){
-		rf->print_actions(org);
+	for(long aa = 0; aa < all_ref.size(); aa++){
+		zo_ref rf{this, aa};
+		rf.print_actions(org);
 	}
 }
 
 void
-zo_sample::print_actions(zo_orga& org){
+zo_sample::print_actions(zo_orga& org, bool with_bk_ref){
 	if(is_same()){
-		fprintf(stdout, "UNCHANGED SAMPLE '%s' (skipping)\n", get_orig().c_str());
+		ZO_EVENT(plan, "UNCHANGED SAMPLE", get_orig().c_str(), zo_log_qt::squote, " (skipping)");
 		return;
 	}
 	bool purging = (org.oper == zo_action::purge);
@@ -1114,13 +2011,23 @@ zo_sample::print_actions(zo_orga& org){
 	fpth.print_actions(org, false);
 	
 	if(purging){
-		if(all_bk_ref.empty()){
-			fprintf(stdout, "NO_REFERENCES_IN_SFZ_SOUNDFONTS\n");
+		if(! has_bk_ref()){
+			print_plan_note("NO_REFERENCES_IN_SFZ_SOUNDFONTS", get_orig());
 		}
 		return;
 	}
+	if(! with_bk_ref){
+		return;
+	}
 	for(const auto& sfe : all_bk_ref){
 		zo_sfont_pt sf = sfe.second;
+		if(ZO_LOGGER.ndjson){
+			ZO_LOGGER.json_begin(zo_log_lev::plan, "FOUND_IN");
+			ZO_LOGGER.json_field("path", get_orig().c_str());
+			ZO_LOGGER.json_field("sfz", sf->get_orig().c_str());
+			ZO_LOGGER.json_end();
+			continue;
+		}
 		fprintf(stdout, "FOUND IN----------\n");
 		sf->fpth.print_actions(org, true);
 	}
@@ -1130,31 +2037,33 @@ zo_sample::print_actions(zo_orga& org){
 void
 zo_dir::print_actions(zo_orga& org){
 	if(! all_selected_sfz.empty()){
-		print_separator_line("%");
-		fprintf(stdout, "ALL_SELECTED SOUNDFONTS\n");  
-		print_separator_line("%");
+		print_title("%", "ALL_SELECTED SOUNDFONTS");
 		for(const auto& sfe : all_selected_sfz){
 			zo_sfont_pt sf = sfe.second;
 			sf->print_actions(org);
 		}
 	}
 	if(! all_selected_spl.empty()){
-		print_separator_line("#");
-		fprintf(stdout, "ALL_SELECTED SAMPLES\n");  
-		print_separator_line("#");
+		print_title("#", "ALL_SELECTED SAMPLES");
 		for(const auto& sme : all_selected_spl){
 			zo_sample_pt sm = sme.second;
 			sm->print_actions(org);
 		}
 	}
-		
+	print_bad_refs(org);
+}
+
+void
+zo_dir::print_bad_refs(zo_orga& org){
 	ZO_CK(bad_spl != zo_null);
 	if(! bad_spl->all_bk_ref.empty()){
-		print_separator_line("!");
-		fprintf(stdout, "ALL_WITH_BAD_REFERENCES\n");  
-		print_separator_line("!");
+		print_title("!", "ALL_WITH_BAD_REFERENCES");
 		for(const auto& sfe : bad_spl->all_bk_ref){
 			zo_sfont_pt sf = sfe.second;
+			if(ZO_LOGGER.ndjson){
+				print_plan_note("FOUND_BAD_REFERENCES_IN", sf->get_orig());
+				continue;
+			}
 			fprintf(stdout, "FOUND_BAD_REFERENCES_IN:\n");  
 			sf->fpth.print_actions(org, true);
 		}
@@ -1162,28 +2071,158 @@ zo_dir::print_actions(zo_orga& org){
 }
 
 void
-zo_sfont::prepare_normalize(zo_orga& org){
+zo_sfont::prepare_normalize(zo_plan_vec& all_itm){
 	ZO_CK(fpth.nxt_pth.empty());
-	fpth.calc_next(org, cmd_sel);
+	all_itm.emplace_back(&fpth, cmd_sel);
 }
 
 void
-zo_sample::prepare_normalize(zo_orga& org){
+zo_sample::prepare_normalize(zo_plan_vec& all_itm){
 	ZO_CK(fpth.nxt_pth.empty());
-	fpth.calc_next(org, cmd_sel);
+	all_itm.emplace_back(&fpth, cmd_sel);
+	all_itm.back().spl = this;
 }
 
 void
 zo_orga::prepare_normalize(){
-	zo_orga& org = *this; 
+	zo_plan_vec all_itm;
 	for(const auto& sfe : all_selected_sfz){
 		zo_sfont_pt sf = sfe.second;
-		sf->prepare_normalize(org);
+		sf->prepare_normalize(all_itm);
 	}
 	for(const auto& sme : all_selected_spl){
 		zo_sample_pt sm = sme.second;
-		sm->prepare_normalize(org);
+		sm->prepare_normalize(all_itm);
+	}
+	plan_next(all_itm);
+}
+
+// candidates are found in parallel with --plan_threads. Conflicts are then solved 
+// in the order of all_itm, so names are the same as calling calc_next one by one.
+void
+zo_orga::plan_next(zo_plan_vec& all_itm){
+	zo_orga& org = *this;
+	zo_phase_timer tmr(zo_phase::calc_next, false);
+	long tot_itm = (long)all_itm.size();
+	zo_thread_pool pool;
+	zo_thread_pool* pl = zo_null;
+	if((plan_thds > 1) && (tot_itm > ZO_PLAN_CHUNK_SZ)){
+		pool.start(plan_thds);
+		pl = &pool;
+	}
+	// names of an earlier call are only known to the next one through all_unique_nxt.
+	ZO_CK(! ext_planned);
+	bool can_ext = (ext_confl && (tot_itm > 1) && all_unique_nxt.empty() && (strm == zo_null));
+	if(can_ext && plan_next_external(all_itm, pl)){
+		ext_planned = true;
+		return;
+	}
+	calc_candidates(all_itm, 0, tot_itm, pl);
+	for(zo_plan_item& itm : all_itm){
+		itm.fnm->set_next(org, itm.cnd);
+		if((itm.spl != zo_null) && ! itm.spl->is_same()){
+			itm.spl->mark_refs_dirty();
+		}
+	}
+}
+
+// the candidates of all_itm[aa, bb), with the jobs of pool when given.
+void
+zo_orga::calc_candidates(zo_plan_vec& all_itm, long aa, long bb, zo_thread_pool* pool){
+	zo_orga& org = *this;
+	if(pool == zo_null){
+		for(long ii = aa; ii < bb; ii++){
+			zo_plan_item& itm = all_itm[ii];
+			itm.fnm->calc_candidate(org, itm.cmd_sel, itm.can_mv, itm.cnd);
+		}
+		return;
+	}
+	for(long cc = aa; cc < bb; cc += ZO_PLAN_CHUNK_SZ){
+		long dd = std::min(cc + ZO_PLAN_CHUNK_SZ, bb);
+		pool->submit([&org, &all_itm, cc, dd](){
+			for(long ii = cc; ii < dd; ii++){
+				zo_plan_item& itm = all_itm[ii];
+				itm.fnm->calc_candidate(org, itm.cmd_sel, itm.can_mv, itm.cnd);
+			}
+		});
+	}
+	pool->wait_idle();
+}
+
+static
+zo_string
+get_hash_key(const zo_string& pth){
+	uint64_t hh = std::hash<zo_string>{}(pth);
+	zo_string key(sizeof(hh), '\0');
+	for(long aa = (long)sizeof(hh) - 1; aa >= 0; aa--){
+		key[aa] = (char)(hh & 0xff);
+		hh >>= 8;
+	}
+	return key;
+}
+
+// --external_conflicts. The hashes of the candidates go to sorted runs. Only items with 
+// a hash shared by another item, or with a name like the ones set_num_name makes, can 
+// take part in a conflict. Just those are solved with all_unique_nxt, in order, and 
+// the rest keep their candidate. The names are the same as with plan_next.
+bool
+zo_orga::plan_next_external(zo_plan_vec& all_itm, zo_thread_pool* pool){
+	zo_orga& org = *this;
+	long tot_itm = (long)all_itm.size();
+	zo_string sdir;
+	if(! zo_make_spill_dir("conflicts", sdir)){
+		return false;
+	}
+	long run_bytes = (max_mem > 0)?(std::max(max_mem / 8, 1L)):(ZO_EXT_RUN_BYTES);
+	std::vector<bool> all_may_cfl(tot_itm, false);
+	bool ok = true;
+	{
+		zo_run_writer hsh_w;
+		hsh_w.init(sdir + "/hash", run_bytes);
+		for(long aa = 0; aa < tot_itm; aa += ZO_EXT_BLOCK_SZ){
+			long bb = std::min(aa + ZO_EXT_BLOCK_SZ, tot_itm);
+			calc_candidates(all_itm, aa, bb, pool);
+			for(long ii = aa; ii < bb; ii++){
+				zo_next_cand& cnd = all_itm[ii].cnd;
+				zo_path nx_pth = cnd.dr_to / cnd.rel_dir / cnd.nm;
+				hsh_w.add(get_hash_key(nx_pth), ii);
+				if(regex_search(cnd.nm, ZO_INCR_PATTERN)){
+					all_may_cfl[ii] = true;
+				}
+				cnd = zo_next_cand{};
+			}
+		}
+		zo_run_merger hsh_m;
+		ok = hsh_m.open(hsh_w);
+		while(ok && hsh_m.has_next()){
+			zo_run_rec fst = hsh_m.top();
+			hsh_m.pop();
+			while(hsh_m.has_next() && (hsh_m.top().key == fst.key)){
+				all_may_cfl[fst.val] = true;
+				all_may_cfl[hsh_m.top().val] = true;
+				hsh_m.pop();
+			}
+		}
+		ok = (ok && ! hsh_m.bad);
+	}
+	zo_remove_spill_dir(sdir);
+	if(! ok){
+		return false;
+	}
+	
+	for(long aa = 0; aa < tot_itm; aa += ZO_EXT_BLOCK_SZ){
+		long bb = std::min(aa + ZO_EXT_BLOCK_SZ, tot_itm);
+		calc_candidates(all_itm, aa, bb, pool);
+		for(long ii = aa; ii < bb; ii++){
+			zo_plan_item& itm = all_itm[ii];
+			itm.fnm->set_next(org, itm.cnd, all_may_cfl[ii]);
+			if((itm.spl != zo_null) && ! itm.spl->is_same()){
+				itm.spl->mark_refs_dirty();
+			}
+			itm.cnd = zo_next_cand{};
+		}
 	}
+	return true;
 }
 
 int
@@ -1219,38 +2258,56 @@ test_fix(int argc, char* argv[]){
 	return 0;
 }
 
-int main(int argc, char* argv[]){
-	return sfz_organizer_main(argc, argv);
-	//return test_fix(argc, argv);
-	//return test_fs(argc, argv);
-	//return test_rx(argc, argv);
-	// create_directories
+void
+zo_copy_file(const zo_path& orig, const zo_path& dest, bool replace){
+	std::error_code ec;
+	long tot_cp = ZO_VFS->copy_file(orig, dest, replace, ec);
+	if((tot_cp == ZO_VFS_CANNOT_OPEN_SRC) || (tot_cp == ZO_VFS_CANNOT_OPEN_DST)){
+		const zo_path& pth = (tot_cp == ZO_VFS_CANNOT_OPEN_SRC)?(orig):(dest);
+		ZO_MSG(error, "Cannot open file:'%s'\n", pth.c_str());
+		std::cerr << "Error: " << ec.message() << "\n\n";
+		exit(0);
+	}
+	if(ec){
+		// before the caller removes or replaces anything with the partial copy
+		ZO_MSG(error, "Cannot copy file:'%s' to '%s'\n", orig.c_str(), dest.c_str());
+		std::cerr << "Error: " << ec.message() << "\n\n";
+		try { ZO_VFS->remove(dest); } catch(...) {}
+		exit(0);
+	}
+	ZO_STAT_ADD(bytes_read, tot_cp);
+	ZO_STAT_ADD(bytes_written, tot_cp);
 }
 
 void 
 zo_sfont::do_actions(zo_orga& org){
+	do_actions(org, org.get_temp_path());
+}
+
+void 
+zo_sfont::do_actions(zo_orga& org, const zo_path& tmp){
 	ZO_CK(! did_it);
 	if(did_it){ return; }
 	did_it = true;
+	ZO_STAT_INC(actions_done);
 	
 	if(is_same()){
-		fprintf(stdout, "UNCHANGED SOUNDFONT '%s' (skipping)\n", get_orig().c_str());
+		ZO_EVENT(info, "UNCHANGED SOUNDFONT", get_orig().c_str(), zo_log_qt::squote, " (skipping)");
 		return;
 	}
 	zo_path nxt = get_next();
 	if(nxt.empty()){
-		fprintf(stdout, "SKIPPING SOUNDFONT '%s'\n", get_orig().c_str());
+		ZO_EVENT(info, "SKIPPING SOUNDFONT", get_orig().c_str());
 		return;
 	}
-	fs::create_directories(nxt.parent_path());
+	ZO_VFS->create_directories(nxt.parent_path());
 	
-	if((get_orig() != nxt) && fs::exists(nxt) && (org.pol == zo_policy::keep)){
-		fprintf(stdout, "KEEPING_EXISTING_FILE '%s'\n", nxt.c_str());
+	if((get_orig() != nxt) && ZO_VFS->exists(nxt) && (org.pol == zo_policy::keep)){
+		ZO_EVENT(plan, "KEEPING_EXISTING_FILE", nxt.c_str());
 		return;
 	}
 	
 	bool is_mv = org.is_move();
-	zo_path tmp = org.get_temp_path();
 	if(org.do_old){
 		ZO_CK(false);
 		prepare_tmp_file(tmp);
@@ -1258,9 +2315,13 @@ zo_sfont::do_actions(zo_orga& org){
 		prepare_sfz_file(tmp);
 	}
 	if(is_mv){
-		fs::remove(get_orig());
+		ZO_VFS->remove(get_orig());
+		ZO_STAT_INC(files_moved);
+	} else {
+		ZO_STAT_INC(files_copied);
 	}
-	fs::rename(tmp, nxt);
+	ZO_VFS->rename(tmp, nxt);
+	fpth.done = true;
 }
 
 void 
@@ -1268,29 +2329,82 @@ zo_sample::do_actions(zo_orga& org){
 	ZO_CK(! did_it);
 	if(did_it){ return; }
 	did_it = true;
+	ZO_STAT_INC(actions_done);
 	
 	if(is_same()){
-		fprintf(stdout, "UNCHANGED SAMPLE '%s' (skipping)\n", get_orig().c_str());
+		ZO_EVENT(info, "UNCHANGED SAMPLE", get_orig().c_str(), zo_log_qt::squote, " (skipping)");
 		return;
 	}
 	zo_path nxt = get_next();
 	if(nxt.empty()){
-		fprintf(stdout, "SKIPPING SAMPLE '%s'\n", get_orig().c_str());
+		ZO_EVENT(info, "SKIPPING SAMPLE", get_orig().c_str());
 		return;
 	}
-	fs::create_directories(nxt.parent_path());
+	ZO_VFS->create_directories(nxt.parent_path());
 	
-	if((get_orig() != nxt) && fs::exists(nxt) && (org.pol == zo_policy::keep)){
-		fprintf(stdout, "KEEPING_EXISTING_FILE '%s'\n", nxt.c_str());
+	if((get_orig() != nxt) && ZO_VFS->exists(nxt) && (org.pol == zo_policy::keep)){
+		ZO_EVENT(plan, "KEEPING_EXISTING_FILE", nxt.c_str());
 		return;
 	}
 	
 	bool is_mv = org.is_move();
 	if(is_mv){
-		fs::rename(get_orig(), nxt);
+		zo_trace_span spn("rename_sample", "write", get_orig());
+		ZO_VFS->rename(get_orig(), nxt);
+		ZO_STAT_INC(files_moved);
+		fpth.done = true;
+		return;
+	}
+	copy_or_link(org, nxt);
+	fpth.done = true;
+}
+
+void 
+zo_sample::copy_or_link(zo_orga& org, const zo_path& nxt){
+	zo_trace_span spn("copy_sample", "write", get_orig());
+	if(! ino_key.is_valid()){
+		zo_vfs_stat st;
+		if(ZO_VFS->stat(get_orig(), st) && (st.nlink > 1)){
+			ino_key = st.key;
+		}
+	}
+	if(! ino_key.is_valid()){
+		zo_copy_file(get_orig(), nxt, (org.pol == zo_policy::replace));
+		ZO_STAT_INC(files_copied);
 		return;
 	}
-	fs::copy(get_orig(), nxt);
+	
+	zo_string lnk_pth = "";
+	bool is_fst = false;
+	{
+		// other executors wait for the first copy of an inode to link to it.
+		std::unique_lock<std::mutex> lk(org.ino_mtx);
+		org.ino_cv.wait(lk, [&]{ return (org.all_copying_ino.count(ino_key) == 0); });
+		auto it = org.all_copied_ino.find(ino_key);
+		if(it != org.all_copied_ino.end()){
+			lnk_pth = it->second;
+		} else {
+			is_fst = true;
+			org.all_copied_ino[ino_key] = nxt;
+			org.all_copying_ino.insert(ino_key);
+		}
+	}
+	if(! lnk_pth.empty()){
+		std::error_code ec;
+		ZO_VFS->hard_link(lnk_pth, nxt, ec);
+		if(! ec){
+			ZO_EVENT2(plan, "LINKING_HARDLINKED_SAMPLE", get_orig().c_str(), nxt.c_str());
+			ZO_STAT_INC(files_linked);
+			return;
+		}
+	}
+	zo_copy_file(get_orig(), nxt, (org.pol == zo_policy::replace));
+	ZO_STAT_INC(files_copied);
+	if(is_fst){
+		std::lock_guard<std::mutex> lk(org.ino_mtx);
+		org.all_copying_ino.erase(ino_key);
+		org.ino_cv.notify_all();
+	}
 }
 
 void 
@@ -1308,34 +2422,34 @@ zo_dir::do_actions(zo_orga& org){
 void
 zo_sfont::prepare_tmp_file(const zo_path& tmp_pth){
 	if(all_ref.empty()){
-		fprintf(stdout, "JUST_COPY_FILE. all_ref.empty(). %s\n", get_orig().c_str()); // dbg_prt
-		fs::copy(get_orig(), tmp_pth);
+		ZO_MSG(debug, "JUST_COPY_FILE. all_ref.empty(). %s\n", get_orig().c_str());
+		zo_copy_file(get_orig(), tmp_pth);
 		return;
 	}
 	
-	std::ifstream src;
-	src.open(get_orig().c_str(), std::ios::binary);
-	if(! src.good() || ! src.is_open()){
-		fprintf(stdout, "Cannot open file:'%s'\n", get_orig().c_str());
+	zo_istream_pt src_pt = ZO_VFS->open_read(get_orig());
+	if(! src_pt){
+		ZO_MSG(error, "Cannot open file:'%s'\n", get_orig().c_str());
 		std::cerr << "Error: " << strerror(errno) << "\n\n";
 		exit(0);
 	}
-	std::ofstream dst;
+	std::istream& src = *src_pt;
 	zo_string tmp = tmp_pth;
-	dst.open(tmp.c_str(), std::ios::binary);
-	if(! dst.good() || ! dst.is_open()){
-		fprintf(stdout, "Cannot open file:'%s'\n", tmp.c_str());
+	zo_ostream_pt dst_pt = ZO_VFS->open_write(tmp);
+	if(! dst_pt){
+		ZO_MSG(error, "Cannot open file:'%s'\n", tmp.c_str());
 		std::cerr << "Error: " << strerror(errno) << "\n\n";
 		exit(0);
 	}
+	std::ostream& dst = *dst_pt;
 	
-	auto it = all_ref.begin();
+	long ri = 0;
 	
 	std::smatch sample_matches;
 	long lnum = 0;
 	zo_string ln;
 	for(;getline(src, ln);){
-		if(it == all_ref.end()){
+		if(ri == all_ref.size()){
 			dst << ln << '\n';
 			continue;
 		}
@@ -1350,29 +2464,28 @@ zo_sfont::prepare_tmp_file(const zo_path& tmp_pth){
 			dst << ln << '\n';
 			continue;
 		}
-		zo_ref_pt rf = *it;
-		ZO_CK(rf != zo_null);
-		if(rf->num_line > lnum){
+		zo_ref rf{this, ri};
+		if(rf.num_line() > lnum){
 			dst << ln << '\n';
 			continue;
 		}
-		if(rf->num_line < lnum){
-			fprintf(stdout, "INTERNAL ERROR !! (rf->num_line < lnum) PREPARING:'%s'. Please send a bug report with an small example\n", tmp.c_str());
+		if(rf.num_line() < lnum){
+			ZO_MSG(error, "INTERNAL ERROR !! (rf.num_line() < lnum) PREPARING:'%s'. Please send a bug report with an small example\n", tmp.c_str());
 			ZO_CK(false);
 			throw sfz_exception(sfz_read_1_and_2_differ, get_orig());
 		}
 			
-		it++;
-		rf->write_ref(dst, ln);
+		ri++;
+		rf.write_ref(dst, ln);
 	}
 	
 	//return 0;
 }
 
 void 
-zo_ref::write_ref(std::ofstream& dst, const zo_string& ln){
-	if(! bad_pth.empty()){
-		//fprintf(stdout, "KEEP_LINE.! bad_pth.empty()_during %s\n", ln.c_str()); // dbg_prt
+zo_ref::write_ref(std::ostream& dst, const zo_string& ln){
+	if(is_bad()){
+		//fprintf(stdout, "KEEP_LINE.is_bad()_during %s\n", ln.c_str()); // dbg_prt
 		dst << ln << '\n';
 		return;
 	}
@@ -1381,32 +2494,33 @@ zo_ref::write_ref(std::ofstream& dst, const zo_string& ln){
 		dst << ln << '\n';
 		return;
 	} 
-	if(! prefix.empty()){
-		//fprintf(stdout, "WRITING_PREFIX. %s\n", prefix.c_str()); // dbg_prt
-		dst << prefix << '\n';
+	if(! prefix().empty()){
+		//fprintf(stdout, "WRITING_PREFIX. %s\n", zo_string(prefix()).c_str()); // dbg_prt
+		dst << prefix() << '\n';
 	}
 	zo_string nx_rel = get_next_rel();
 	//fprintf(stdout, "WRITING_SAMPLE. %s\n", nx_rel.c_str()); // dbg_prt
 	dst << "sample=" << nx_rel << '\n';
-	if(! suffix.empty()){
-		//fprintf(stdout, "WRITING_SUFIX. %s\n", suffix.c_str()); // dbg_prt
-		dst << suffix << '\n';
+	if(! suffix().empty()){
+		//fprintf(stdout, "WRITING_SUFIX. %s\n", zo_string(suffix()).c_str()); // dbg_prt
+		dst << suffix() << '\n';
 	}
 }
 
 void
-zo_sfont::prepare_add_sfz_ext(zo_orga& org){
+zo_sfont::prepare_add_sfz_ext(zo_plan_vec& all_itm){
 	ZO_CK(fpth.nxt_pth.empty());
-	fpth.calc_next(org, cmd_sel);
+	all_itm.emplace_back(&fpth, cmd_sel);
 }
 
 void
 zo_orga::prepare_add_sfz_ext(){
-	zo_orga& org = *this;
+	zo_plan_vec all_itm;
 	for(const auto& sfe : all_selected_sfz){
 		zo_sfont_pt sf = sfe.second;
-		sf->prepare_add_sfz_ext(org);
+		sf->prepare_add_sfz_ext(all_itm);
 	}
+	plan_next(all_itm);
 }
 
 const zo_path
@@ -1421,40 +2535,42 @@ get_from_rel_path(zo_path& pth, zo_path& dir_from){
 }
 
 void
-zo_sfont::prepare_purge(zo_orga& org){
+zo_sfont::prepare_purge(zo_plan_vec& all_itm){
 	ZO_CK(fpth.nxt_pth.empty());
 	if(! is_txt || (tot_spl_ref == 0)){
-		fpth.calc_next(org, cmd_sel);
+		all_itm.emplace_back(&fpth, cmd_sel);
 		return;
 	}
 }
 
 void
-zo_sample::prepare_purge(zo_orga& org){
+zo_sample::prepare_purge(zo_plan_vec& all_itm){
 	ZO_CK(fpth.nxt_pth.empty());
-	if(all_bk_ref.empty()){
-		fpth.calc_next(org, cmd_sel);
+	if(! has_bk_ref()){
+		all_itm.emplace_back(&fpth, cmd_sel);
+		all_itm.back().spl = this;
 		return;
 	}
 }
 
 void
 zo_orga::prepare_purge(){
-	zo_orga& org = *this;
+	zo_plan_vec all_itm;
 	for(const auto& sfe : all_selected_sfz){
 		zo_sfont_pt sf = sfe.second;
-		sf->prepare_purge(org);
+		sf->prepare_purge(all_itm);
 	}
 	for(const auto& sme : all_selected_spl){
 		zo_sample_pt sm = sme.second;
-		sm->prepare_purge(org);
+		sm->prepare_purge(all_itm);
 	}
+	plan_next(all_itm);
 }
 
 bool
 zo_orga::calc_target(bool had_dir_to){
-	bool lst_is_dir = fs::is_directory(last_pth);
-	bool lst_exists = fs::exists(last_pth);
+	bool lst_is_dir = ZO_VFS->is_directory(last_pth);
+	bool lst_exists = ZO_VFS->exists(last_pth);
 	target = "";
 	if(had_dir_to){
 		return true;
@@ -1480,8 +2596,8 @@ zo_orga::calc_target(bool had_dir_to){
 		if(pnt.empty()){
 			pnt = ".";
 		}
-		if(! fs::is_directory(pnt)){
-			fprintf(stdout, "The target's directory '%s' does NOT exist\n", pnt.c_str());
+		if(! ZO_VFS->is_directory(pnt)){
+			ZO_MSG(error, "The target's directory '%s' does NOT exist\n", pnt.c_str());
 			return false;
 		}
 		
@@ -1495,11 +2611,12 @@ zo_orga::calc_target(bool had_dir_to){
 	
 	ZO_CK(last_pth == f_names.back());
 	
-	last_pth = fs::canonical(last_pth);
+	std::error_code ec;
+	last_pth = ZO_VFS->canonical(last_pth, ec);
 	f_names.pop_back();
 	
 	if(! lst_is_dir){
-		fprintf(stdout, "Target '%s' exists and is NOT directory\n", last_pth.c_str());
+		ZO_MSG(error, "Target '%s' exists and is NOT directory\n", last_pth.c_str());
 		return false;
 	}
 	
@@ -1510,87 +2627,1238 @@ zo_orga::calc_target(bool had_dir_to){
 }
 
 void
-zo_sfont::prepare_copy_or_move(zo_orga& org){
+zo_sfont::prepare_copy_or_move(zo_plan_vec& all_itm){
 	ZO_CK(fpth.nxt_pth.empty());
-	fpth.calc_next(org, cmd_sel, can_move);
+	all_itm.emplace_back(&fpth, cmd_sel, can_move);
 }
 
 void
-zo_sample::prepare_copy_or_move(zo_orga& org){
+zo_sample::prepare_copy_or_move(zo_plan_vec& all_itm){
 	ZO_CK(fpth.nxt_pth.empty());
-	fpth.calc_next(org, cmd_sel);
+	all_itm.emplace_back(&fpth, cmd_sel);
+	all_itm.back().spl = this;
 }
 
 void
 zo_orga::prepare_copy_or_move(){
-	zo_orga& org = *this;
+	zo_plan_vec all_itm;
 	for(const auto& sfe : all_selected_sfz){
 		zo_sfont_pt sf = sfe.second;
-		sf->prepare_copy_or_move(org);
+		sf->prepare_copy_or_move(all_itm);
 	}
 	for(const auto& sme : all_selected_spl){
 		zo_sample_pt sm = sme.second;
-		sm->prepare_copy_or_move(org);
+		sm->prepare_copy_or_move(all_itm);
+	}
+	plan_next(all_itm);
+}
+
+bool
+zo_orga::can_pipeline(){
+	if(pipe_thds <= 0){
+		return false;
+	}
+	// --files-from lists sfz before their samples. The pipeline plans samples first.
+	bool can_pp = ((oper == zo_action::copy) || (oper == zo_action::add_sfz)) && save_nam.empty() && 
+					files_from.empty() && ! do_old;
+	if(! can_pp){
+		fprintf(stderr, "option --pipeline only works with --copy or --add_sfz_ext, without --save-plan or --files-from. Running phases in order\n");
 	}
+	return can_pp;
 }
 
+// plans and queues the actions of files as they are selected. Each sfz is planned when parsed.
 void
-zo_orga::organizer_main(const zo_str_vec& args){
-	if(! get_args(args)){
-		fprintf(stderr, "Doing_nothing\n");
-		return;
+zo_orga::run_pipeline(){
+	zo_orga& org = *this;
+	zo_pipeline pp(pipe_thds * 4);
+	pipe = &pp;
+	keep_nw_sel = true;
+	long tot_exec = (just_list)?(0):(pipe_thds);
+	fprintf(stderr, "Pipelining with %ld parser and %ld action threads\n", pipe_thds, tot_exec);
+	if(just_list){
+		fprintf(stderr, "Just_printing_actions\n");
 	}
-	fprintf(stderr, "Starting\n");
 	
-	zo_orga& org = *this;
-	read_selected();
+	pp.tot_parser_on = pipe_thds;
+	for(long aa = 0; aa < pipe_thds; aa++){
+		pp.all_parser.emplace_back([&pp](){
+			zo_sfont_pt sf = zo_null;
+			while(pp.parse_q.pop(sf)){
+				zo_sfz_text_pt txt = new zo_sfz_text();
+				txt->sf = sf;
+				{
+					zo_phase_timer tmr(zo_phase::parse_sfz, false);
+					sf->parse_opcodes(*txt);
+				}
+				pp.parsed_q.push(std::move(txt));
+			}
+			if(--pp.tot_parser_on == 0){
+				pp.parsed_q.close();
+			}
+		});
+	}
+	for(long aa = 0; aa < tot_exec; aa++){
+		zo_path tmp = tmp_pth.string() + "_" + std::to_string(aa);
+		pp.all_executor.emplace_back([&org, &pp, tmp](){
+			zo_exec_job jb;
+			while(pp.exec_q.pop(jb)){
+				if(jb.sf != zo_null){
+					jb.sf->do_actions(org, tmp);
+					jb.sf->free_opcodes();
+				} else {
+					jb.sp->do_actions(org);
+				}
+			}
+		});
+	}
 	
-	if(oper == zo_action::normalize){
-		prepare_normalize();
+	{
+		zo_phase_timer tmr(zo_phase::read_selected);
+		scan_selected();
+		pp.parse_q.close();
+		while(pipe_add_parsed(true)){}
+	}
+	for(auto& th : pp.all_parser){
+		th.join();
+	}
+	pp.exec_q.close();
+	{
+		zo_phase_timer tmr(zo_phase::do_actions);
+		for(auto& th : pp.all_executor){
+			th.join();
+		}
 	}
-	if(oper == zo_action::add_sfz){
-		prepare_add_sfz_ext();
+	keep_nw_sel = false;
+	pipe = zo_null;
+	
+	if(just_list){
+		print_bad_refs(org);
+		print_conflicts();
+		fprintf(stderr, "Doing_nothing.\n");
+		return;
 	}
-	if(oper == zo_action::purge){
-		prepare_purge();
+	if(pp.stopped){
+		fprintf(stderr, "Conflict with the next name of '%s'. Stopped the pipeline. Actions already done were kept\n", 
+				pp.confl_pth.c_str());
+		fprintf(stderr, "Run without --pipeline to list all conflicts or use --force_action\n");
 	}
-	if(oper == zo_action::copy){
-		prepare_copy_or_move();
+}
+
+// queues sf for the parsers. Takes parsed ones while the queue is full so parsers never wait on this thread.
+void
+zo_orga::pipe_parse(zo_sfont_pt sf){
+	zo_pipeline& pp = *pipe;
+	if(pp.stopped){
+		return;
 	}
-	if(oper == zo_action::move){
-		prepare_copy_or_move();
+	pp.all_parsing.insert(sf);
+	zo_sfont_pt q_sf = sf;
+	while(! pp.parse_q.try_push(std::move(q_sf))){
+		pipe_add_parsed(true);
 	}
-	
-	if((tot_conflict > 0) && ! force_action){
-		just_list = true;
+	while(pipe_add_parsed(false)){}
+}
+
+bool
+zo_orga::pipe_add_parsed(bool wait){
+	zo_pipeline& pp = *pipe;
+	zo_sfz_text_pt txt = zo_null;
+	bool has_txt = (wait)?(pp.parsed_q.pop(txt)):(pp.parsed_q.try_pop(txt));
+	if(! has_txt){
+		return false;
 	}
+	zo_sfont_pt sf = txt->sf;
+	pp.all_parsing.erase(sf);
+	sf->add_opcodes(*this, *txt);
+	delete txt;
 	
-	if(just_list){
-		fprintf(stderr, "Just_printing_actions\n");
-		print_actions(org);
-		if(tot_conflict > 0){
-			if(! all_conflict.empty()){
-				fprintf(stderr, "Conflicts would be solved with the following names\n");
-				for(auto nm : all_conflict){
-					fprintf(stderr, "%s\n", nm.c_str());
-				}
+	pipe_plan_selected();
+	if(all_selected_sfz.count(sf->get_orig()) > 0){
+		pipe_plan(sf, zo_null);
+	}
+	return true;
+}
+
+// samples first, so an sfz is written with the next names of its samples.
+void
+zo_orga::pipe_plan_selected(){
+	zo_pipeline& pp = *pipe;
+	for(zo_sample_pt sp : all_nw_sel_spl){
+		pipe_plan(zo_null, sp);
+	}
+	all_nw_sel_spl.clear();
+	for(zo_sfont_pt sf : all_nw_sel_sfz){
+		if(pp.all_parsing.count(sf) == 0){
+			pipe_plan(sf, zo_null);
+		}
+	}
+	all_nw_sel_sfz.clear();
+}
+
+void
+zo_orga::pipe_plan(zo_sfont_pt sf, zo_sample_pt sp){
+	zo_orga& org = *this;
+	zo_pipeline& pp = *pipe;
+	if(pp.stopped){
+		return;
+	}
+	zo_fname* fnm = zo_null;
+	{
+		zo_phase_timer tmr(zo_phase::prepare, false);
+		zo_plan_vec all_itm;
+		if(sf != zo_null){
+			fnm = &(sf->fpth);
+			if(oper == zo_action::add_sfz){
+				sf->prepare_add_sfz_ext(all_itm);
+			} else {
+				sf->prepare_copy_or_move(all_itm);
 			}
-			fprintf(stderr, "Found %ld conflicts. Use --force_action to execute\n", tot_conflict);
-			
+		} else {
+			fnm = &(sp->fpth);
+			sp->prepare_copy_or_move(all_itm);
 		}
-		fprintf(stderr, "Doing_nothing.\n");
+		org.plan_next(all_itm);
+	}
+	if(just_list){
+		pipe_print(sf, sp);
 		return;
 	}
-	
-	ZO_CK(oper != zo_action::nothing);
-	do_actions(org);
+	if(fnm->is_confl && ! force_action){
+		pp.stopped = true;
+		pp.confl_pth = fnm->orig_pth;
+		return;
+	}
+	ZO_STAT_INC(actions_total);
+	zo_exec_job jb;
+	jb.sf = sf;
+	jb.sp = sp;
+	pp.exec_q.push(std::move(jb));
 }
 
+// --list. Names planned by the pipeline do not change, so each file is printed once planned.
+// Samples are printed without the sfz that refer to them, which may not be found yet.
+// The refs of an sfz are only final if its samples were read first (not --files-from).
 void
-zo_fname::calc_next(zo_orga& org, bool cmd_sel, bool can_mv){
-	ZO_CK(nxt_pth.empty());
-	std::error_code ec;
-	zo_path pth = orig_pth;
+zo_orga::pipe_print(zo_sfont_pt sf, zo_sample_pt sp){
+	zo_orga& org = *this;
+	zo_pipeline& pp = *pipe;
+	ZO_CK(files_from.empty());
+	{
+		zo_phase_timer tmr(zo_phase::print_actions, false);
+		if(sf != zo_null){
+			sf->print_actions(org);
+			sf->free_opcodes();
+		} else {
+			sp->print_actions(org, false);
+		}
+	}
+	long now = zo_wall_ns();
+	if((now - pp.last_flush_ns) >= ZO_PIPE_FLUSH_NS){
+		ZO_LOGGER.flush();
+		pp.last_flush_ns = now;
+	}
+}
+
+zo_stream::~zo_stream(){
+	sfz_w.remove_runs();
+	spl_w.remove_runs();
+	ref_w.remove_runs();
+	bad_w.remove_runs();
+	chk_w.remove_runs();
+	zo_remove_spill_dir(dir);
+}
+
+bool
+zo_stream::init(long max_bytes){
+	if(! zo_make_spill_dir("runs", dir)){
+		return false;
+	}
+	long run_bytes = std::max(max_bytes / 8, 1L);
+	sfz_w.init(dir + "/sfz", run_bytes);
+	spl_w.init(dir + "/spl", run_bytes);
+	ref_w.init(dir + "/ref", run_bytes);
+	bad_w.init(dir + "/bad", run_bytes);
+	chk_w.init(dir + "/chk", run_bytes);
+	batch_sz = std::max((max_bytes / 4) / ZO_STRM_OBJ_BYTES, 1L);
+	return true;
+}
+
+bool
+zo_orga::can_stream(){
+	return ((max_mem > 0) && (oper == zo_action::purge));
+}
+
+// --max_memory. Writes what a file adds to the purge instead of keeping it.
+void
+zo_orga::stream_file(const zo_path& apth, const zo_ftype ft, const bool only_with_ref, const bool is_sfz){
+	ZO_CK(strm != zo_null);
+	if((ft == zo_ftype::soundfont) && is_sfz){
+		if(only_with_ref){
+			strm->chk_w.add(apth, 0);
+			return;
+		}
+		stream_sfz(apth, true);
+		return;
+	}
+	if((ft == zo_ftype::sample) && ! is_sfz){
+		ZO_EVENT(info, ">>>SELECTING", apth.c_str(), zo_log_qt::bare);
+		strm->spl_w.add(apth, 0);
+	}
+}
+
+// same selection and references as read_canon_file and add_opcodes.
+void
+zo_orga::stream_sfz(const zo_string& apth, bool cmd_sel){
+	ZO_EVENT(info, "reading", apth.c_str(), zo_log_qt::pquote);
+	long bits = (cmd_sel)?(ZO_STRM_CMD_SEL):(0);
+	if(! is_text_file(apth)){
+		if(cmd_sel){
+			ZO_EVENT(info, ">>>SELECTING", apth.c_str(), zo_log_qt::bare);
+			strm->sfz_w.add(apth, bits);
+		}
+		return;
+	}
+	bits |= ZO_STRM_TXT;
+	
+	zo_sfont sf(apth);
+	zo_sfz_text txt;
+	{
+		zo_phase_timer tmr(zo_phase::parse_sfz, false);
+		sf.parse_opcodes(txt);
+	}
+	bool has_bad = false;
+	for(zo_sfz_line& sl : txt.all_line){
+		if(sl.kind != zo_sfz_ln::sample){
+			continue;
+		}
+		bits |= ZO_STRM_HAS_REF;
+		if(sl.bad_pth){
+			ZO_STAT_INC(bad_refs);
+			fprintf(stderr, "bad_ref_line %ld:'%s' in file %s\n", sl.lnum, sl.ln.c_str(), apth.c_str());
+			bits |= ZO_STRM_DIFF;
+			has_bad = true;
+			continue;
+		}
+		ZO_STAT_INC(refs_resolved);
+		if(! sl.prefix.empty() || ! sl.suffix.empty() || sl.fixed){
+			bits |= ZO_STRM_DIFF;
+		}
+		strm->ref_w.add(sl.pth, 0);
+		if(samples_too){
+			ZO_EVENT(info, ">>>SELECTING", sl.pth.c_str(), zo_log_qt::bare);
+			strm->spl_w.add(sl.pth, 0);
+		}
+	}
+	if(has_bad){
+		strm->bad_w.add(apth, 0);
+	}
+	if(cmd_sel || ((bits & ZO_STRM_HAS_REF) != 0)){
+		ZO_EVENT(info, ">>>SELECTING", apth.c_str(), zo_log_qt::bare);
+		strm->sfz_w.add(apth, bits);
+	}
+}
+
+// the sfz found looking for references that were not read before.
+bool
+zo_orga::stream_check_sfz(){
+	zo_run_merger chk_m;
+	zo_run_merger sfz_m;
+	if(! chk_m.open(strm->chk_w) || ! sfz_m.open(strm->sfz_w)){
+		return false;
+	}
+	zo_string key;
+	long val = 0;
+	long tot = 0;
+	while(chk_m.next_key(key, val, tot)){
+		while(sfz_m.has_next() && (sfz_m.top().key < key)){
+			sfz_m.pop();
+		}
+		if(sfz_m.has_next() && (sfz_m.top().key == key)){
+			continue;
+		}
+		stream_sfz(key, false);
+	}
+	return (! chk_m.bad && ! sfz_m.bad);
+}
+
+// one pass over the merged runs, in the order of all_selected_sfz and all_selected_spl.
+// false when a run cannot be read. The batch being filled is not done then.
+bool
+zo_orga::stream_batches(zo_stm_pass pss){
+	zo_orga& org = *this;
+	bool printing = (pss == zo_stm_pass::print);
+	zo_string key;
+	long val = 0;
+	long tot = 0;
+	
+	zo_run_merger sfz_m;
+	if(! sfz_m.open(strm->sfz_w)){
+		return false;
+	}
+	if(printing && sfz_m.has_next()){
+		print_title("%", "ALL_SELECTED SOUNDFONTS");
+	}
+	while(sfz_m.next_key(key, val, tot)){
+		zo_sfont_pt sf = make_sfont_pt(key);
+		sf->is_txt = ((val & ZO_STRM_TXT) != 0);
+		sf->tot_spl_ref = ((val & ZO_STRM_HAS_REF) != 0)?(1):(0);
+		sf->tot_diff_ref = ((val & ZO_STRM_DIFF) != 0)?(1):(0);
+		sf->cmd_sel = ((val & ZO_STRM_CMD_SEL) != 0);
+		sf->can_move = sf->cmd_sel;
+		all_selected_sfz[key] = sf;
+		if((long)all_selected_sfz.size() >= strm->batch_sz){
+			stream_batch(pss);
+		}
+	}
+	if(sfz_m.bad){
+		return false;
+	}
+	stream_batch(pss);
+	
+	zo_run_merger spl_m;
+	zo_run_merger ref_m;
+	if(! spl_m.open(strm->spl_w) || ! ref_m.open(strm->ref_w)){
+		return false;
+	}
+	if(printing && spl_m.has_next()){
+		print_title("#", "ALL_SELECTED SAMPLES");
+	}
+	while(spl_m.next_key(key, val, tot)){
+		while(ref_m.has_next() && (ref_m.top().key < key)){
+			ref_m.pop();
+		}
+		long tot_ref = 0;
+		while(ref_m.has_next() && (ref_m.top().key == key)){
+			tot_ref++;
+			ref_m.pop();
+		}
+		if(ref_m.bad){
+			// its references are not known. It must not look unreferenced
+			return false;
+		}
+		zo_sample_pt sp = make_sample_pt(key);
+		sp->cmd_sel = true;
+		sp->tot_bk_ref = tot_ref;
+		all_selected_spl[key] = sp;
+		if((long)all_selected_spl.size() >= strm->batch_sz){
+			stream_batch(pss);
+		}
+	}
+	if(spl_m.bad){
+		return false;
+	}
+	stream_batch(pss);
+	
+	if(! printing){
+		return true;
+	}
+	zo_run_merger bad_m;
+	if(! bad_m.open(strm->bad_w)){
+		return false;
+	}
+	if(bad_m.has_next()){
+		print_title("!", "ALL_WITH_BAD_REFERENCES");
+	}
+	while(bad_m.next_key(key, val, tot)){
+		if(ZO_LOGGER.ndjson){
+			print_plan_note("FOUND_BAD_REFERENCES_IN", key);
+			continue;
+		}
+		fprintf(stdout, "FOUND_BAD_REFERENCES_IN:\n");  
+		zo_sfont sf(key);
+		sf.fpth.print_actions(org, true);
+	}
+	return ! bad_m.bad;
+}
+
+void
+zo_orga::stream_batch(zo_stm_pass pss){
+	zo_orga& org = *this;
+	if(all_selected_sfz.empty() && all_selected_spl.empty()){
+		return;
+	}
+	prepare_purge();
+	if(pss == zo_stm_pass::print){
+		for(const auto& sfe : all_selected_sfz){
+			sfe.second->print_actions(org);
+		}
+		for(const auto& sme : all_selected_spl){
+			sme.second->print_actions(org);
+		}
+	}
+	if(pss == zo_stm_pass::act){
+		ZO_STAT_ADD(actions_total, (long)(all_selected_sfz.size() + all_selected_spl.size()));
+		do_actions(org);
+	}
+	for(const auto& sfe : all_selected_sfz){
+		delete sfe.second;
+	}
+	for(const auto& sme : all_selected_spl){
+		delete sme.second;
+	}
+	all_selected_sfz.clear();
+	all_selected_spl.clear();
+}
+
+// forgets the planned names, to plan them again.
+void
+zo_orga::clear_next_names(){
+	std::set<zo_last_confl_pt> all_cfl;
+	for(const auto& cc : all_unique_nxt){
+		all_cfl.insert(cc.second);
+	}
+	for(auto cf : all_cfl){
+		delete cf;
+	}
+	all_unique_nxt.clear();
+	all_conflict.clear();
+	tot_conflict = 0;
+	ext_planned = false;
+}
+
+// --max_memory. Files are planned once to count the conflicts and once more to print or do the actions.
+void
+zo_orga::run_stream(){
+	zo_stream stm;
+	if(! stm.init(max_mem)){
+		return;
+	}
+	strm = &stm;
+	bool ok = true;
+	{
+		zo_phase_timer tmr(zo_phase::read_selected);
+		scan_selected();
+		ok = stream_check_sfz();
+	}
+	if(! ok){
+		ZO_MSG(error, "Cannot use the run files in '%s'. Nothing was done.\n", stm.dir.c_str());
+		strm = zo_null;
+		return;
+	}
+	ZO_MSG(info, "--max_memory: %ld sfz, %ld samples and %ld references in %ld runs. Batches of %ld files\n", 
+			stm.sfz_w.tot_rec, stm.spl_w.tot_rec, stm.ref_w.tot_rec, 
+			(long)(stm.sfz_w.all_run.size() + stm.spl_w.all_run.size() + stm.ref_w.all_run.size()), stm.batch_sz);
+	
+	{
+		zo_phase_timer tmr(zo_phase::prepare);
+		ok = stream_batches(zo_stm_pass::plan);
+	}
+	if(! ok){
+		ZO_MSG(error, "Cannot use the run files in '%s'. Nothing was done.\n", stm.dir.c_str());
+		strm = zo_null;
+		return;
+	}
+	if((tot_conflict > 0) && ! force_action){
+		just_list = true;
+	}
+	clear_next_names();
+	
+	if(just_list){
+		fprintf(stderr, "Just_printing_actions\n");
+		{
+			zo_phase_timer tmr(zo_phase::print_actions);
+			ok = stream_batches(zo_stm_pass::print);
+		}
+		print_conflicts();
+		fprintf(stderr, "Doing_nothing.\n");
+	} else {
+		zo_phase_timer tmr(zo_phase::do_actions);
+		ok = stream_batches(zo_stm_pass::act);
+	}
+	if(! ok){
+		ZO_MSG(error, "Cannot use the run files in '%s'. Stopping.\n", stm.dir.c_str());
+	}
+	strm = zo_null;
+}
+
+template<typename T>
+static
+bool
+erase_if_same(std::map<zo_string, T>& all_fl, const zo_string& pth, T fl){
+	auto it = all_fl.find(pth);
+	if((it == all_fl.end()) || (it->second != fl)){
+		return false;
+	}
+	all_fl.erase(it);
+	return true;
+}
+
+bool
+zo_orga::has_step(zo_action ac){
+	return (std::find(all_step.begin(), all_step.end(), ac) != all_step.end());
+}
+
+// with --list, the files moved by the actions before are taken as moved.
+bool
+zo_orga::file_exists(const zo_string& pth){
+	if(all_made.count(pth) > 0){
+		return true;
+	}
+	if(all_gone.count(pth) > 0){
+		return false;
+	}
+	return ZO_VFS->exists(pth);
+}
+
+// --actions. The files are read once. Each step plans over the sfz and samples 
+// with the names and references the steps before left, without reading them again.
+void
+zo_orga::run_chain(){
+	{
+		zo_phase_timer tmr(zo_phase::read_selected);
+		chain_scan = true;
+		scan_selected();
+		chain_scan = false;
+	}
+	
+	zo_path cp_to = dir_to;
+	long tot_stp = (long)all_step.size();
+	for(long aa = 0; aa < tot_stp; aa++){
+		oper = all_step[aa];
+		dir_to = (oper == zo_action::copy)?(cp_to):(dir_from);
+		fprintf(stderr, "Action %ld of %ld: %s\n", aa + 1, tot_stp, get_action_str(oper).c_str());
+		reset_step();
+		
+		zo_sfont_map all_sfz;
+		zo_sample_map all_spl;
+		zo_sfont_map all_bad;
+		bool own_sel = ((oper == zo_action::add_sfz) || (oper == zo_action::copy));
+		if(own_sel){
+			select_step(all_sfz, all_spl);
+			all_selected_sfz.swap(all_sfz);
+			all_selected_spl.swap(all_spl);
+		}
+		if(oper == zo_action::add_sfz){
+			bad_spl->all_bk_ref.swap(all_bad);	// --add_sfz_ext reads no sfz
+		}
+		
+		bool was_lst = just_list;
+		run_oper();
+		
+		if(own_sel){
+			all_selected_sfz.swap(all_sfz);
+			all_selected_spl.swap(all_spl);
+		}
+		if(oper == zo_action::add_sfz){
+			bad_spl->all_bk_ref.swap(all_bad);
+		}
+		if(just_list && ! was_lst){
+			if((aa + 1) < tot_stp){
+				fprintf(stderr, "Stopping --actions at %s\n", get_action_str(oper).c_str());
+			}
+			return;
+		}
+		apply_step(all_sfz);
+	}
+}
+
+// the planned names and actions of the last step are forgotten.
+void
+zo_orga::reset_step(){
+	clear_next_names();
+	all_copied_ino.clear();
+	for(const auto& sme : all_read_spl){
+		zo_sample_pt sp = sme.second;
+		sp->fpth.reset();
+		sp->did_it = false;
+	}
+	for(const auto& sfe : all_read_sfz){
+		zo_sfont_pt sf = sfe.second;
+		sf->fpth.reset();
+		sf->did_it = false;
+		sf->spl_dirty = false;
+		sf->count_diff_refs();
+	}
+}
+
+// the files of an add_sfz_ext or copy step, from the ones read for all steps.
+void
+zo_orga::select_step(zo_sfont_map& all_sfz, zo_sample_map& all_spl){
+	if(oper == zo_action::add_sfz){
+		for(const auto& sme : all_selected_spl){
+			zo_sample_pt sp = sme.second;
+			if(sp->cmd_sel && sp->is_txt){
+				ZO_MEM_SCOPE(selected_maps);
+				all_sfz[sme.first] = make_sfont_pt(sp->get_orig());
+			}
+		}
+		return;
+	}
+	
+	ZO_CK(oper == zo_action::copy);
+	zo_string dto = dir_to;
+	bool spl_too = samples_too || (dto.rfind(dir_from, 0) != 0);
+	ZO_MEM_SCOPE(selected_maps);
+	for(const auto& sfe : all_selected_sfz){
+		zo_sfont_pt sf = sfe.second;
+		if(! sf->cmd_sel){
+			continue;
+		}
+		all_sfz[sfe.first] = sf;
+		if(! spl_too){
+			continue;
+		}
+		for(long aa = 0; aa < sf->all_ref.size(); aa++){
+			zo_ref rf{sf, aa};
+			if(! rf.is_bad()){
+				all_spl[rf.get_orig()] = rf.sref();
+			}
+		}
+	}
+	for(const auto& sme : all_selected_spl){
+		zo_sample_pt sp = sme.second;
+		if(sp->cmd_sel){
+			all_spl[sme.first] = sp;
+		}
+	}
+}
+
+// the action planned for fnm in this step was done (or listed with --list).
+bool
+zo_orga::step_applied(zo_fname& fnm, bool is_sm){
+	if(is_sm || fnm.nxt_pth.empty()){
+		return false;
+	}
+	if(! just_list){
+		return fnm.done;
+	}
+	bool kept = ((fnm.orig_pth != fnm.nxt_pth) && file_exists(fnm.nxt_pth) && (pol == zo_policy::keep));
+	return ! kept;
+}
+
+// the read files as reading them again after the step would find them.
+// Copies are not read by later steps.
+void
+zo_orga::apply_step(zo_sfont_map& all_sfz){
+	if(oper == zo_action::copy){
+		return;
+	}
+	bool adding_ext = (oper == zo_action::add_sfz);
+	zo_sfont_map& stp_sfz = (adding_ext)?(all_sfz):(all_selected_sfz);
+	
+	zo_ptsfont_vec all_sf;
+	zo_ptsample_vec all_sp;
+	for(const auto& sfe : stp_sfz){
+		zo_sfont_pt sf = sfe.second;
+		if(step_applied(sf->fpth, sf->is_same())){
+			all_sf.push_back(sf);
+		}
+	}
+	if(! adding_ext){
+		for(const auto& sme : all_selected_spl){
+			zo_sample_pt sp = sme.second;
+			if(step_applied(sp->fpth, sp->is_same())){
+				all_sp.push_back(sp);
+			}
+		}
+	}
+	
+	if(oper == zo_action::purge){
+		for(zo_sfont_pt sf : all_sf){
+			drop_soundfont(sf);
+		}
+		for(zo_sample_pt sp : all_sp){
+			drop_sample(sp);
+		}
+		return;
+	}
+	
+	if(adding_ext){
+		for(zo_sfont_pt sf : all_sf){
+			auto it = all_read_spl.find(sf->get_orig());
+			if(it != all_read_spl.end()){
+				break_refs(it->second);
+				drop_sample(it->second);
+			}
+			if(! just_list){
+				sf->fpth.orig_pth = sf->get_next();
+			}
+			if(ZO_VFS->exists(sf->get_orig())){	// with --list, not if named by an action before
+				sf->get_opcodes(*this);
+			}
+			sf->is_txt = true;
+			sf->can_move = true;
+			sf->cmd_sel = true;
+		}
+		rename_files(all_sf, all_sp);
+		return;
+	}
+	
+	ZO_CK(oper == zo_action::normalize);
+	zo_sample_set all_mv(all_sp.begin(), all_sp.end());
+	for(const auto& sfe : all_selected_sfz){
+		zo_sfont_pt sf = sfe.second;
+		if(! sf->is_same()){
+			fix_refs(sf, all_mv, step_applied(sf->fpth, false));
+		}
+	}
+	rename_files(all_sf, all_sp);
+}
+
+// the refs of sf as reading it again after the normalize step finds them. A written ref 
+// has the next name of its sample even if the sample kept its name. A kept sfz has the old names.
+void
+zo_orga::fix_refs(zo_sfont_pt sf, zo_sample_set& all_mv, bool was_written){
+	zo_ref_table& tb = sf->all_ref;
+	zo_sample_set all_old;
+	if(! was_written){
+		for(long aa = 0; aa < tb.size(); aa++){
+			zo_ref rf{sf, aa};
+			if(! rf.is_bad() && (all_mv.count(rf.sref()) > 0)){
+				all_old.insert(rf.sref());
+				break_ref(rf, zo_string(rf.prefix()) + "sample=" + rf.get_orig_rel() + zo_string(rf.suffix()));
+			}
+		}
+	} else {
+		std::vector<long> all_idx;
+		zo_ptsample_vec all_nxt;
+		zo_str_vec all_ln;
+		for(long aa = 0; aa < tb.size(); aa++){
+			zo_ref rf{sf, aa};
+			zo_sample_pt sp = rf.sref();
+			if(rf.is_bad() || rf.is_same() || sp->is_same() || (all_mv.count(sp) > 0)){
+				continue;
+			}
+			auto it = all_read_spl.find(sp->get_next());
+			bool found = ((it != all_read_spl.end()) && (all_mv.count(it->second) == 0));
+			all_idx.push_back(aa);
+			all_nxt.push_back((found)?(it->second):(zo_null));
+			all_ln.push_back("sample=" + rf.get_next_rel());
+		}
+		sf->apply_rewrite();
+		for(long bb = 0; bb < (long)all_idx.size(); bb++){
+			zo_ref rf{sf, all_idx[bb]};
+			all_old.insert(rf.sref());
+			if(all_nxt[bb] == zo_null){
+				break_ref(rf, all_ln[bb]);
+				continue;
+			}
+			tb.all_spl[rf.idx] = all_nxt[bb];
+			all_nxt[bb]->all_bk_ref[sf->get_orig()] = sf;
+		}
+	}
+	for(long aa = 0; aa < tb.size(); aa++){
+		all_old.erase(tb.all_spl[aa]);
+	}
+	for(zo_sample_pt sp : all_old){
+		erase_if_same(sp->all_bk_ref, sf->get_orig(), sf);
+	}
+}
+
+// true if sf was selected.
+bool
+zo_orga::drop_soundfont(zo_sfont_pt sf){
+	const zo_string& pth = sf->get_orig();
+	for(long aa = 0; aa < sf->all_ref.size(); aa++){
+		zo_ref rf{sf, aa};
+		erase_if_same(rf.sref()->all_bk_ref, pth, sf);
+	}
+	if(just_list){
+		all_made.erase(pth);
+		all_gone.insert(pth);
+	}
+	erase_if_same(all_read_sfz, pth, sf);
+	return erase_if_same(all_selected_sfz, pth, sf);
+}
+
+// true if sp was selected.
+bool
+zo_orga::drop_sample(zo_sample_pt sp){
+	const zo_string& pth = sp->get_orig();
+	if(just_list){
+		all_made.erase(pth);
+		all_gone.insert(pth);
+	}
+	erase_if_same(all_read_spl, pth, sp);
+	return erase_if_same(all_selected_spl, pth, sp);
+}
+
+// the ref names a file that is not a read sample any more. ln is its line.
+void
+zo_orga::break_ref(zo_ref& rf, const zo_string& ln){
+	zo_ref_table& tb = rf.tab();
+	tb.all_spl[rf.idx] = bad_spl;
+	tb.all_ctl[rf.idx] = ZO_NO_CTL;
+	tb.all_flag[rf.idx] = ZO_REF_BAD;
+	tb.all_prefix[rf.idx] = tb.add_text(ln);
+	tb.all_suffix[rf.idx] = zo_span{};
+	bad_spl->all_bk_ref[rf.owner->get_orig()] = rf.owner;
+}
+
+// refs to a sample that is now an sfz.
+void
+zo_orga::break_refs(zo_sample_pt sp){
+	for(const auto& sfe : sp->all_bk_ref){
+		zo_sfont_pt sf = sfe.second;
+		for(long aa = 0; aa < sf->all_ref.size(); aa++){
+			zo_ref rf{sf, aa};
+			if(rf.sref() == sp){
+				break_ref(rf, zo_string(rf.prefix()) + "sample=" + rf.get_orig_rel() + zo_string(rf.suffix()));
+			}
+		}
+	}
+	sp->all_bk_ref.clear();
+}
+
+// files get their next name. All are dropped before adding any, so names can be swapped.
+void
+zo_orga::rename_files(zo_ptsfont_vec& all_sf, zo_ptsample_vec& all_sp){
+	std::vector<bool> all_sel_sf;
+	std::vector<bool> all_sel_sp;
+	for(zo_sfont_pt sf : all_sf){
+		all_sel_sf.push_back(drop_soundfont(sf));
+	}
+	for(zo_sample_pt sp : all_sp){
+		all_sel_sp.push_back(drop_sample(sp));
+	}
+	
+	ZO_MEM_SCOPE(read_maps);
+	for(long aa = 0; aa < (long)all_sp.size(); aa++){
+		zo_sample_pt sp = all_sp[aa];
+		sp->fpth.orig_pth = sp->fpth.nxt_pth;
+		if(just_list){
+			all_gone.erase(sp->get_orig());
+			all_made.insert(sp->get_orig());
+		}
+		all_read_spl[sp->get_orig()] = sp;
+		if(all_sel_sp[aa]){
+			all_selected_spl[sp->get_orig()] = sp;
+		}
+	}
+	for(long aa = 0; aa < (long)all_sf.size(); aa++){
+		zo_sfont_pt sf = all_sf[aa];
+		sf->fpth.orig_pth = sf->fpth.nxt_pth;
+		if(just_list){
+			all_gone.erase(sf->get_orig());
+			all_made.insert(sf->get_orig());
+		}
+		all_read_sfz[sf->get_orig()] = sf;
+		if(all_sel_sf[aa] || sf->cmd_sel){
+			all_selected_sfz[sf->get_orig()] = sf;
+		}
+		for(long bb = 0; bb < sf->all_ref.size(); bb++){
+			zo_ref rf{sf, bb};
+			rf.sref()->all_bk_ref[sf->get_orig()] = sf;
+		}
+	}
+}
+
+void
+zo_orga::organizer_main(const zo_str_vec& args){
+	if(! get_args(args)){
+		fprintf(stderr, "Doing_nothing\n");
+		return;
+	}
+	fprintf(stderr, "Starting\n");
+	{
+		zo_phase_timer tmr(zo_phase::total);
+		run_action();
+		save_snapshot();
+	}
+	ZO_LOGGER.flush();
+	ZO_PROGRESS.stop();
+	ZO_TRACE.finish();
+	write_stats();
+}
+
+void
+zo_orga::print_conflicts(){
+	if(tot_conflict == 0){
+		return;
+	}
+	if(! all_conflict.empty()){
+		fprintf(stderr, "Conflicts would be solved with the following names\n");
+		for(auto nm : all_conflict){
+			fprintf(stderr, "%s\n", nm.c_str());
+		}
+	}
+	fprintf(stderr, "Found %ld conflicts. Use --force_action to execute\n", tot_conflict);
+}
+
+void
+zo_orga::run_action(){
+	if(! apply_nam.empty()){
+		apply_plan();
+		return;
+	}
+	if(! all_step.empty()){
+		run_chain();
+		return;
+	}
+	if(can_pipeline()){
+		run_pipeline();
+		return;
+	}
+	if(can_stream()){
+		run_stream();
+		return;
+	}
+	{
+		zo_phase_timer tmr(zo_phase::read_selected);
+		scan_selected();
+	}
+	run_oper();
+}
+
+// prepares oper for the selected files, then prints or does its actions.
+// Conflicts without --force_action set just_list.
+void
+zo_orga::run_oper(){
+	zo_orga& org = *this;
+	{
+		zo_phase_timer tmr(zo_phase::prepare);
+		if(oper == zo_action::normalize){
+			prepare_normalize();
+		}
+		if(oper == zo_action::add_sfz){
+			prepare_add_sfz_ext();
+		}
+		if(oper == zo_action::purge){
+			prepare_purge();
+		}
+		if(oper == zo_action::copy){
+			prepare_copy_or_move();
+		}
+		if(oper == zo_action::move){
+			prepare_copy_or_move();
+		}
+	}
+	
+	if((tot_conflict > 0) && ! force_action){
+		just_list = true;
+	}
+	if(! save_nam.empty()){
+		save_plan();
+	}
+	
+	if(just_list){
+		fprintf(stderr, "Just_printing_actions\n");
+		{
+			zo_phase_timer tmr(zo_phase::print_actions);
+			print_actions(org);
+		}
+		print_conflicts();
+		fprintf(stderr, "Doing_nothing.\n");
+		return;
+	}
+	
+	ZO_CK(oper != zo_action::nothing);
+	ZO_STAT_ADD(actions_total, (long)(all_selected_sfz.size() + all_selected_spl.size()));
+	zo_phase_timer tmr(zo_phase::do_actions);
+	do_actions(org);
+}
+
+// --save-plan. Files that change, with the sfz lines to rewrite.
+void
+zo_orga::save_plan(){
+	if((tot_conflict > 0) && ! force_action){
+		fprintf(stderr, "Not saving plan '%s' with conflicts. Use --force_action to save it\n", save_nam.c_str());
+		return;
+	}
+	zo_saved_plan pln;
+	pln.action = get_action_str(oper);
+	pln.keep = (pol == zo_policy::keep);
+	pln.from = dir_from;
+	for(const auto& sfe : all_selected_sfz){
+		zo_sfont_pt sf = sfe.second;
+		if(sf->is_same() || sf->get_next().empty()){
+			continue;
+		}
+		zo_saved_file fl;
+		fl.is_sfz = true;
+		fl.orig = sf->get_orig();
+		fl.nxt = sf->get_next();
+		if(! fl.set_stat()){
+			ZO_MSG(error, "Cannot stat file:'%s'\n", fl.orig.c_str());
+			continue;
+		}
+		sf->save_lines(fl);
+		pln.all_file.push_back(std::move(fl));
+	}
+	for(const auto& sme : all_selected_spl){
+		zo_sample_pt sm = sme.second;
+		if(sm->is_same()){
+			continue;
+		}
+		zo_saved_file fl;
+		fl.orig = sm->get_orig();
+		fl.nxt = sm->get_next();
+		if(! fl.set_stat()){
+			ZO_MSG(error, "Cannot stat file:'%s'\n", fl.orig.c_str());
+			continue;
+		}
+		pln.all_file.push_back(std::move(fl));
+	}
+	if(! pln.save(save_nam)){
+		fprintf(stderr, "Could not save plan '%s'\n", save_nam.c_str());
+		return;
+	}
+	fprintf(stderr, "Saved plan '%s' with %ld files\n", save_nam.c_str(), (long)pln.all_file.size());
+}
+
+// zo_sfont::do_actions for a saved sfz.
+void
+zo_orga::apply_saved_sfz(zo_saved_file& fl){
+	ZO_STAT_INC(actions_done);
+	zo_path nxt = fl.nxt;
+	ZO_VFS->create_directories(nxt.parent_path());
+	
+	if((fl.orig != fl.nxt) && ZO_VFS->exists(nxt) && (pol == zo_policy::keep)){
+		ZO_EVENT(plan, "KEEPING_EXISTING_FILE", nxt.c_str());
+		return;
+	}
+	
+	zo_string tmp = get_temp_path();
+	if(! fl.rewrite){
+		zo_copy_file(fl.orig, tmp);
+	} else {
+		zo_istream_pt src_pt = ZO_VFS->open_read(fl.orig);
+		if(! src_pt){
+			ZO_MSG(error, "Cannot open file:'%s'\n", fl.orig.c_str());
+			std::cerr << "Error: " << strerror(errno) << "\n\n";
+			exit(0);
+		}
+		zo_ostream_pt dst_pt = ZO_VFS->open_write(tmp);
+		if(! dst_pt){
+			ZO_MSG(error, "Cannot open file:'%s'\n", tmp.c_str());
+			std::cerr << "Error: " << strerror(errno) << "\n\n";
+			exit(0);
+		}
+		std::istream& src = *src_pt;
+		std::ostream& dst = *dst_pt;
+		auto it_ln = fl.all_line.begin();
+		long lnum = 0;
+		long tot_bytes = 0;
+		zo_string ln;
+		for(;getline(src, ln);){
+			lnum++;
+			tot_bytes += ln.size() + 1;
+			if((it_ln != fl.all_line.end()) && (it_ln->lnum == lnum)){
+				dst << it_ln->txt;
+				it_ln++;
+				continue;
+			}
+			dst << ln << '\n';
+		}
+		ZO_STAT_ADD(bytes_read, tot_bytes);
+		ZO_STAT_ADD(bytes_written, (long)dst.tellp());
+	}
+	if(is_move()){
+		ZO_VFS->remove(fl.orig);
+		ZO_STAT_INC(files_moved);
+	} else {
+		ZO_STAT_INC(files_copied);
+	}
+	ZO_VFS->rename(tmp, nxt);
+}
+
+// --apply-plan. Only the files of the plan are checked. Nothing is done if any changed.
+void
+zo_orga::apply_plan(){
+	zo_saved_plan pln;
+	if(! pln.load(apply_nam)){
+		fprintf(stderr, "Doing_nothing.\n");
+		return;
+	}
+	oper = zo_action::nothing;
+	for(zo_action ac : {zo_action::move, zo_action::copy, zo_action::purge, zo_action::normalize, zo_action::add_sfz}){
+		if(pln.action == get_action_str(ac)){
+			oper = ac;
+		}
+	}
+	if(oper == zo_action::nothing){
+		fprintf(stderr, "Invalid action '%s' in plan '%s'\n", pln.action.c_str(), apply_nam.c_str());
+		return;
+	}
+	pol = (pln.keep)?(zo_policy::keep):(zo_policy::replace);
+	dir_from = pln.from;
+	tmp_pth = dir_from / tmp_nam;
+	ZO_MSG(info, "Applying plan '%s': %s of %ld files\n", apply_nam.c_str(), pln.action.c_str(), (long)pln.all_file.size());
+	
+	long tot_stale = 0;
+	for(auto& fl : pln.all_file){
+		if(fl.is_stale()){
+			fprintf(stderr, "CHANGED_SINCE_PLANNED '%s'\n", fl.orig.c_str());
+			tot_stale++;
+		}
+	}
+	if(tot_stale > 0){
+		fprintf(stderr, "Found %ld files changed since the plan was saved. Plan again\n", tot_stale);
+		fprintf(stderr, "Doing_nothing.\n");
+		return;
+	}
+	
+	if(just_list){
+		fprintf(stderr, "Just_printing_actions\n");
+		zo_phase_timer tmr(zo_phase::print_actions);
+		for(auto& fl : pln.all_file){
+			zo_fname fnm;
+			fnm.orig_pth = fl.orig;
+			fnm.nxt_pth = fl.nxt;
+			fnm.print_actions(*this, false);
+		}
+		fprintf(stderr, "Doing_nothing.\n");
+		return;
+	}
+	
+	ZO_STAT_ADD(actions_total, (long)pln.all_file.size());
+	zo_phase_timer tmr(zo_phase::do_actions);
+	ZO_VFS->create_directories(tmp_pth.parent_path());
+	for(auto& fl : pln.all_file){
+		if(fl.is_sfz){
+			apply_saved_sfz(fl);
+			continue;
+		}
+		zo_sample sm{fl.orig};
+		sm.fpth.nxt_pth = fl.nxt;
+		sm.do_actions(*this);
+	}
+}
+
+void
+zo_orga::write_stats(){
+	if(stats_nam.empty()){
+		return;
+	}
+	zo_string extra = "\"action\": " + zo_json_str(get_action_str(oper)) + 
+		",\n\"just_list\": " + ((just_list)?("true"):("false")) + 
+		",\n\"from\": " + zo_json_str(dir_from) + 
+		",\n\"vfs\": " + zo_json_str(ZO_VFS->get_name());
+	if(ZO_MEM.is_on){
+		extra += ",\n" + ZO_MEM.get_json();
+	}
+	if(! ZO_STATS.write_json(stats_nam, extra)){
+		fprintf(stderr, "Could not write stats '%s'\n", stats_nam.c_str());
+	}
+}
+
+void
+zo_orga::save_snapshot(){
+	if(! dir_snap.is_active()){
+		return;
+	}
+	fprintf(stderr, "Snapshot: %ld directories reused, %ld listed, %ld too recent to trust\n", 
+			dir_snap.tot_reused, dir_snap.tot_listed, dir_snap.tot_racy);
+	if(! dir_snap.save()){
+		fprintf(stderr, "Could not save snapshot '%s'\n", dir_snap.fnam.c_str());
+	}
+}
+
+void
+zo_fname::calc_next(zo_orga& org, bool cmd_sel, bool can_mv){
+	zo_phase_timer tmr(zo_phase::calc_next, false);
+	zo_next_cand cnd;
+	calc_candidate(org, cmd_sel, can_mv, cnd);
+	set_next(org, cnd);
+}
+
+// the next path before solving conflicts. Only reads org, so it can run in any thread.
+void
+zo_fname::calc_candidate(zo_orga& org, bool cmd_sel, bool can_mv, zo_next_cand& cnd){
+	ZO_CK(nxt_pth.empty());
+	std::error_code ec;
+	zo_path pth = orig_pth;
 	zo_path dir_pth = pth.parent_path();
 	zo_path rel_dir = find_relative(dir_pth, org.dir_from, ec);
 	ZO_CK(! ec);
@@ -1625,12 +3893,30 @@ zo_fname::calc_next(zo_orga& org, bool cmd_sel, bool can_mv){
 		nm = std::regex_replace(nm, org.match_rx, org.subst_str);
 	}
 	
+	cnd.dr_to = dr_to;
+	cnd.rel_dir = rel_dir;
+	cnd.nm = nm;
+}
+
+// adds _cN to the candidate while it is taken by a file set before.
+// Without may_cfl the candidate is known to be free and it is not kept in all_unique_nxt.
+void
+zo_fname::set_next(zo_orga& org, zo_next_cand& cnd, bool may_cfl){
+	ZO_CK(nxt_pth.empty());
+	const zo_path& dr_to = cnd.dr_to;
+	const zo_path& rel_dir = cnd.rel_dir;
+	zo_string& nm = cnd.nm;
 	zo_path nx_pth = dr_to / rel_dir / nm;
+	if(! may_cfl){
+		nxt_pth = nx_pth;
+		return;
+	}
 	
 	zo_last_confl_pt the_cfl = zo_null;
 	auto it = org.all_unique_nxt.find(nx_pth);
 	while(it != org.all_unique_nxt.end()){
 		org.tot_conflict++;
+		ZO_STAT_INC(conflicts);
 		is_confl = true;
 		if(org.skip_normalize){
 			return;
@@ -1658,20 +3944,41 @@ zo_fname::calc_next(zo_orga& org, bool cmd_sel, bool can_mv){
 		the_cfl = make_last_confl_pt();
 		ZO_CK(the_cfl->val == 0);
 	}
+	ZO_MEM_SCOPE(next_names);
 	org.all_unique_nxt[nx_pth] = the_cfl;
 	nxt_pth = nx_pth;
 	//fprintf(stdout, "calc_next. %s->%s\n", orig_pth.c_str(), nxt_pth.c_str()); // dbg_prt
 }
 
+// same as all refs is_same, without visiting them.
 bool
 zo_sfont::is_same(){
-	bool same_nm = fpth.is_same();
-	bool all_sm = true;
-	for(zo_ref_pt ii : all_ref){ 
-		ZO_CK(ii != zo_null);
-		all_sm = all_sm && ii->is_same();
+	return (fpth.is_same() && (tot_diff_ref == 0) && ! spl_dirty);
+}
+
+// once the refs are read. Samples planned later call mark_refs_dirty.
+void
+zo_sfont::count_diff_refs(){
+	tot_diff_ref = 0;
+	for(long aa = 0; aa < all_ref.size(); aa++){ 
+		zo_ref ii{this, aa};
+		ZO_CK(ii.sref() != zo_null);
+		if(ii.has_diff_line()){
+			tot_diff_ref++;
+		}
+		if(! ii.sref()->is_same()){
+			spl_dirty = true;
+		}
+	}
+}
+
+void
+zo_sample::mark_refs_dirty(){
+	for(const auto& sfe : all_bk_ref){
+		zo_sfont_pt sf = sfe.second;
+		ZO_CK(sf != zo_null);
+		sf->spl_dirty = true;
 	}
-	return (all_sm && same_nm);
 }
 
 zo_fname& 
@@ -1682,9 +3989,9 @@ zo_ref::sf_name(){
 
 bool
 zo_ref::is_same(){
-	bool sm = prefix.empty() && suffix.empty() && bad_pth.empty() && ! fixed;
-	ZO_CK(sref != zo_null);
-	return (sm && sref->is_same() && sf_name().is_same());
+	bool sm = ! has_diff_line();
+	ZO_CK(sref() != zo_null);
+	return (sm && sref()->is_same() && sf_name().is_same());
 }
 
 zo_string ZO_COMMENT_STR = "//";
@@ -1701,30 +4008,133 @@ fix_seps_path(zo_string& pth){
 	return (pth != old);
 }
 
+// splits a line (without comment) with a sample or default_path opcode.
+bool
+split_path_line(const zo_string& ln, bool& is_sample, bool& is_ctl_pth, 
+				zo_string& lprefix, zo_string& lref, zo_string& lsuffix)
+{
+	std::smatch opcode_matches;
+	bool has_pth = false;
+	{
+		ZO_MEM_SCOPE(regex);
+		has_pth = regex_search(ln, opcode_matches, ZO_PATH_LINE_PATTERN);
+	}
+	if(! has_pth){
+		return false;
+	}
+	
+	//fprintf(stdout, "> %s\n", ln.c_str()); // dbg_prt
+	zo_string opcod = ln;
+	is_sample = false;
+	is_ctl_pth = false;
+	
+	for(long aa = 0; aa < (long)opcode_matches.size(); aa++){
+		zo_string m0 = opcode_matches[aa];
+		//fprintf(stdout, "OPCODE_+%ld:%s\n", aa, m0.c_str()); // dbg_prt
+		if(m0 == ZO_SAMPLE_STR){
+			is_sample = true;
+		}
+		if(m0 == ZO_DEFAULT_PATH_STR){
+			is_ctl_pth = true;
+		}
+	}
+	lprefix = opcode_matches.prefix().str();
+	opcod = opcode_matches.suffix().str();
+	
+	ZO_CK(is_sample || is_ctl_pth);
+	
+	lsuffix = "";
+	if(regex_search(opcod, opcode_matches, ZO_GEN_OPCODE_PATTERN)){
+		opcod = opcode_matches.prefix().str();
+		zo_string m0 = opcode_matches[0];
+		lsuffix = m0 + opcode_matches.suffix().str();
+		//fprintf(stdout, "SUFFIX_%s\n", m0.c_str()); // dbg_prt
+	}
+	lref = opcod;
+	trim(lref);
+	return true;
+}
+
+// a pipelined sfz is not used after its actions.
+void
+zo_sfont::free_opcodes(){
+	for(zo_control_path_pt ctl : all_ctl){
+		delete ctl;
+	}
+	all_ref.clear();
+	all_ctl.clear();
+	tot_diff_ref = 0;
+}
+
+// paths of the samples referenced by an sfz text, as get_opcodes passes them to canonical.
+void
+zo_get_ref_paths(std::istream& istm, const zo_string& sfz_dir, std::vector<zo_string>& all_pth){
+	zo_path pnt_fl = sfz_dir;
+	bool in_ctl = false;
+	zo_string def_path = "";
+	zo_string ln;
+	for(;getline(istm, ln);){
+		std::size_t pos_str = ln.find(ZO_COMMENT_STR);
+		if(pos_str != std::string::npos){
+			ln = ln.substr(0, pos_str);
+		}
+		if(ln.find(ZO_CONTROL_STR) != std::string::npos){
+			in_ctl = true;
+			def_path = "";
+			continue;
+		}
+		zo_string lprefix, lref, lsuffix;
+		bool is_sample = false;
+		bool is_ctl_pth = false;
+		if(! split_path_line(ln, is_sample, is_ctl_pth, lprefix, lref, lsuffix)){
+			continue;
+		}
+		fix_seps_path(lref);
+		if(is_sample){
+			if(in_ctl && ! def_path.empty()){
+				lref = def_path + lref;
+			}
+			all_pth.push_back(fs::absolute(lref, pnt_fl));
+		}
+		if(is_ctl_pth && in_ctl && def_path.empty()){
+			def_path = lref;
+		}
+	}
+}
+
 void
 zo_sfont::get_opcodes(zo_orga& org){
-	zo_sfont_pt fl = this;
-	std::ifstream istm;
-	zo_path fl_orig = fl->get_orig();
-	istm.open(fl_orig.c_str(), std::ios::binary);
-	if(! istm.good() || ! istm.is_open()){
-		fprintf(stdout, "Cannot open file:'%s'\n", fl_orig.c_str());
+	zo_phase_timer tmr(zo_phase::parse_sfz, false);
+	zo_sfz_text txt;
+	parse_opcodes(txt);
+	add_opcodes(org, txt);
+}
+
+// reads the lines get_opcodes needs. Does not touch the zo_orga so it can run in any thread.
+void
+zo_sfont::parse_opcodes(zo_sfz_text& txt){
+	ZO_STAT_INC(sfz_parsed);
+	zo_path fl_orig = get_orig();
+	zo_trace_span spn("get_opcodes", "read", fl_orig);
+	zo_istream_pt istm = ZO_VFS->open_read(fl_orig);
+	if(! istm){
+		ZO_MSG(error, "Cannot open file:'%s'\n", fl_orig.c_str());
 		std::cerr << "Error: " << strerror(errno) << "\n\n";
 		exit(0);
 		//ZO_CK(false);
 		//throw sfz_exception(sfz_cannot_open, fl_orig);
 	}
 	
-	tot_spl_ref = 0;
-	
-	std::smatch sample_matches;
-	std::smatch opcode_matches;
+	zo_path pnt_fl = fl_orig.parent_path();
+	bool in_ctl = false;
+	zo_string def_path = "";
 	long lnum = 0;
 	zo_string ln;
 	std::size_t pos_str;
-	zo_control_path_pt curr_ctl = zo_null;
-	for(;getline(istm, ln);){
+	long tot_bytes = 0;
+	for(;getline(*istm, ln);){
 		lnum++;
+		tot_bytes += ln.size() + 1;
 		
 		zo_string cmmt = "";
 		pos_str = ln.find(ZO_COMMENT_STR);
@@ -1737,48 +4147,22 @@ zo_sfont::get_opcodes(zo_orga& org){
 		}
 		pos_str = ln.find(ZO_CONTROL_STR);
 		if(pos_str != std::string::npos){
-			curr_ctl = make_control_pt();
-			curr_ctl->num_line_ctl = lnum;
-			all_ctl.push_back(curr_ctl);
+			txt.all_line.emplace_back();
+			txt.all_line.back().kind = zo_sfz_ln::control;
+			txt.all_line.back().lnum = lnum;
+			in_ctl = true;
+			def_path = "";
 			continue;
 		}
 		
-		if(! regex_search(ln, opcode_matches, ZO_PATH_LINE_PATTERN)){
-			continue;
-		}
-		
-		//fprintf(stdout, "> %ld:%s\n", lnum, ln.c_str()); // dbg_prt
 		zo_string lprefix = "";
 		zo_string lref = "";
 		zo_string lsuffix = "";
-		
-		zo_string opcod = ln;
 		bool is_sample = false;
 		bool is_ctl_pth = false;
-		
-		for(long aa = 0; aa < (long)opcode_matches.size(); aa++){
-			zo_string m0 = opcode_matches[aa];
-			//fprintf(stdout, "OPCODE_+%ld:%s\n", aa, m0.c_str()); // dbg_prt
-			if(m0 == ZO_SAMPLE_STR){
-				is_sample = true;
-			}
-			if(m0 == ZO_DEFAULT_PATH_STR){
-				is_ctl_pth = true;
-			}
-		}
-		lprefix = opcode_matches.prefix().str();
-		opcod = opcode_matches.suffix().str();
-		
-		ZO_CK(is_sample || is_ctl_pth);
-		
-		if(regex_search(opcod, opcode_matches, ZO_GEN_OPCODE_PATTERN)){
-			opcod = opcode_matches.prefix().str();
-			zo_string m0 = opcode_matches[0];
-			lsuffix = m0 + opcode_matches.suffix().str();
-			//fprintf(stdout, "SUFFIX_%s\n", m0.c_str()); // dbg_prt
+		if(! split_path_line(ln, is_sample, is_ctl_pth, lprefix, lref, lsuffix)){
+			continue;
 		}
-		lref = opcod;
-		trim(lref);
 		
 		lsuffix += cmmt;
 		
@@ -1789,126 +4173,185 @@ zo_sfont::get_opcodes(zo_orga& org){
 		//fprintf(stdout, "lsuffix:'%s'\n", lsuffix.c_str()); // dbg_prt
 		
 		if(is_sample){
-			if((curr_ctl != zo_null) && ! curr_ctl->def_path.empty()){
-				ZO_CK(! all_ctl.empty());
-				ZO_CK(all_ctl.back() == curr_ctl);
-				lref = curr_ctl->def_path + lref;
+			if(in_ctl && ! def_path.empty()){
+				lref = def_path + lref;
 				fixed = true;
 			}
 			
 			auto ec = std::error_code{};
-			
-			zo_path pnt_fl = fl_orig.parent_path();
-			zo_path fx_pth = fs::canonical(fs::absolute(lref, pnt_fl), ec);
+			zo_string fx_pth = ZO_VFS->canonical(fs::absolute(lref, pnt_fl), ec);
 			//fprintf(stdout, "fx_pth:'%s'\n", fx_pth.c_str()); // dbg_prt
 			
+			txt.all_line.emplace_back();
+			zo_sfz_line& sl = txt.all_line.back();
+			sl.kind = zo_sfz_ln::sample;
+			sl.lnum = lnum;
+			sl.ln = ln;
+			sl.prefix = lprefix;
+			sl.pth = fx_pth;
+			sl.suffix = lsuffix;
+			sl.fixed = fixed;
+			sl.bad_pth = (bool)ec;
+		}
+		
+		if(is_ctl_pth){
+			txt.all_line.emplace_back();
+			zo_sfz_line& sl = txt.all_line.back();
+			sl.kind = zo_sfz_ln::default_path;
+			sl.lnum = lnum;
+			sl.ln = ln;
+			sl.prefix = lprefix;
+			sl.pth = lref;
+			sl.suffix = lsuffix;
+			sl.fixed = fixed;
+			if(in_ctl && def_path.empty()){
+				def_path = lref;
+			}
+		}
+	}
+	ZO_STAT_ADD(bytes_read, tot_bytes);
+}
+
+// creates the controls, refs and samples of the lines read by parse_opcodes.
+void
+zo_sfont::add_opcodes(zo_orga& org, zo_sfz_text& txt){
+	zo_sfont_pt fl = this;
+	zo_path fl_orig = fl->get_orig();
+	
+	tot_spl_ref = 0;
+	
+	long tot_ref = 0;
+	long tot_txt = 0;
+	for(zo_sfz_line& sl : txt.all_line){
+		if(sl.kind == zo_sfz_ln::sample){
+			tot_ref++;
+			tot_txt += (sl.bad_pth)?(sl.ln.size()):(sl.prefix.size() + sl.suffix.size());
+		}
+	}
+	all_ref.reserve(tot_ref, tot_txt);
+	
+	zo_control_path_pt curr_ctl = zo_null;
+	for(zo_sfz_line& sl : txt.all_line){
+		if(sl.kind == zo_sfz_ln::control){
+			curr_ctl = make_control_pt();
+			curr_ctl->num_line_ctl = sl.lnum;
+			all_ctl.push_back(curr_ctl);
+			continue;
+		}
+		
+		if(sl.kind == zo_sfz_ln::sample){
 			bool is_nw = false;
 			zo_sample_pt spl = zo_null;
-			if(ec){
+			if(sl.bad_pth){
 				spl = org.bad_spl;
 			} else {
-				spl = org.get_read_sample(fx_pth, is_nw);
-				ZO_CK(spl->get_orig() == fx_pth);
-				org.get_selected_sample(fx_pth, spl, is_nw, org.samples_too);
+				spl = org.get_read_sample(sl.pth, is_nw);
+				ZO_CK(spl->get_orig() == sl.pth);
+				org.get_selected_sample(sl.pth, spl, is_nw, org.samples_too);
 			}
 			ZO_CK(spl != zo_null);
 			tot_spl_ref++;
 			
-			spl->all_bk_ref[fl_orig] = fl;
+			{
+				ZO_MEM_SCOPE(bk_ref_map);
+				spl->all_bk_ref[fl_orig] = fl;
+			}
 			
-			auto nw_ref = make_ref_pt(fl, lnum, spl);
-			fl->all_ref.push_back(nw_ref);
+			long ri = all_ref.add(sl.lnum, spl);
 			
-			if(ec){
-				nw_ref->bad_pth = ln;
-				fprintf(stderr, "bad_ref_line %ld:'%s' in file %s\n", lnum, ln.c_str(), fl_orig.c_str());
+			if(sl.bad_pth){
+				ZO_STAT_INC(bad_refs);
+				all_ref.all_flag[ri] = ZO_REF_BAD;
+				all_ref.all_prefix[ri] = all_ref.add_text(sl.ln);
+				fprintf(stderr, "bad_ref_line %ld:'%s' in file %s\n", sl.lnum, sl.ln.c_str(), fl_orig.c_str());
 			} else {
-				nw_ref->prefix = lprefix;
-				nw_ref->suffix = lsuffix;
-				nw_ref->fixed = fixed;
+				ZO_STAT_INC(refs_resolved);
+				all_ref.all_prefix[ri] = all_ref.add_text(sl.prefix);
+				all_ref.all_suffix[ri] = all_ref.add_text(sl.suffix);
+				all_ref.all_flag[ri] = (sl.fixed)?(ZO_REF_FIXED):(0);
 				if(curr_ctl != zo_null){
 					ZO_CK(all_ctl.back() == curr_ctl);
-					nw_ref->ctrl = curr_ctl;
+					all_ref.all_ctl[ri] = (long)all_ctl.size() - 1;
 				}
 			}
+			continue;
 		}
 		
-		if(is_ctl_pth){
-			bool ctl_err = false;
-			if(! ctl_err && all_ctl.empty()){
-				ZO_CK(curr_ctl == zo_null);
-				fprintf(stderr, "bad_default_path_line (NOT_IN_CONTROL_HEADER) %ld:'%s' in file %s\n", lnum, ln.c_str(), fl_orig.c_str());
-				ctl_err = true;
-			} 
-			if(! ctl_err){
-				auto lst_ctl = all_ctl.back();
-				ZO_CK(lst_ctl != zo_null);
-				ZO_CK(lst_ctl == curr_ctl);
-				if(! lst_ctl->def_path.empty()){
-					fprintf(stderr, "bad_default_path_line (ALREADY_HAS_DEFAULT_PATH) %ld:'%s' in file %s\n", lnum, ln.c_str(), fl_orig.c_str());
-				} else {
-					lst_ctl->num_line = lnum;
-					lst_ctl->prefix = lprefix;
-					lst_ctl->def_path = lref;
-					lst_ctl->suffix = lsuffix;
-					lst_ctl->fixed = fixed;
-				}
+		ZO_CK(sl.kind == zo_sfz_ln::default_path);
+		bool ctl_err = false;
+		if(! ctl_err && all_ctl.empty()){
+			ZO_CK(curr_ctl == zo_null);
+			fprintf(stderr, "bad_default_path_line (NOT_IN_CONTROL_HEADER) %ld:'%s' in file %s\n", sl.lnum, sl.ln.c_str(), fl_orig.c_str());
+			ctl_err = true;
+		} 
+		if(! ctl_err){
+			auto lst_ctl = all_ctl.back();
+			ZO_CK(lst_ctl != zo_null);
+			ZO_CK(lst_ctl == curr_ctl);
+			if(! lst_ctl->def_path.empty()){
+				fprintf(stderr, "bad_default_path_line (ALREADY_HAS_DEFAULT_PATH) %ld:'%s' in file %s\n", sl.lnum, sl.ln.c_str(), fl_orig.c_str());
+			} else {
+				lst_ctl->num_line = sl.lnum;
+				lst_ctl->prefix = sl.prefix;
+				lst_ctl->def_path = sl.pth;
+				lst_ctl->suffix = sl.suffix;
+				lst_ctl->fixed = sl.fixed;
 			}
 		}
 	}
-	
+	count_diff_refs();
 }
 
 void
 zo_sfont::prepare_sfz_file(const zo_path& tmp_pth){
+	zo_trace_span spn("prepare_sfz_file", "write", get_orig());
 	if(all_ref.empty()){
-		fprintf(stdout, "JUST_COPY_FILE. all_ref.empty(). %s\n", get_orig().c_str()); // dbg_prt
-		fs::copy(get_orig(), tmp_pth);
+		ZO_MSG(debug, "JUST_COPY_FILE. all_ref.empty(). %s\n", get_orig().c_str());
+		zo_copy_file(get_orig(), tmp_pth);
 		return;
 	}
 	
-	std::ifstream src;
-	src.open(get_orig().c_str(), std::ios::binary);
-	if(! src.good() || ! src.is_open()){
-		fprintf(stdout, "Cannot open file:'%s'\n", get_orig().c_str());
+	zo_istream_pt src_pt = ZO_VFS->open_read(get_orig());
+	if(! src_pt){
+		ZO_MSG(error, "Cannot open file:'%s'\n", get_orig().c_str());
 		std::cerr << "Error: " << strerror(errno) << "\n\n";
 		exit(0);
 	}
-	std::ofstream dst;
+	std::istream& src = *src_pt;
 	zo_string tmp = tmp_pth;
-	dst.open(tmp.c_str(), std::ios::binary);
-	if(! dst.good() || ! dst.is_open()){
-		fprintf(stdout, "Cannot open file:'%s'\n", tmp.c_str());
+	zo_ostream_pt dst_pt = ZO_VFS->open_write(tmp);
+	if(! dst_pt){
+		ZO_MSG(error, "Cannot open file:'%s'\n", tmp.c_str());
 		std::cerr << "Error: " << strerror(errno) << "\n\n";
 		exit(0);
 	}
+	std::ostream& dst = *dst_pt;
 	
 	auto it_ctl = all_ctl.begin();
-	auto it_ref = all_ref.begin();
+	long ri = 0;
 	
 	std::smatch opcode_matches;
 	long lnum = 0;
+	long tot_bytes = 0;
 	zo_string ln;
 	for(;getline(src, ln);){
 		lnum++;
+		tot_bytes += ln.size() + 1;
 		
 		bool end_of_ctls = (it_ctl == all_ctl.end());
-		bool end_of_refs = (it_ref == all_ref.end());
+		bool end_of_refs = (ri == all_ref.size());
 		if(end_of_ctls && end_of_refs){
 			dst << ln << '\n';
 			//fprintf(stdout, "SAME_LINE.(end_of_ctls && end_of_refs). %s\n", ln.c_str()); // dbg_prt
 			continue;
 		}
 		zo_control_path_pt ctl = zo_null;
-		zo_ref_pt ref = zo_null;
 		if(! end_of_ctls){
 			ctl = *it_ctl;
 		}
-		if(! end_of_refs){
-			ref = *it_ref;
-		}
+		zo_ref ref{this, ri};
 		bool is_ctl_ln = ((ctl != zo_null) && (ctl->num_line == lnum));
-		bool is_ref_ln = ((ref != zo_null) && (ref->num_line == lnum));
+		bool is_ref_ln = (! end_of_refs && (ref.num_line() == lnum));
 		ZO_CK(! (is_ctl_ln && is_ref_ln));
 		
 		if(! is_ctl_ln && ! is_ref_ln){
@@ -1924,15 +4367,107 @@ zo_sfont::prepare_sfz_file(const zo_path& tmp_pth){
 			it_ctl++;
 		}
 		if(is_ref_ln){
-			ref->write_ref(dst, ln);
-			it_ref++;
+			ref.write_ref(dst, ln);
+			ri++;
+		}
+	}
+	ZO_STAT_ADD(bytes_read, tot_bytes);
+	ZO_STAT_ADD(bytes_written, (long)dst.tellp());
+}
+
+// the refs and controls as prepare_sfz_file left them, for the next step of --actions.
+// Written lines move the ones after them. Controls after one without default_path are not written.
+void
+zo_sfont::apply_rewrite(){
+	zo_ref_table& tb = all_ref;
+	long tot_ref = tb.size();
+	long tot_ctl = (long)all_ctl.size();
+	bool ctl_on = true;
+	long ri = 0;
+	long ci = 0;
+	long delta = 0;
+	for(;;){
+		while((ci < tot_ctl) && (all_ctl[ci]->num_line == ZO_INVALID_LINE_NUM)){
+			ctl_on = false;
+			ci++;
+		}
+		bool end_of_refs = (ri == tot_ref);
+		bool end_of_ctls = (ci == tot_ctl);
+		if(end_of_refs && end_of_ctls){
+			break;
+		}
+		bool is_ctl = (! end_of_ctls && (end_of_refs || (all_ctl[ci]->num_line < tb.all_line[ri])));
+		if(is_ctl){
+			zo_control_path_pt ctl = all_ctl[ci];
+			ci++;
+			if(! ctl_on){
+				ctl->num_line += delta;
+				continue;
+			}
+			delta += (ctl->prefix.empty())?(0):(1);
+			delta += (ctl->suffix.empty())?(0):(1);
+			ctl->num_line = ZO_INVALID_LINE_NUM;
+			ctl->prefix = "";
+			ctl->def_path = "";
+			ctl->suffix = "";
+			ctl->fixed = false;
+			continue;
+		}
+		
+		zo_ref rf{this, ri};
+		ri++;
+		long lnum = rf.num_line() + delta;
+		if(rf.is_bad() || rf.is_same()){
+			tb.all_line[rf.idx] = lnum;
+			continue;
 		}
+		long pfx_ln = (rf.prefix().empty())?(0):(1);
+		long sfx_ln = (rf.suffix().empty())?(0):(1);
+		tb.all_line[rf.idx] = lnum + pfx_ln;
+		tb.all_flag[rf.idx] = 0;
+		tb.all_prefix[rf.idx] = zo_span{};
+		tb.all_suffix[rf.idx] = zo_span{};
+		delta += pfx_ln + sfx_ln;
+	}
+}
+
+// --save-plan. The text prepare_sfz_file writes for each changed line.
+void
+zo_sfont::save_lines(zo_saved_file& fl){
+	if(all_ref.empty()){
+		return;
 	}
+	fl.rewrite = true;
 	
+	std::vector<zo_saved_line> all_ctl_ln;
+	for(const auto& ctl : all_ctl){
+		if(ctl->num_line == ZO_INVALID_LINE_NUM){
+			break;	// prepare_sfz_file stops writing controls here
+		}
+		std::ostringstream dst;
+		ctl->write_default_path(dst);
+		all_ctl_ln.push_back(zo_saved_line{ctl->num_line, dst.str()});
+	}
+	auto it_ctl = all_ctl_ln.begin();
+	for(long aa = 0; aa < all_ref.size(); aa++){
+		zo_ref rf{this, aa};
+		if(rf.is_bad() || rf.is_same()){
+			continue;
+		}
+		for(; (it_ctl != all_ctl_ln.end()) && (it_ctl->lnum < rf.num_line()); it_ctl++){
+			fl.all_line.push_back(*it_ctl);
+		}
+		std::ostringstream dst;
+		rf.write_ref(dst, "");
+		fl.all_line.push_back(zo_saved_line{rf.num_line(), dst.str()});
+	}
+	for(; it_ctl != all_ctl_ln.end(); it_ctl++){
+		fl.all_line.push_back(*it_ctl);
+	}
 }
 
 void 
-zo_control_path::write_default_path(std::ofstream& dst){
+zo_control_path::write_default_path(std::ostream& dst){
 	if(! prefix.empty()){
 		//fprintf(stdout, "WRITING_PREFIX_DEF_PTH. %s\n", prefix.c_str()); // dbg_prt
 		dst << prefix << '\n';
@@ -38,6 +38,20 @@ sfz_org.h
 #define SFZ_ORG_H
 
 #include "dbg_util.h"
+#include "zo_scan.h"
+#include "zo_ignore.h"
+#include "zo_snapshot.h"
+#include "zo_saved_plan.h"
+#include "zo_stats.h"
+#include "zo_progress.h"
+#include "zo_log.h"
+#include "zo_mem.h"
+#include "zo_vfs.h"
+#include "zo_prefetch.h"
+#include "zo_uring.h"
+#include "zo_pool.h"
+#include "zo_dir_trie.h"
+#include "zo_spill.h"
 
 #ifdef HAS_FILESYSTEM
 #include <filesystem>
@@ -47,9 +61,11 @@ namespace fs = std::filesystem;
 namespace fs = std::experimental::filesystem;
 #endif
 
+#include <string_view>
 #include <vector>
 #include <map>
 #include <set>
+#include <regex>
 
 typedef enum {
 	sfz_cannot_open,
@@ -80,6 +96,7 @@ public:
 };
 
 using zo_str_vec = std::vector<std::string>;
+using zo_string_view = std::string_view;
 
 //======================================================================
 // zo_ref
@@ -108,6 +125,7 @@ enum class zo_action {
 	add_sfz
 };
 
+inline
 zo_string get_action_str(zo_action ac){
 	switch(ac){
 		case zo_action::nothing:
@@ -128,6 +146,17 @@ zo_string get_action_str(zo_action ac){
 	return "invalid_action";
 }
 
+void zo_copy_file(const zo_path& orig, const zo_path& dest, bool replace = false);
+
+void normalize_name(zo_string& nm);
+void set_num_name(zo_string& nm, long val);
+bool fix_seps_path(zo_string& pth);
+bool split_path_line(const zo_string& ln, bool& is_sample, bool& is_ctl_pth, 
+				zo_string& lprefix, zo_string& lref, zo_string& lsuffix);
+void zo_get_ref_paths(std::istream& istm, const zo_string& sfz_dir, std::vector<zo_string>& all_pth);
+zo_path find_relative(const zo_path& pth, const zo_path& base, std::error_code& ec, bool do_checks = true);
+const zo_string get_rel_sample_path(zo_path& sf_pth, zo_path& rf_pth, std::error_code& ec, bool do_checks);
+
 enum class zo_policy {
 	replace,
 	keep
@@ -156,27 +185,64 @@ is_move_oper(zo_action act){
 }
 
 using zo_control_path_pt = zo_control_path*;
-using zo_ref_pt = zo_ref*;
 using zo_sfont_pt = zo_sfont*;
 using zo_sample_pt = zo_sample*;
 
+// next path of a file before solving conflicts.
+class zo_next_cand {
+public:
+	zo_path 	dr_to{""};
+	zo_path 	rel_dir{""};
+	zo_string 	nm{""};
+};
+
 class zo_fname {
 public:
 	zo_string 	orig_pth{""};
 	zo_string 	nxt_pth{""};
 	bool 		is_confl{false};
+	bool 		done{false};	// the planned action was done
 
 	void print_actions(zo_orga& org, bool only_orig);
 	void keep_same(){
 		nxt_pth = orig_pth;
 	}
 	void calc_next(zo_orga& org, bool cmd_sel, bool can_mv = true);
+	void calc_candidate(zo_orga& org, bool cmd_sel, bool can_mv, zo_next_cand& cnd);
+	void set_next(zo_orga& org, zo_next_cand& cnd, bool may_cfl = true);
+	
+	void reset(){
+		nxt_pth = "";
+		is_confl = false;
+		done = false;
+	}
 	
 	bool is_same(){
 		return (nxt_pth.empty() || (orig_pth == nxt_pth));
 	}
 };
 
+class zo_plan_item {
+public:
+	zo_fname* 		fnm{zo_null};
+	zo_sample_pt 	spl{zo_null};	// marks its sfz dirty when its name changes
+	bool 			cmd_sel{false};
+	bool 			can_mv{true};
+	zo_next_cand 	cnd;
+	
+	zo_plan_item(zo_fname* fn, bool sel, bool mv = true){
+		fnm = fn;
+		cmd_sel = sel;
+		can_mv = mv;
+	}
+};
+
+using zo_plan_vec = std::vector<zo_plan_item>;
+
+constexpr long ZO_PLAN_CHUNK_SZ = 64;	// items per --plan_threads job
+constexpr long ZO_EXT_BLOCK_SZ = 64 * 1024;	// items with a candidate in memory with --external_conflicts
+constexpr long ZO_EXT_RUN_BYTES = 64 * 1024 * 1024;	// when no --max_memory is given
+
 class zo_control_path {
 	zo_control_path(zo_control_path& rr) = delete;
 	zo_control_path(zo_control_path&& rr) = delete;
@@ -194,43 +260,80 @@ public:
 	zo_control_path(){}
 	~zo_control_path(){}
 	
-	void write_default_path(std::ofstream& dst);
+	void write_default_path(std::ostream& dst);
 	
 };
 
-class zo_ref {
-	zo_ref(zo_ref& rr) = delete;
-	zo_ref(zo_ref&& rr) = delete;
-	zo_ref& operator = (const zo_ref& rr) = delete;
-	zo_ref& operator = (zo_ref&& rr) = delete;
+// a piece of zo_ref_table::txt.
+class zo_span {
+public:
+	uint32_t	off{0};
+	uint32_t	len{0};
+};
+
+constexpr uint8_t ZO_REF_FIXED = 0x1;
+constexpr uint8_t ZO_REF_BAD = 0x2;
+constexpr long ZO_NO_CTL = -1;
+
+// the refs of one sfz in line order, one column per field.
+// Prefix and suffix (or the whole line of a bad ref) are spans of txt.
+class zo_ref_table {
+	zo_ref_table(zo_ref_table& rr) = delete;
+	zo_ref_table(zo_ref_table&& rr) = delete;
+	zo_ref_table& operator = (const zo_ref_table& rr) = delete;
+	zo_ref_table& operator = (zo_ref_table&& rr) = delete;
 
 public:
-	zo_sfont_pt			owner = zo_null;
-	zo_control_path_pt	ctrl = zo_null;
+	std::vector<zo_sample_pt>	all_spl;
+	std::vector<long>			all_line;
+	std::vector<long>			all_ctl;	// index in zo_sfont::all_ctl or ZO_NO_CTL
+	std::vector<uint8_t>		all_flag;
+	std::vector<zo_span>		all_prefix;	// the line of a bad ref
+	std::vector<zo_span>		all_suffix;
+	zo_string					txt{""};
+	
+	zo_ref_table(){}
+	
+	long size(){
+		return (long)all_spl.size();
+	}
 	
-	long			num_line{ZO_INVALID_LINE_NUM};
-	zo_string 		prefix{""};
-	zo_sample_pt	sref = zo_null;
-	zo_string 		suffix{""};
-	bool			fixed{false};
+	bool empty(){
+		return all_spl.empty();
+	}
+	
+	zo_string_view get_text(zo_span sp){
+		return zo_string_view(txt.data() + sp.off, sp.len);
+	}
+	
+	void reserve(long tot_ref, long tot_txt);
+	long add(long lnum, zo_sample_pt spl);
+	zo_span add_text(const zo_string& str);
+	void clear();
+};
 
-	zo_string 		bad_pth{""};
+// row idx of the zo_ref_table of owner.
+class zo_ref {
+public:
+	zo_sfont_pt			owner = zo_null;
+	long				idx{0};
 	
-	zo_ref(zo_sfont_pt fl, long ln_num, zo_sample_pt rf){
+	zo_ref(zo_sfont_pt fl, long ii){
 		ZO_CK(fl != zo_null);
-		ZO_CK(rf != zo_null);
-		
 		owner = fl;
-		num_line = ln_num;
-		sref = rf;
+		idx = ii;
 	}
 	
-	~zo_ref(){
-		num_line = ZO_INVALID_LINE_NUM;
-		owner = zo_null;
-		sref = zo_null;
-		//fprintf(stdout, "Calling ~zo_ref\n");
-	}
+	zo_ref_table& tab();
+	
+	zo_sample_pt sref(){ return tab().all_spl[idx]; }
+	long num_line(){ return tab().all_line[idx]; }
+	bool fixed(){ return ((tab().all_flag[idx] & ZO_REF_FIXED) != 0); }
+	bool is_bad(){ return ((tab().all_flag[idx] & ZO_REF_BAD) != 0); }
+	zo_string_view prefix(){ return (is_bad())?(zo_string_view()):(tab().get_text(tab().all_prefix[idx])); }
+	zo_string_view suffix(){ return tab().get_text(tab().all_suffix[idx]); }
+	zo_string_view bad_pth(){ return (is_bad())?(tab().get_text(tab().all_prefix[idx])):(zo_string_view()); }
+	zo_control_path_pt ctrl();
 	
 	zo_fname& sf_name();
 	
@@ -241,12 +344,45 @@ public:
 	
 	bool is_same();
 	
-	void write_ref(std::ofstream& dst, const zo_string& ln);
+	// the line is rewritten even when no name changes.
+	bool has_diff_line(){
+		zo_ref_table& tb = tab();
+		return ((tb.all_flag[idx] != 0) || (tb.all_prefix[idx].len != 0) || (tb.all_suffix[idx].len != 0));
+	}
+	
+	void write_ref(std::ostream& dst, const zo_string& ln);
 	void print_actions(zo_orga& org);
+	void print_json();
 };
 
 using zo_pth_vec = std::vector<zo_control_path_pt>;
-using zo_ref_vec = std::vector<zo_ref_pt>;
+
+enum class zo_sfz_ln {
+	control,
+	sample,
+	default_path
+};
+
+class zo_sfz_line {
+public:
+	zo_sfz_ln 		kind{zo_sfz_ln::control};
+	long			lnum{ZO_INVALID_LINE_NUM};
+	zo_string 		ln{""};		// without comment
+	zo_string 		prefix{""};
+	zo_string 		pth{""};	// canonical sample or default_path
+	zo_string 		suffix{""};
+	bool			fixed{false};
+	bool			bad_pth{false};
+};
+
+// the lines of an sfz file that make its controls and refs.
+class zo_sfz_text {
+public:
+	zo_sfont_pt					sf{zo_null};
+	std::vector<zo_sfz_line>	all_line;
+};
+
+using zo_sfz_text_pt = zo_sfz_text*;
 
 class zo_sfont {
 	zo_sfont(zo_sfont& rr) = delete;
@@ -257,11 +393,13 @@ class zo_sfont {
 public:
 	zo_fname	fpth;
 	bool 		did_it{false};
-	zo_ref_vec	all_ref;
+	zo_ref_table	all_ref;
 	zo_pth_vec	all_ctl;
 	
 	bool 		is_txt{false};
 	long 		tot_spl_ref{0};
+	long 		tot_diff_ref{0};	// refs with has_diff_line
+	bool 		spl_dirty{false};	// a referenced sample changes name
 
 	bool 		can_move{false};
 	bool 		cmd_sel{false};
@@ -284,26 +422,35 @@ public:
 	}
 	
 	bool is_same();
+	void count_diff_refs();
 	
 	void get_samples(zo_orga& org);
 	void get_opcodes(zo_orga& org);
+	void parse_opcodes(zo_sfz_text& txt);
+	void add_opcodes(zo_orga& org, zo_sfz_text& txt);
+	void free_opcodes();
 	
 	void print_actions(zo_orga& org);	
 	void do_actions(zo_orga& org);
-	void prepare_normalize(zo_orga& org);
+	void do_actions(zo_orga& org, const zo_path& tmp);
+	void prepare_normalize(zo_plan_vec& all_itm);
 	void prepare_tmp_file(const zo_path& tmp_pth);
 	void prepare_sfz_file(const zo_path& tmp_pth);
+	void apply_rewrite();
+	void save_lines(zo_saved_file& fl);
 	
-	void prepare_add_sfz_ext(zo_orga& org);
-	void prepare_purge(zo_orga& org);
-	void prepare_copy_or_move(zo_orga& org);
+	void prepare_add_sfz_ext(zo_plan_vec& all_itm);
+	void prepare_purge(zo_plan_vec& all_itm);
+	void prepare_copy_or_move(zo_plan_vec& all_itm);
 	
 };
 
 using zo_ptsfont_vec = std::vector<zo_sfont_pt>;
+using zo_ptsample_vec = std::vector<zo_sample_pt>;
 using zo_sfont_map = std::map<zo_string, zo_sfont_pt>;
 using zo_sample_map = std::map<zo_string, zo_sample_pt>;
 using zo_file_set = std::set<zo_string>;
+using zo_sample_set = std::set<zo_sample_pt>;
 
 class zo_sample {
 	zo_sample(zo_sample& rr) = delete;
@@ -315,8 +462,12 @@ public:
 	zo_fname		fpth;
 	bool 			did_it{false};
 	zo_sfont_map	all_bk_ref;
+	long 			tot_bk_ref{0};	// with --max_memory, instead of all_bk_ref
 
 	bool 		cmd_sel{false};
+	bool 		is_txt{false};	// only read for --actions with add_sfz_ext
+	
+	zo_inode_key	ino_key;	// when known from the directory scan
 	
 	zo_sample(zo_path fl){
 		fpth.orig_pth = zo_path{fl};
@@ -338,31 +489,45 @@ public:
 		return fpth.is_same();
 	}
 	
-	void print_actions(zo_orga& org);
+	bool has_bk_ref(){
+		return (! all_bk_ref.empty() || (tot_bk_ref > 0));
+	}
+	
+	void mark_refs_dirty();
+	void print_actions(zo_orga& org, bool with_bk_ref = true);
 	void do_actions(zo_orga& org);
-	void prepare_normalize(zo_orga& org);
-	void prepare_purge(zo_orga& org);
-	void prepare_copy_or_move(zo_orga& org);
+	void copy_or_link(zo_orga& org, const zo_path& nxt);
+	void prepare_normalize(zo_plan_vec& all_itm);
+	void prepare_purge(zo_plan_vec& all_itm);
+	void prepare_copy_or_move(zo_plan_vec& all_itm);
 };
 
 
+inline
+zo_ref_table&
+zo_ref::tab(){
+	return owner->all_ref;
+}
+
+inline
+zo_control_path_pt
+zo_ref::ctrl(){
+	long ci = tab().all_ctl[idx];
+	return (ci == ZO_NO_CTL)?(zo_null):(owner->all_ctl[ci]);
+}
+
 inline 
 zo_control_path_pt
 make_control_pt(){
+	ZO_MEM_SCOPE(control);
 	return new zo_control_path();
 	//return std::make_shared<zo_control_path>();
 }
 
-inline 
-zo_ref_pt
-make_ref_pt(zo_sfont_pt fl, long lnum, zo_sample_pt spl){
-	return new zo_ref(fl, lnum, spl);
-	//return std::make_shared<zo_ref>(fl, lnum, spl);
-}
-
 inline 
 zo_sfont_pt
 make_sfont_pt(const zo_path& pth){
+	ZO_MEM_SCOPE(sfont);
 	return new zo_sfont(pth);
 	//return std::make_shared<zo_sfont>(pth);
 }
@@ -370,6 +535,7 @@ make_sfont_pt(const zo_path& pth){
 inline 
 zo_sample_pt
 make_sample_pt(const zo_path& pth){
+	ZO_MEM_SCOPE(sample);
 	return new zo_sample(pth);
 	//return std::make_shared<zo_sample>(pth);
 }
@@ -382,14 +548,30 @@ public:
 
 using zo_last_confl_pt = zo_last_confl*;
 using zo_conflict_map = std::map<zo_string, zo_last_confl_pt>;
+using zo_inode_path_map = std::map<zo_inode_key, zo_string>;
 
 inline 
 zo_last_confl_pt
 make_last_confl_pt(){
+	ZO_MEM_SCOPE(conflict);
 	return new zo_last_confl;
 }
 
 
+class zo_listed_summary {
+public:
+	long 		tot_listed{0};
+	long 		tot_read{0};
+	long 		tot_not_found{0};
+	long 		tot_dirs_skipped{0};
+	long 		tot_not_regular{0};
+	zo_str_vec	all_examples;
+	
+	void add_unsupported(long& counter, const zo_string& pth, const char* why);
+	void print(FILE* out);
+	void print_json();
+};
+
 class zo_dir {
 	zo_dir(zo_dir& rr) = delete;
 	zo_dir(zo_dir&& rr) = delete;
@@ -400,6 +582,14 @@ public:
 	zo_path 			base_pth{""};
 	
 	zo_file_set			all_to_ignore;
+	zo_ignore_rules		root_rules;		// --ignore patterns
+	zo_ignore_stack		ignore_stk;		// --ignore patterns and '.sfzignore' rules of the walk
+	zo_inode_set		all_visited_dir;
+	zo_dir_snapshot		dir_snap;
+	zo_inode_path_map	all_copied_ino;
+	std::mutex 			ino_mtx;	// all_copied_ino and all_copying_ino with --pipeline
+	std::condition_variable	ino_cv;
+	zo_inode_set		all_copying_ino;
 	
 	zo_sfont_map 		all_read_sfz;
 	zo_sample_map 		all_read_spl;
@@ -407,6 +597,10 @@ public:
 	zo_sfont_map 		all_selected_sfz;
 	zo_sample_map 		all_selected_spl;
 	
+	bool 				keep_nw_sel{false};	// --pipeline plans them as they are selected
+	zo_ptsfont_vec		all_nw_sel_sfz;
+	zo_ptsample_vec		all_nw_sel_spl;
+	
 	zo_conflict_map		all_unique_nxt;
 	zo_file_set			all_conflict;
 	long 				tot_conflict{0};
@@ -424,7 +618,7 @@ public:
 	zo_sfont_pt get_read_soundfont(const zo_path& pth, bool& is_nw){
 		is_nw = false;
 		ZO_CK(pth.is_absolute());
-		ZO_CK(fs::exists(pth));
+		ZO_CK(ZO_VFS->exists(pth));
 		auto it = all_read_sfz.find(pth);
 		if(it != all_read_sfz.end()){
 			zo_sfont_pt sfz = it->second;
@@ -433,8 +627,9 @@ public:
 			return sfz;
 		}
   
-		std::cout << "reading " << pth << "\n";
+		ZO_EVENT(info, "reading", pth.c_str(), zo_log_qt::pquote);
 		is_nw = true;
+		ZO_MEM_SCOPE(read_maps);
 		zo_sfont_pt nw_sfz = make_sfont_pt(pth);
 		all_read_sfz[pth] = nw_sfz;
 		return nw_sfz;
@@ -443,7 +638,7 @@ public:
 	zo_sample_pt get_read_sample(const zo_path& pth, bool& is_nw){
 		is_nw = false;
 		ZO_CK(pth.is_absolute());
-		ZO_CK(fs::exists(pth));
+		ZO_CK(ZO_VFS->exists(pth));
 		auto it = all_read_spl.find(pth);
 		if(it != all_read_spl.end()){
 			zo_sample_pt spl = it->second;
@@ -454,6 +649,7 @@ public:
   
 		//std::cout << "reading " << pth << "\n";
 		is_nw = true;
+		ZO_MEM_SCOPE(read_maps);
 		zo_sample_pt nw_spl = make_sample_pt(pth);
 		all_read_spl[pth] = nw_spl;
 		return nw_spl;
@@ -469,9 +665,13 @@ public:
 			return sfz;
 		}
   
-		std::cout << ">>>SELECTING " << pth << "\n";
+		ZO_EVENT(info, ">>>SELECTING", pth.c_str(), zo_log_qt::bare);
 		is_nw = true;
+		ZO_MEM_SCOPE(selected_maps);
 		all_selected_sfz[pth] = sf;
+		if(keep_nw_sel){
+			all_nw_sel_sfz.push_back(sf);
+		}
 		return sf;
 	}
 	
@@ -488,16 +688,86 @@ public:
 			return zo_null;
 		}
   
-		std::cout << ">>>SELECTING " << pth << "\n";
+		ZO_EVENT(info, ">>>SELECTING", pth.c_str(), zo_log_qt::bare);
 		is_nw = true;
+		ZO_MEM_SCOPE(selected_maps);
 		all_selected_spl[pth] = sp;
+		if(keep_nw_sel){
+			all_nw_sel_spl.push_back(sp);
+		}
 		return sp;
 	}
 	
 	void print_actions(zo_orga& org);
+	void print_bad_refs(zo_orga& org);
 	void do_actions(zo_orga& org);
 };
 
+class zo_exec_job {
+public:
+	zo_sfont_pt 	sf{zo_null};
+	zo_sample_pt 	sp{zo_null};
+};
+
+constexpr long ZO_PIPE_FLUSH_NS = 200 * 1000 * 1000;	// --pipeline with --list flushes the actions printed
+
+// --pipeline stages. The scan and the planning run in the main thread. 
+// Parsers read the sfz files and executors do the planned actions. With --list the 
+// main thread prints each planned file instead.
+class zo_pipeline {
+	zo_pipeline(zo_pipeline& rr) = delete;
+	zo_pipeline& operator = (const zo_pipeline& rr) = delete;
+
+public:
+	zo_bounded_queue<zo_sfont_pt> 		parse_q;
+	zo_bounded_queue<zo_sfz_text_pt> 	parsed_q;
+	zo_bounded_queue<zo_exec_job> 		exec_q;
+	std::vector<std::thread> 			all_parser;
+	std::vector<std::thread> 			all_executor;
+	std::atomic<long> 					tot_parser_on{0};
+	std::set<zo_sfont_pt> 				all_parsing;
+	bool 								stopped{false};	// by a conflict
+	zo_string 							confl_pth{""};
+	long 								last_flush_ns{0};
+	
+	zo_pipeline(long q_sz) : parse_q(q_sz), parsed_q(q_sz), exec_q(q_sz) {}
+};
+
+// bits of the values in zo_stream::sfz_w.
+constexpr long ZO_STRM_TXT = 0x1;
+constexpr long ZO_STRM_HAS_REF = 0x2;
+constexpr long ZO_STRM_DIFF = 0x4;
+constexpr long ZO_STRM_CMD_SEL = 0x8;
+
+constexpr long ZO_STRM_OBJ_BYTES = 1024;	// estimate for a planned file
+
+enum class zo_stm_pass {
+	plan,
+	print,
+	act
+};
+
+// --max_memory purge. The scan only adds records to the runs. Merging them, files 
+// are planned and done in batches of batch_sz, so one batch is in memory at a time.
+class zo_stream {
+	zo_stream(zo_stream& rr) = delete;
+	zo_stream& operator = (const zo_stream& rr) = delete;
+
+public:
+	zo_string 		dir{""};
+	long 			batch_sz{1};
+	zo_run_writer 	sfz_w;	// read sfz. ZO_STRM_* bits
+	zo_run_writer 	spl_w;	// selected samples
+	zo_run_writer 	ref_w;	// referenced samples
+	zo_run_writer 	bad_w;	// sfz with bad references
+	zo_run_writer 	chk_w;	// sfz found looking for references. Read later if not in sfz_w
+	
+	zo_stream(){}
+	~zo_stream();
+	
+	bool init(long max_bytes);
+};
+
 class zo_orga : public zo_dir {
 	zo_orga(zo_orga& rr) = delete;
 	zo_orga(zo_orga&& rr) = delete;
@@ -533,6 +803,23 @@ public:
 	zo_path tmp_pth{""};
 
 	zo_str_vec f_names;
+	zo_string files_from{""};	// --files-from option. '-' is stdin
+	zo_string stats_nam{""};	// --stats option
+	zo_string trace_nam{""};	// --trace option
+	zo_prefetch_vfs* pf_vfs{zo_null};	// --prefetch option
+	long pipe_thds{0};	// --pipeline option
+	long plan_thds{0};	// --plan_threads option
+	zo_pipeline* pipe{zo_null};
+	long max_mem{0};	// --max_memory option, in bytes
+	bool ext_confl{false};	// --external_conflicts option
+	bool ext_planned{false};	// names given by plan_next_external are not in all_unique_nxt
+	zo_string save_nam{""};	// --save-plan option
+	zo_string apply_nam{""};	// --apply-plan option
+	zo_stream* strm{zo_null};
+	std::vector<zo_action> all_step;	// --actions option
+	bool chain_scan{false};	// reading the files of all_step
+	zo_file_set all_gone;	// with --list, moved by an action of all_step before
+	zo_file_set all_made;
 	
 	zo_path last_pth{""};
 	bool gave_names{false};
@@ -555,10 +842,22 @@ public:
 	}
 	
 	void read_file(const zo_path& pth, const zo_ftype ft, const bool only_with_ref);
+	void read_canon_file(const zo_path& apth, const zo_ftype ft, const bool only_with_ref, const bool is_sfz, 
+						 const zo_inode_key& ino_key = zo_inode_key{});
 	void read_dir_files(zo_path pth_dir, const zo_ftype ft, const bool only_with_ref);
+	void read_canon_dir(const zo_string& pth_dir, const zo_ftype ft, const bool only_with_ref);
+	bool check_sub_dir(const zo_string& pth, const zo_dir_ent& ent);
+	void prefetch_accepted(const zo_string& pth_dir, const zo_dir_ent_vec& all_ent, bool ck_rls);
+	long push_ignore_rules(const zo_string& apth);
+	void save_snapshot();
+	void write_stats();
 	
 	void read_files(const zo_str_vec& all_pth, const zo_ftype ft);
+	void read_files_from(const zo_string& f_nam);
+	void read_listed_files(const zo_str_vec& all_pth, zo_listed_summary& summ);
+	void read_given_names();
 	void read_selected();
+	void scan_selected();
 	
 	const zo_path& get_temp_path(){
 		ZO_CK(! tmp_pth.empty());
@@ -566,14 +865,63 @@ public:
 	}
 	
 	bool calc_target(bool had_dir_to);
+	void get_log_args(const zo_str_vec& args);
+	bool get_vfs_args(const zo_str_vec& args);
 
 	void prepare_normalize();
 	void prepare_add_sfz_ext();
 	void prepare_purge();
 	void prepare_copy_or_move();
+	void plan_next(zo_plan_vec& all_itm);
+	void calc_candidates(zo_plan_vec& all_itm, long aa, long bb, zo_thread_pool* pool);
+	bool plan_next_external(zo_plan_vec& all_itm, zo_thread_pool* pool);
+	
+	bool can_pipeline();
+	void run_pipeline();
+	void pipe_parse(zo_sfont_pt sf);
+	bool pipe_add_parsed(bool wait);
+	void pipe_plan_selected();
+	void pipe_plan(zo_sfont_pt sf, zo_sample_pt sp);
+	void pipe_print(zo_sfont_pt sf, zo_sample_pt sp);
+	
+	bool can_stream();
+	void run_stream();
+	void stream_file(const zo_path& apth, const zo_ftype ft, const bool only_with_ref, const bool is_sfz);
+	void stream_sfz(const zo_string& apth, bool cmd_sel);
+	bool stream_check_sfz();
+	bool stream_batches(zo_stm_pass pss);
+	void stream_batch(zo_stm_pass pss);
+	void clear_next_names();
+	void print_conflicts();
+	
+	bool has_step(zo_action ac);
+	bool file_exists(const zo_string& pth);
+	void run_chain();
+	void reset_step();
+	void select_step(zo_sfont_map& all_sfz, zo_sample_map& all_spl);
+	bool step_applied(zo_fname& fnm, bool is_sm);
+	void apply_step(zo_sfont_map& all_sfz);
+	bool drop_soundfont(zo_sfont_pt sf);
+	bool drop_sample(zo_sample_pt sp);
+	void break_ref(zo_ref& rf, const zo_string& ln);
+	void break_refs(zo_sample_pt sp);
+	void fix_refs(zo_sfont_pt sf, zo_sample_set& all_mv, bool was_written);
+	void rename_files(zo_ptsfont_vec& all_sf, zo_ptsample_vec& all_sp);
+	
+	void save_plan();
+	void apply_saved_sfz(zo_saved_file& fl);
+	void apply_plan();
+	
+	void run_oper();
+	void run_action();
 	void organizer_main(const zo_str_vec& args);
 };
 
+int sfz_organizer_main(int argc, char* argv[]);
+int test_fix(int argc, char* argv[]);
+int test_fs(int argc, char* argv[]);
+int test_rx(int argc, char* argv[]);
+
 #endif		// SFZ_ORG_H
 
 
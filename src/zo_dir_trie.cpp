@@ -0,0 +1,137 @@
+
+
+#ifdef HAS_FILESYSTEM
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include "zo_dir_trie.h"
+#include "zo_stats.h"
+
+zo_dir_trie ZO_DIR_TRIE;
+
+constexpr zo_dir_id ZO_TRIE_NO_ID = -1;
+
+zo_dir_id
+zo_dir_trie::find_id(const zo_string& pth){
+	auto it = all_id.find(pth);
+	return (it != all_id.end())?(it->second):(ZO_TRIE_NO_ID);
+}
+
+zo_dir_id
+zo_dir_trie::intern(const zo_string& pth){
+	auto it = all_id.find(pth);
+	if(it != all_id.end()){
+		return it->second;
+	}
+	zo_dir_id id = ZO_TRIE_ROOT_ID;
+	fs::path fpth = pth;
+	for(const auto& part : fpth){
+		zo_string nm = part;
+		auto nit = all_name.find(nm);
+		if(nit == all_name.end()){
+			nit = all_name.emplace(nm, (long)all_name.size()).first;
+		}
+		zo_dir_pair ky{id, nit->second};
+		auto cit = all_child.find(ky);
+		if(cit != all_child.end()){
+			id = cit->second;
+			continue;
+		}
+		zo_dir_node nd;
+		nd.parent = id;
+		nd.depth = all_node[id].depth + 1;
+		nd.name = nm;
+		zo_dir_id nw_id = (zo_dir_id)all_node.size();
+		all_node.push_back(nd);
+		all_child[ky] = nw_id;
+		id = nw_id;
+	}
+	all_id[pth] = id;
+	return id;
+}
+
+zo_dir_id
+zo_dir_trie::get_id(const zo_string& pth){
+	{
+		std::shared_lock<std::shared_mutex> lk(mtx);
+		zo_dir_id id = find_id(pth);
+		if(id != ZO_TRIE_NO_ID){
+			return id;
+		}
+	}
+	std::unique_lock<std::shared_mutex> lk(mtx);
+	return intern(pth);
+}
+
+// same result as find_relative: '..' up to the common ancestor, then down to dir.
+zo_string
+zo_dir_trie::calc_relative(zo_dir_id dir, zo_dir_id base){
+	zo_dir_id aa = dir;
+	zo_dir_id bb = base;
+	long tot_up = 0;
+	std::vector<zo_dir_id> all_down;
+	while(all_node[aa].depth > all_node[bb].depth){
+		all_down.push_back(aa);
+		aa = all_node[aa].parent;
+	}
+	while(all_node[bb].depth > all_node[aa].depth){
+		tot_up++;
+		bb = all_node[bb].parent;
+	}
+	while(aa != bb){
+		all_down.push_back(aa);
+		aa = all_node[aa].parent;
+		tot_up++;
+		bb = all_node[bb].parent;
+	}
+	
+	fs::path result;
+	for(long ii = 0; ii < tot_up; ii++){
+		result /= "..";
+	}
+	for(auto it = all_down.rbegin(); it != all_down.rend(); it++){
+		result /= all_node[*it].name;
+	}
+	return result;
+}
+
+zo_string
+zo_dir_trie::get_relative(const zo_string& pth, const zo_string& base){
+	{
+		std::shared_lock<std::shared_mutex> lk(mtx);
+		zo_dir_pair ky{find_id(pth), find_id(base)};
+		if((ky.first != ZO_TRIE_NO_ID) && (ky.second != ZO_TRIE_NO_ID)){
+			auto it = all_rel.find(ky);
+			if(it != all_rel.end()){
+				return it->second;
+			}
+		}
+	}
+	std::unique_lock<std::shared_mutex> lk(mtx);
+	zo_dir_pair ky{intern(pth), intern(base)};
+	auto it = all_rel.find(ky);
+	if(it != all_rel.end()){
+		return it->second;	// added by another thread
+	}
+	ZO_STAT_INC(rel_paths);
+	zo_string rel = calc_relative(ky.first, ky.second);
+	all_rel[ky] = rel;
+	return rel;
+}
+
+bool
+zo_dir_trie::is_checked(const zo_string& pth){
+	std::shared_lock<std::shared_mutex> lk(mtx);
+	zo_dir_id id = find_id(pth);
+	return (id != ZO_TRIE_NO_ID) && all_node[id].checked;
+}
+
+void
+zo_dir_trie::set_checked(const zo_string& pth){
+	std::unique_lock<std::shared_mutex> lk(mtx);
+	all_node[intern(pth)].checked = true;
+}
@@ -0,0 +1,93 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+
+zo_dir_trie.h
+
+directories interned as nodes of a parent pointer trie. The relative 
+path between two directories is a walk to their lowest common ancestor,
+kept per pair of nodes. Lookups of known paths and pairs share the lock,
+so --plan_threads only wait on each other to add new ones.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_DIR_TRIE_H
+#define ZO_DIR_TRIE_H
+
+#include <shared_mutex>
+#include <map>
+#include <vector>
+#include <utility>
+
+#include "zo_scan.h"
+
+using zo_dir_id = long;
+
+constexpr zo_dir_id ZO_TRIE_ROOT_ID = 0;	// the empty path. Parent of '/'
+
+class zo_dir_node {
+public:
+	zo_dir_id 	parent{ZO_TRIE_ROOT_ID};
+	long 		depth{0};
+	zo_string 	name{""};
+	bool 		checked{false};	// known to be a directory (find_relative checks)
+};
+
+using zo_dir_pair = std::pair<zo_dir_id, zo_dir_id>;
+
+class zo_dir_trie {
+public:
+	std::shared_mutex 						mtx;
+	std::vector<zo_dir_node> 				all_node;
+	std::map<zo_dir_pair, zo_dir_id> 		all_child;	// (parent, name index) -> child
+	std::map<zo_string, long> 				all_name;
+	std::map<zo_string, zo_dir_id> 			all_id;		// whole path -> node
+	std::map<zo_dir_pair, zo_string> 		all_rel;	// (dir, base) -> relative path
+	
+	zo_dir_trie(){
+		all_node.emplace_back();
+	}
+	
+	// the same components as iterating a fs::path.
+	zo_dir_id get_id(const zo_string& pth);
+	
+	zo_string get_relative(const zo_string& pth, const zo_string& base);
+	
+	bool is_checked(const zo_string& pth);
+	void set_checked(const zo_string& pth);
+	
+private:
+	zo_dir_id find_id(const zo_string& pth);
+	zo_dir_id intern(const zo_string& pth);
+	zo_string calc_relative(zo_dir_id dir, zo_dir_id base);
+};
+
+extern zo_dir_trie ZO_DIR_TRIE;
+
+#endif		// ZO_DIR_TRIE_H
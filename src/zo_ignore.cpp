@@ -0,0 +1,290 @@
+
+
+#include <fstream>
+
+#include "zo_ignore.h"
+#include "zo_vfs.h"
+
+bool
+zo_is_glob_pattern(const zo_string& pat){
+	return (pat.find_first_of("*?[\\") != std::string::npos);
+}
+
+bool
+zo_glob_tok::in_class(char cc) const {
+	bool found = false;
+	for(size_t aa = 0; (aa + 1) < all_cls.size(); aa += 2){
+		if((all_cls[aa] <= cc) && (cc <= all_cls[aa + 1])){
+			found = true;
+			break;
+		}
+	}
+	return (found != negate);
+}
+
+static
+bool
+is_star_kind(zo_glob_tok_kind kk){
+	return ((kk == zo_glob_tok_kind::star) || (kk == zo_glob_tok_kind::dstar) ||
+			(kk == zo_glob_tok_kind::dstar_dir));
+}
+
+void
+zo_glob::compile(const zo_string& pat){
+	all_tok.clear();
+	lit_sfx = "";
+	size_t sz = pat.size();
+	for(size_t ii = 0; ii < sz; ii++){
+		char cc = pat[ii];
+		zo_glob_tok tok;
+		if((cc == '\\') && ((ii + 1) < sz)){
+			ii++;
+			tok.ch = pat[ii];
+		} else if(cc == '*'){
+			tok.kind = zo_glob_tok_kind::star;
+			if(((ii + 1) < sz) && (pat[ii + 1] == '*')){
+				ii++;
+				tok.kind = zo_glob_tok_kind::dstar;
+				if(((ii + 1) < sz) && (pat[ii + 1] == '/')){
+					ii++;
+					tok.kind = zo_glob_tok_kind::dstar_dir;
+				}
+			}
+		} else if(cc == '?'){
+			tok.kind = zo_glob_tok_kind::any;
+		} else if(cc == '['){
+			size_t jj = ii + 1;
+			bool neg = false;
+			if((jj < sz) && ((pat[jj] == '!') || (pat[jj] == '^'))){
+				neg = true;
+				jj++;
+			}
+			size_t fst = jj;
+			zo_string cls = "";
+			for(; jj < sz; jj++){
+				if((pat[jj] == ']') && (jj > fst)){
+					break;
+				}
+				char lo = pat[jj];
+				char hi = lo;
+				if(((jj + 2) < sz) && (pat[jj + 1] == '-') && (pat[jj + 2] != ']')){
+					hi = pat[jj + 2];
+					jj += 2;
+				}
+				cls += lo;
+				cls += hi;
+			}
+			if(jj < sz){
+				tok.kind = zo_glob_tok_kind::cls;
+				tok.negate = neg;
+				tok.all_cls = cls;
+				ii = jj;
+			} else {
+				tok.ch = cc;	// no closing ']'. literal '['
+			}
+		} else {
+			tok.ch = cc;
+		}
+		all_tok.push_back(tok);
+	}
+
+	for(auto it = all_tok.rbegin(); it != all_tok.rend(); it++){
+		if(it->kind != zo_glob_tok_kind::lit){
+			break;
+		}
+		lit_sfx.insert(lit_sfx.begin(), it->ch);
+	}
+}
+
+static
+void
+add_state(const std::vector<zo_glob_tok>& all_tok, std::vector<uint8_t>& all_st, size_t ii){
+	size_t mm = all_tok.size();
+	for(; ii <= mm; ii++){
+		if(all_st[ii]){
+			return;
+		}
+		all_st[ii] = 1;
+		if((ii == mm) || ! is_star_kind(all_tok[ii].kind)){
+			return;
+		}
+	}
+}
+
+bool
+zo_glob::match(const zo_string& str) const {
+	if(! lit_sfx.empty()){
+		if(str.size() < lit_sfx.size()){
+			return false;
+		}
+		if(str.compare(str.size() - lit_sfx.size(), lit_sfx.size(), lit_sfx) != 0){
+			return false;
+		}
+	}
+
+	size_t mm = all_tok.size();
+	std::vector<uint8_t> curr(mm + 1, 0);
+	std::vector<uint8_t> nxt(mm + 1, 0);
+	add_state(all_tok, curr, 0);
+
+	for(char cc : str){
+		std::fill(nxt.begin(), nxt.end(), 0);
+		bool any_st = false;
+		for(size_t ii = 0; ii < mm; ii++){
+			if(! curr[ii]){
+				continue;
+			}
+			const zo_glob_tok& tok = all_tok[ii];
+			switch(tok.kind){
+				case zo_glob_tok_kind::lit:
+					if(cc == tok.ch){ add_state(all_tok, nxt, ii + 1); any_st = true; }
+					break;
+				case zo_glob_tok_kind::any:
+					if(cc != '/'){ add_state(all_tok, nxt, ii + 1); any_st = true; }
+					break;
+				case zo_glob_tok_kind::cls:
+					if((cc != '/') && tok.in_class(cc)){ add_state(all_tok, nxt, ii + 1); any_st = true; }
+					break;
+				case zo_glob_tok_kind::star:
+					if(cc != '/'){ add_state(all_tok, nxt, ii); any_st = true; }
+					break;
+				case zo_glob_tok_kind::dstar:
+					add_state(all_tok, nxt, ii); any_st = true;
+					break;
+				case zo_glob_tok_kind::dstar_dir:
+					add_state(all_tok, nxt, ii); any_st = true;
+					if(cc == '/'){ add_state(all_tok, nxt, ii + 1); }
+					break;
+			}
+		}
+		if(! any_st){
+			return false;
+		}
+		curr.swap(nxt);
+	}
+	return (curr[mm] != 0);
+}
+
+void
+zo_ignore_rules::add_rule(const zo_string& line){
+	zo_string ln = line;
+	while(! ln.empty() && ((ln.back() == '\r') || (ln.back() == ' ') || (ln.back() == '\t'))){
+		ln.pop_back();
+	}
+	if(ln.empty() || (ln[0] == '#')){
+		return;
+	}
+
+	zo_ignore_rule rl;
+	rl.idx = (long)all_rules.size();
+	if(ln[0] == '!'){
+		rl.negate = true;
+		ln = ln.substr(1);
+	} else if((ln.size() > 1) && (ln[0] == '\\') && ((ln[1] == '!') || (ln[1] == '#'))){
+		ln = ln.substr(1);
+	}
+	if(! ln.empty() && (ln.back() == '/')){
+		rl.dir_only = true;
+		ln.pop_back();
+	}
+	if(ln.find('/') != std::string::npos){
+		rl.anchored = true;
+		if(ln[0] == '/'){
+			ln = ln.substr(1);
+		}
+	}
+	if(ln.empty()){
+		return;
+	}
+
+	rl.pat = ln;
+	rl.is_lit = ! zo_is_glob_pattern(ln);
+	if(rl.is_lit){
+		if(rl.anchored){
+			path_lits[ln].push_back(rl.idx);
+		} else {
+			name_lits[ln].push_back(rl.idx);
+		}
+	} else {
+		rl.glb.compile(ln);
+		all_globs.push_back(rl.idx);
+	}
+	all_rules.push_back(rl);
+}
+
+bool
+zo_ignore_rules::load(const zo_string& fpth){
+	zo_istream_pt istm = ZO_VFS->open_read(fpth);
+	if(! istm){
+		return false;
+	}
+	zo_string ln;
+	for(;getline(*istm, ln);){
+		add_rule(ln);
+	}
+	return true;
+}
+
+static
+long
+last_lit_match(const zo_ignore_rules& rls, const zo_rule_idx_map& lits, const zo_string& key, bool is_dir){
+	auto it = lits.find(key);
+	if(it == lits.end()){
+		return -1;
+	}
+	const std::vector<long>& all_idx = it->second;
+	for(auto ii = all_idx.rbegin(); ii != all_idx.rend(); ii++){
+		if(rls.all_rules[*ii].applies(is_dir)){
+			return *ii;
+		}
+	}
+	return -1;
+}
+
+zo_ign_res
+zo_ignore_rules::match(const zo_string& rel_pth, const zo_string& nam, bool is_dir) const {
+	long best = last_lit_match(*this, name_lits, nam, is_dir);
+	long bst_pth = last_lit_match(*this, path_lits, rel_pth, is_dir);
+	if(bst_pth > best){
+		best = bst_pth;
+	}
+	for(auto ii = all_globs.rbegin(); ii != all_globs.rend(); ii++){
+		if(*ii <= best){
+			break;
+		}
+		const zo_ignore_rule& rl = all_rules[*ii];
+		if(! rl.applies(is_dir)){
+			continue;
+		}
+		const zo_string& tgt = (rl.anchored)?(rel_pth):(nam);
+		if(rl.glb.match(tgt)){
+			best = *ii;
+			break;
+		}
+	}
+	if(best < 0){
+		return zo_ign_res::none;
+	}
+	return (all_rules[best].negate)?(zo_ign_res::include):(zo_ign_res::ignore);
+}
+
+bool
+zo_ignore_stack::is_ignored(const zo_string& pth, const zo_string& nam, bool is_dir) const {
+	for(auto it = all_frames.rbegin(); it != all_frames.rend(); it++){
+		const zo_ignore_rules& rls = *it;
+		const zo_string& bdir = rls.base_dir;
+		size_t bsz = bdir.size();
+		if((bsz > 0) && (bdir.back() == '/')){
+			bsz--;
+		}
+		if((pth.size() <= bsz) || (pth.compare(0, bsz, bdir, 0, bsz) != 0) || (pth[bsz] != '/')){
+			continue;
+		}
+		zo_string rel = pth.substr(bsz + 1);
+		zo_ign_res res = rls.match(rel, nam, is_dir);
+		if(res != zo_ign_res::none){
+			return (res == zo_ign_res::ignore);
+		}
+	}
+	return false;
+}
@@ -0,0 +1,135 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+zo_ignore.h
+
+gitignore style rules read from '.sfzignore' files.
+Literal rules are hashed. Glob rules are compiled to a token list
+matched by a small NFA simulation (no std::regex).
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_IGNORE_H
+#define ZO_IGNORE_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "dbg_util.h"
+
+#define ZO_IGNORE_FNAM ".sfzignore"
+
+enum class zo_glob_tok_kind : uint8_t {
+	lit,		// one char
+	any,		// '?'
+	cls,		// '[...]'
+	star,		// '*'  does not cross '/'
+	dstar,		// '**' crosses '/'
+	dstar_dir	// '**/' empty or any string ending in '/'
+};
+
+class zo_glob_tok {
+public:
+	zo_glob_tok_kind	kind{zo_glob_tok_kind::lit};
+	char 				ch{0};
+	bool 				negate{false};
+	zo_string			all_cls{""};	// pairs of (lo, hi) chars
+
+	bool in_class(char cc) const;
+};
+
+class zo_glob {
+public:
+	std::vector<zo_glob_tok>	all_tok;
+	zo_string 					lit_sfx{""};	// literal tail used for quick rejects
+
+	void compile(const zo_string& pat);
+	bool match(const zo_string& str) const;
+};
+
+class zo_ignore_rule {
+public:
+	long 		idx{0};
+	bool 		negate{false};
+	bool 		dir_only{false};
+	bool 		anchored{false};
+	bool 		is_lit{false};
+	zo_string	pat{""};
+	zo_glob		glb;
+
+	bool applies(bool is_dir) const {
+		return (! dir_only || is_dir);
+	}
+};
+
+enum class zo_ign_res {
+	none,
+	ignore,
+	include
+};
+
+using zo_rule_idx_map = std::unordered_map<zo_string, std::vector<long>>;
+
+class zo_ignore_rules {
+public:
+	zo_string 					base_dir{""};
+	std::vector<zo_ignore_rule>	all_rules;
+	zo_rule_idx_map				name_lits;
+	zo_rule_idx_map				path_lits;
+	std::vector<long>			all_globs;
+
+	bool empty() const {
+		return all_rules.empty();
+	}
+
+	void add_rule(const zo_string& ln);
+	bool load(const zo_string& fpth);
+
+	zo_ign_res match(const zo_string& rel_pth, const zo_string& nam, bool is_dir) const;
+};
+
+class zo_ignore_stack {
+public:
+	std::vector<zo_ignore_rules>	all_frames;
+
+	void push(zo_ignore_rules&& rls){
+		all_frames.push_back(std::move(rls));
+	}
+
+	void pop(){
+		ZO_CK(! all_frames.empty());
+		all_frames.pop_back();
+	}
+
+	bool is_ignored(const zo_string& pth, const zo_string& nam, bool is_dir) const;
+};
+
+bool zo_is_glob_pattern(const zo_string& pat);
+
+#endif		// ZO_IGNORE_H
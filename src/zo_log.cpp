@@ -0,0 +1,187 @@
+
+
+#include <stdarg.h>
+#include <string.h>
+
+#include <vector>
+
+#include "zo_log.h"
+
+constexpr long ZO_LOG_BUFF_SZ = 1024 * 1024;
+
+zo_logger ZO_LOGGER;
+
+// keeps the lines of an event whole when several threads log.
+class zo_file_lock {
+public:
+	FILE* 	fl;
+	
+	zo_file_lock(FILE* ff){
+		fl = ff;
+		flockfile(fl);
+	}
+	~zo_file_lock(){
+		funlockfile(fl);
+	}
+};
+
+static const char* ZO_LEVEL_NAMES[] = {
+	"error",
+	"plan",
+	"info",
+	"debug"
+};
+
+void
+zo_logger::init(){
+	setvbuf(out, zo_null, _IOFBF, ZO_LOG_BUFF_SZ);
+}
+
+void
+zo_logger::flush(){
+	fflush(out);
+}
+
+void
+zo_logger::put_str(const char* str){
+	fputs(str, out);
+}
+
+void
+zo_logger::put_json_str(const char* str){
+	putc('"', out);
+	for(const unsigned char* cc = (const unsigned char*)str; *cc != '\0'; cc++){
+		switch(*cc){
+			case '"': fputs("\\\"", out); break;
+			case '\\': fputs("\\\\", out); break;
+			case '\n': fputs("\\n", out); break;
+			case '\r': fputs("\\r", out); break;
+			case '\t': fputs("\\t", out); break;
+			default:
+				if(*cc < 0x20){
+					fprintf(out, "\\u%04x", *cc);
+				} else {
+					putc(*cc, out);
+				}
+				break;
+		}
+	}
+	putc('"', out);
+}
+
+void
+zo_logger::put_quoted(const char* str){
+	// same as 'operator <<' of fs::path (std::quoted)
+	putc('"', out);
+	for(const char* cc = str; *cc != '\0'; cc++){
+		if((*cc == '"') || (*cc == '\\')){
+			putc('\\', out);
+		}
+		putc(*cc, out);
+	}
+	putc('"', out);
+}
+
+void
+zo_logger::json_begin(zo_log_lev lv, const char* evt){
+	fputs("{\"lvl\":\"", out);
+	fputs(ZO_LEVEL_NAMES[(int)lv], out);
+	fputs("\",\"evt\":", out);
+	put_json_str(evt);
+}
+
+void
+zo_logger::json_field(const char* key, const char* val){
+	fprintf(out, ",\"%s\":", key);
+	put_json_str(val);
+}
+
+void
+zo_logger::json_field(const char* key, long val){
+	fprintf(out, ",\"%s\":%ld", key, val);
+}
+
+void
+zo_logger::json_end(){
+	fputs("}\n", out);
+}
+
+void
+zo_logger::event(zo_log_lev lv, const char* evt, const char* pth, zo_log_qt qt, const char* sfx){
+	zo_file_lock lck(out);
+	if(ndjson){
+		json_begin(lv, evt);
+		json_field("path", pth);
+		json_end();
+		return;
+	}
+	fputs(evt, out);
+	putc(' ', out);
+	switch(qt){
+		case zo_log_qt::bare:
+			fputs(pth, out);
+			break;
+		case zo_log_qt::squote:
+			putc('\'', out);
+			fputs(pth, out);
+			putc('\'', out);
+			break;
+		case zo_log_qt::dquote:
+			putc('"', out);
+			fputs(pth, out);
+			putc('"', out);
+			break;
+		case zo_log_qt::pquote:
+			put_quoted(pth);
+			break;
+	}
+	fputs(sfx, out);
+	putc('\n', out);
+}
+
+void
+zo_logger::event2(zo_log_lev lv, const char* evt, const char* pth, const char* pth2){
+	zo_file_lock lck(out);
+	if(ndjson){
+		json_begin(lv, evt);
+		json_field("path", pth);
+		json_field("to", pth2);
+		json_end();
+		return;
+	}
+	fprintf(out, "%s '%s' to '%s'\n", evt, pth, pth2);
+}
+
+void
+zo_logger::msg(zo_log_lev lv, const char* fmt, ...){
+	va_list ap;
+	va_start(ap, fmt);
+	if(! ndjson){
+		vfprintf(out, fmt, ap);
+		va_end(ap);
+		return;
+	}
+	va_list ap2;
+	va_copy(ap2, ap);
+	char sbuf[ZO_MAX_STR_SZ];
+	int sz = vsnprintf(sbuf, sizeof(sbuf), fmt, ap);
+	va_end(ap);
+	std::vector<char> lbuf;
+	char* str = sbuf;
+	if(sz >= (int)sizeof(sbuf)){
+		lbuf.resize(sz + 1);
+		vsnprintf(lbuf.data(), lbuf.size(), fmt, ap2);
+		str = lbuf.data();
+	}
+	va_end(ap2);
+	if(sz < 0){
+		return;
+	}
+	while((sz > 0) && (str[sz - 1] == '\n')){
+		str[--sz] = '\0';
+	}
+	zo_file_lock lck(out);
+	json_begin(lv, "msg");
+	json_field("msg", str);
+	json_end();
+}
@@ -0,0 +1,100 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+zo_log.h
+
+leveled event output (-q, -v, --log_format ndjson).
+Events are written to one fully buffered FILE. Callers go through
+ZO_EVENT so nothing is formatted when the level is off.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_LOG_H
+#define ZO_LOG_H
+
+#include <stdio.h>
+
+#include "dbg_util.h"
+
+enum class zo_log_lev : int {
+	error,
+	plan,	// the actions printed with --list and the ones done
+	info,	// per file reading and selecting
+	debug
+};
+
+enum class zo_log_qt : int {
+	bare,	// EVT pth
+	squote,	// EVT 'pth'
+	dquote,	// EVT "pth"
+	pquote	// EVT "pth" escaped like 'operator <<' of fs::path
+};
+
+class zo_logger {
+public:
+	zo_log_lev 	level{zo_log_lev::info};
+	bool 		ndjson{false};
+	FILE* 		out{stdout};
+
+	bool on(zo_log_lev lv) const {
+		return ((int)lv <= (int)level);
+	}
+
+	void init();
+	void flush();
+
+	void event(zo_log_lev lv, const char* evt, const char* pth, zo_log_qt qt = zo_log_qt::squote, 
+			   const char* sfx = "");
+	void event2(zo_log_lev lv, const char* evt, const char* pth, const char* pth2);
+	void msg(zo_log_lev lv, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+	
+	void json_begin(zo_log_lev lv, const char* evt);
+	void json_field(const char* key, const char* val);
+	void json_field(const char* key, long val);
+	void json_end();
+
+	void put_str(const char* str);
+	void put_json_str(const char* str);
+	void put_quoted(const char* str);
+};
+
+extern zo_logger ZO_LOGGER;
+
+#define ZO_LOG_ON(lv) ZO_LOGGER.on(zo_log_lev::lv)
+
+#define ZO_EVENT(lv, ...) \
+	do{ if(ZO_LOGGER.on(zo_log_lev::lv)){ ZO_LOGGER.event(zo_log_lev::lv, __VA_ARGS__); } }while(0)
+
+#define ZO_EVENT2(lv, ...) \
+	do{ if(ZO_LOGGER.on(zo_log_lev::lv)){ ZO_LOGGER.event2(zo_log_lev::lv, __VA_ARGS__); } }while(0)
+
+#define ZO_MSG(lv, ...) \
+	do{ if(ZO_LOGGER.on(zo_log_lev::lv)){ ZO_LOGGER.msg(zo_log_lev::lv, __VA_ARGS__); } }while(0)
+
+#endif		// ZO_LOG_H
@@ -0,0 +1,151 @@
+
+
+#include <stdlib.h>
+#include <malloc.h>
+#include <sys/resource.h>
+
+#include <new>
+
+#include "zo_mem.h"
+
+zo_mem_stats ZO_MEM;
+thread_local zo_mem_tag ZO_MEM_TAG = zo_mem_tag::other;
+
+static const char* ZO_MEM_TAG_NAMES[ZO_TOT_MEM_TAGS] = {
+	"other",
+	"sfont",
+	"sample",
+	"ref",
+	"control",
+	"conflict",
+	"ref_strings",
+	"bk_ref_map",
+	"read_maps",
+	"selected_maps",
+	"next_names",
+	"regex",
+	"dir_listing",
+	"spill"
+};
+
+static
+void
+update_peak(std::atomic<long>& peak, long val){
+	long old = peak.load(std::memory_order_relaxed);
+	while((val > old) && ! peak.compare_exchange_weak(old, val, std::memory_order_relaxed)){
+	}
+}
+
+void
+zo_mem_stats::on_alloc(void* pt){
+	long sz = (long)malloc_usable_size(pt);
+	long lv = live.fetch_add(sz, std::memory_order_relaxed) + sz;
+	update_peak(peak_live, lv);
+	
+	zo_mem_count& ph = all_phase[ZO_STATS.curr_phase.load(std::memory_order_relaxed)];
+	ph.allocs.fetch_add(1, std::memory_order_relaxed);
+	ph.bytes.fetch_add(sz, std::memory_order_relaxed);
+	update_peak(ph.peak_live, lv);
+	
+	zo_mem_count& tg = all_tag[(int)ZO_MEM_TAG];
+	tg.allocs.fetch_add(1, std::memory_order_relaxed);
+	tg.bytes.fetch_add(sz, std::memory_order_relaxed);
+}
+
+void
+zo_mem_stats::on_free(void* pt){
+	long sz = (long)malloc_usable_size(pt);
+	live.fetch_sub(sz, std::memory_order_relaxed);
+	zo_mem_count& ph = all_phase[ZO_STATS.curr_phase.load(std::memory_order_relaxed)];
+	ph.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+static
+void
+add_count_json(zo_string& js, const char* nam, zo_mem_count& cnt, bool with_peak){
+	js += "\t\t" + zo_json_str(nam) + ": {\"allocs\": " + std::to_string(cnt.allocs.load()) + 
+		", \"bytes\": " + std::to_string(cnt.bytes.load());
+	if(with_peak){
+		js += ", \"frees\": " + std::to_string(cnt.frees.load()) + 
+			", \"peak_live_bytes\": " + std::to_string(cnt.peak_live.load());
+	}
+	js += "}";
+}
+
+zo_string
+zo_mem_stats::get_json(){
+	bool was_on = is_on.exchange(false);	// do not count this report
+
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	struct mallinfo2 mi = mallinfo2();
+	
+	zo_string js = "\"memory\": {\n";
+	js += "\t\"peak_live_bytes\": " + std::to_string(peak_live.load()) + ",\n";
+	js += "\t\"live_bytes\": " + std::to_string(live.load()) + ",\n";
+	js += "\t\"max_rss_kb\": " + std::to_string(ru.ru_maxrss) + ",\n";
+	js += "\t\"arena\": {\"heap_bytes\": " + std::to_string(mi.arena) + 
+		", \"mmap_bytes\": " + std::to_string(mi.hblkhd) + 
+		", \"in_use_bytes\": " + std::to_string(mi.uordblks) + 
+		", \"free_bytes\": " + std::to_string(mi.fordblks) + "},\n";
+	js += "\t\"phases\": {\n";
+	for(int aa = 0; aa < ZO_TOT_PHASES; aa++){
+		add_count_json(js, zo_phase_name((zo_phase)aa), all_phase[aa], true);
+		js += ((aa + 1) < ZO_TOT_PHASES)?(",\n"):("\n");
+	}
+	js += "\t},\n";
+	js += "\t\"types\": {\n";
+	for(int aa = 0; aa < ZO_TOT_MEM_TAGS; aa++){
+		add_count_json(js, ZO_MEM_TAG_NAMES[aa], all_tag[aa], false);
+		js += ((aa + 1) < ZO_TOT_MEM_TAGS)?(",\n"):("\n");
+	}
+	js += "\t}\n";
+	js += "}";
+	
+	is_on = was_on;
+	return js;
+}
+
+// global allocation hooks. Only count when ZO_MEM.is_on.
+
+static
+void*
+zo_alloc(size_t sz){
+	void* pt = malloc((sz == 0)?(1):(sz));
+	if(pt == zo_null){
+		throw std::bad_alloc();
+	}
+	if(ZO_MEM.is_on.load(std::memory_order_relaxed)){
+		ZO_MEM.on_alloc(pt);
+	}
+	return pt;
+}
+
+static
+void
+zo_free(void* pt){
+	if(pt == zo_null){
+		return;
+	}
+	if(ZO_MEM.is_on.load(std::memory_order_relaxed)){
+		ZO_MEM.on_free(pt);
+	}
+	free(pt);
+}
+
+void* operator new(size_t sz){ return zo_alloc(sz); }
+void* operator new[](size_t sz){ return zo_alloc(sz); }
+
+void* operator new(size_t sz, const std::nothrow_t&) noexcept {
+	try { return zo_alloc(sz); } catch(...) { return zo_null; }
+}
+void* operator new[](size_t sz, const std::nothrow_t&) noexcept {
+	try { return zo_alloc(sz); } catch(...) { return zo_null; }
+}
+
+void operator delete(void* pt) noexcept { zo_free(pt); }
+void operator delete[](void* pt) noexcept { zo_free(pt); }
+void operator delete(void* pt, size_t) noexcept { zo_free(pt); }
+void operator delete[](void* pt, size_t) noexcept { zo_free(pt); }
+void operator delete(void* pt, const std::nothrow_t&) noexcept { zo_free(pt); }
+void operator delete[](void* pt, const std::nothrow_t&) noexcept { zo_free(pt); }
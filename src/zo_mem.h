@@ -0,0 +1,111 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+zo_mem.h
+
+allocation accounting (--mem_stats).
+Global operator new / delete count calls and usable bytes while it is
+on. Counts go to the current top level phase and to the tag of the
+innermost zo_mem_scope of the thread. Reported in the --stats JSON.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_MEM_H
+#define ZO_MEM_H
+
+#include <atomic>
+
+#include "zo_stats.h"
+
+enum class zo_mem_tag : int {
+	other,
+	sfont,
+	sample,
+	ref,
+	control,
+	conflict,
+	ref_strings,
+	bk_ref_map,
+	read_maps,
+	selected_maps,
+	next_names,
+	regex,
+	dir_listing,
+	spill,
+	tot_tags
+};
+
+constexpr int ZO_TOT_MEM_TAGS = (int)zo_mem_tag::tot_tags;
+
+class zo_mem_count {
+public:
+	std::atomic<long> 	allocs{0};
+	std::atomic<long> 	bytes{0};
+	std::atomic<long> 	frees{0};
+	std::atomic<long> 	peak_live{0};
+};
+
+class zo_mem_stats {
+public:
+	std::atomic<bool> 	is_on{false};
+	std::atomic<long> 	live{0};	// since is_on was set
+	std::atomic<long> 	peak_live{0};
+
+	zo_mem_count 		all_phase[ZO_TOT_PHASES];
+	zo_mem_count 		all_tag[ZO_TOT_MEM_TAGS];
+
+	void on_alloc(void* pt);
+	void on_free(void* pt);
+
+	zo_string get_json();
+};
+
+extern zo_mem_stats ZO_MEM;
+extern thread_local zo_mem_tag ZO_MEM_TAG;
+
+class zo_mem_scope {
+	zo_mem_scope(zo_mem_scope& rr) = delete;
+	zo_mem_scope& operator = (const zo_mem_scope& rr) = delete;
+
+public:
+	zo_mem_tag 	prev;
+
+	zo_mem_scope(zo_mem_tag tg){
+		prev = ZO_MEM_TAG;
+		ZO_MEM_TAG = tg;
+	}
+
+	~zo_mem_scope(){
+		ZO_MEM_TAG = prev;
+	}
+};
+
+#define ZO_MEM_SCOPE(tg) zo_mem_scope zo_mem_scp_##tg(zo_mem_tag::tg)
+
+#endif		// ZO_MEM_H
@@ -0,0 +1,63 @@
+
+
+#include "zo_pool.h"
+
+void
+zo_thread_pool::start(long tot_thd){
+	std::unique_lock<std::mutex> lk(mtx);
+	stopping = false;
+	for(long aa = 0; aa < tot_thd; aa++){
+		all_thd.emplace_back(&zo_thread_pool::run, this);
+	}
+}
+
+void
+zo_thread_pool::submit(zo_job&& jb){
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		all_job.push_back(std::move(jb));
+	}
+	cv_job.notify_one();
+}
+
+void
+zo_thread_pool::wait_idle(){
+	std::unique_lock<std::mutex> lk(mtx);
+	cv_idle.wait(lk, [this]{ return (all_job.empty() && (tot_busy == 0)) || stopping; });
+}
+
+void
+zo_thread_pool::stop(){
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		stopping = true;
+		all_job.clear();
+	}
+	cv_job.notify_all();
+	cv_idle.notify_all();
+	for(auto& thd : all_thd){
+		thd.join();
+	}
+	all_thd.clear();
+}
+
+void
+zo_thread_pool::run(){
+	std::unique_lock<std::mutex> lk(mtx);
+	for(;;){
+		cv_job.wait(lk, [this]{ return ! all_job.empty() || stopping; });
+		if(stopping){
+			return;
+		}
+		zo_job jb = std::move(all_job.front());
+		all_job.pop_front();
+		tot_busy++;
+		lk.unlock();
+		jb();
+		lk.lock();
+		tot_busy--;
+		if(all_job.empty() && (tot_busy == 0)){
+			cv_idle.notify_all();
+		}
+	}
+}
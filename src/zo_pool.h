@@ -0,0 +1,147 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+
+zo_pool.h
+
+fixed size pool of worker threads running queued jobs in order, and
+bounded queues between threads.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_POOL_H
+#define ZO_POOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+using zo_job = std::function<void()>;
+
+class zo_thread_pool {
+	zo_thread_pool(zo_thread_pool& rr) = delete;
+	zo_thread_pool& operator = (const zo_thread_pool& rr) = delete;
+
+public:
+	std::mutex 					mtx;
+	std::condition_variable 	cv_job;
+	std::condition_variable 	cv_idle;
+	std::deque<zo_job> 			all_job;
+	std::vector<std::thread> 	all_thd;
+	long 						tot_busy{0};
+	bool 						stopping{false};
+
+	zo_thread_pool(){}
+	~zo_thread_pool(){
+		stop();
+	}
+
+	void start(long tot_thd);
+	void submit(zo_job&& jb);
+	void wait_idle();
+	void stop();	// pending jobs are dropped
+
+	bool is_on(){
+		return ! all_thd.empty();
+	}
+
+private:
+	void run();
+};
+
+// push waits while it is full. pop waits while it is empty and returns false once closed and empty.
+template<class T>
+class zo_bounded_queue {
+	zo_bounded_queue(zo_bounded_queue& rr) = delete;
+	zo_bounded_queue& operator = (const zo_bounded_queue& rr) = delete;
+
+public:
+	std::mutex 					mtx;
+	std::condition_variable 	cv_not_empty;
+	std::condition_variable 	cv_not_full;
+	std::deque<T> 				all_item;
+	long 						max_sz{1};
+	bool 						closed{false};
+
+	zo_bounded_queue(long mx){
+		max_sz = (mx > 0)?(mx):(1);
+	}
+
+	void push(T&& it){
+		std::unique_lock<std::mutex> lk(mtx);
+		cv_not_full.wait(lk, [this]{ return ((long)all_item.size() < max_sz) || closed; });
+		all_item.push_back(std::move(it));
+		cv_not_empty.notify_one();
+	}
+
+	bool try_push(T&& it){
+		std::unique_lock<std::mutex> lk(mtx);
+		if((long)all_item.size() >= max_sz){
+			return false;
+		}
+		all_item.push_back(std::move(it));
+		cv_not_empty.notify_one();
+		return true;
+	}
+
+	bool pop(T& it){
+		std::unique_lock<std::mutex> lk(mtx);
+		cv_not_empty.wait(lk, [this]{ return ! all_item.empty() || closed; });
+		if(all_item.empty()){
+			return false;
+		}
+		it = std::move(all_item.front());
+		all_item.pop_front();
+		cv_not_full.notify_one();
+		return true;
+	}
+
+	bool try_pop(T& it){
+		std::unique_lock<std::mutex> lk(mtx);
+		if(all_item.empty()){
+			return false;
+		}
+		it = std::move(all_item.front());
+		all_item.pop_front();
+		cv_not_full.notify_one();
+		return true;
+	}
+
+	void close(){
+		std::unique_lock<std::mutex> lk(mtx);
+		closed = true;
+		cv_not_empty.notify_all();
+		cv_not_full.notify_all();
+	}
+};
+
+#endif		// ZO_POOL_H
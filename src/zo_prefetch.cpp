@@ -0,0 +1,287 @@
+
+
+#include <sstream>
+
+#ifdef HAS_FILESYSTEM
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include "zo_prefetch.h"
+
+// clears the cache when a change to the tree ends (even by an exception).
+class zo_invalidate_at_end {
+public:
+	zo_prefetch_vfs& 	vfs;
+	
+	zo_invalidate_at_end(zo_prefetch_vfs& vv) : vfs(vv) {}
+	~zo_invalidate_at_end(){
+		vfs.invalidate();
+	}
+};
+
+void
+zo_prefetch_vfs::invalidate(){
+	std::unique_lock<std::mutex> lk(mtx);
+	gen++;
+	all_canon.clear();
+	all_stat.clear();
+	all_list.clear();
+	all_data.clear();
+	cv_ready.notify_all();
+}
+
+template<class T>
+void
+zo_prefetch_vfs::set_ready(zo_meta_map<T>& all_ent, const zo_string& key, long old_gen, T& val){
+	if(gen != old_gen){
+		return;
+	}
+	auto it = all_ent.find(key);
+	if(it != all_ent.end()){
+		it->second.st = zo_meta_state::ready;
+		it->second.val = std::move(val);
+	}
+	cv_ready.notify_all();
+}
+
+template<class T>
+T
+zo_prefetch_vfs::get_meta(zo_meta_map<T>& all_ent, const zo_string& key, bool take, std::function<T()> fn){
+	std::unique_lock<std::mutex> lk(mtx);
+	bool waited = false;
+	for(;;){
+		auto it = all_ent.find(key);
+		if((it == all_ent.end()) || (it->second.st == zo_meta_state::queued)){
+			if(it == all_ent.end()){
+				it = all_ent.emplace(key, zo_meta_ent<T>{}).first;
+			}
+			it->second.st = zo_meta_state::running;
+			long old_gen = gen;
+			lk.unlock();
+			ZO_STAT_INC(meta_misses);
+			T val = fn();
+			lk.lock();
+			if(take){
+				if(gen == old_gen){
+					all_ent.erase(key);
+				}
+				return val;
+			}
+			T cpy = val;
+			set_ready(all_ent, key, old_gen, cpy);
+			return val;
+		}
+		if(it->second.st == zo_meta_state::running){
+			if(! waited){
+				ZO_STAT_INC(meta_waits);
+				waited = true;
+			}
+			cv_ready.wait(lk);
+			continue;
+		}
+		if(! waited){
+			ZO_STAT_INC(meta_hits);
+		}
+		if(take){
+			T val = std::move(it->second.val);
+			all_ent.erase(it);
+			return val;
+		}
+		return it->second.val;
+	}
+}
+
+template<class T>
+void
+zo_prefetch_vfs::queue_meta(zo_meta_map<T>& all_ent, const zo_string& key, std::function<T()> fn){
+	if(! pool.is_on()){
+		return;
+	}
+	long old_gen = 0;
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		if(all_ent.count(key) > 0){
+			return;
+		}
+		all_ent.emplace(key, zo_meta_ent<T>{});
+		old_gen = gen;
+	}
+	pool.submit([this, &all_ent, key, old_gen, fn](){
+		std::unique_lock<std::mutex> lk(mtx);
+		if(gen != old_gen){
+			return;
+		}
+		auto it = all_ent.find(key);
+		if((it == all_ent.end()) || (it->second.st != zo_meta_state::queued)){
+			return;
+		}
+		it->second.st = zo_meta_state::running;
+		lk.unlock();
+		T val = fn();
+		lk.lock();
+		ZO_STAT_INC(meta_prefetched);
+		set_ready(all_ent, key, old_gen, val);
+	});
+}
+
+zo_meta_canon
+zo_prefetch_vfs::do_canonical(const zo_string& pth){
+	zo_meta_canon mc;
+	mc.pth = base->canonical(pth, mc.ec);
+	if(! mc.ec){
+		queue_stat(mc.pth);
+	}
+	return mc;
+}
+
+zo_meta_stat
+zo_prefetch_vfs::do_stat(const zo_string& pth){
+	zo_meta_stat ms;
+	ms.ok = base->stat(pth, ms.st, true);
+	return ms;
+}
+
+zo_meta_list
+zo_prefetch_vfs::do_list(const zo_string& dir_pth){
+	zo_meta_list lst;
+	lst.sres = base->scan_dir(dir_pth, lst.all_ent, zo_null, &lst.key);
+	return lst;
+}
+
+zo_meta_data
+zo_prefetch_vfs::do_read_sfz(const zo_string& pth){
+	zo_meta_data dat;
+	zo_istream_pt istm = base->open_read(pth);
+	if(! istm){
+		return dat;
+	}
+	std::stringstream sstm;
+	sstm << istm->rdbuf();
+	dat.data = sstm.str();
+	dat.ok = true;
+	
+	if(ref_paths_fn != zo_null){
+		std::istringstream rstm(dat.data);
+		std::vector<zo_string> all_pth;
+		ref_paths_fn(rstm, fs::path(pth).parent_path(), all_pth);
+		for(const auto& rp : all_pth){
+			queue_canonical(rp);
+		}
+	}
+	return dat;
+}
+
+void
+zo_prefetch_vfs::queue_canonical(const zo_string& pth){
+	queue_meta<zo_meta_canon>(all_canon, pth, [this, pth](){ return do_canonical(pth); });
+}
+
+void
+zo_prefetch_vfs::queue_stat(const zo_string& pth){
+	queue_meta<zo_meta_stat>(all_stat, pth, [this, pth](){ return do_stat(pth); });
+}
+
+void
+zo_prefetch_vfs::queue_list(const zo_string& dir_pth){
+	queue_meta<zo_meta_list>(all_list, dir_pth, [this, dir_pth](){ return do_list(dir_pth); });
+}
+
+void
+zo_prefetch_vfs::queue_read_sfz(const zo_string& pth){
+	queue_meta<zo_meta_data>(all_data, pth, [this, pth](){ return do_read_sfz(pth); });
+}
+
+bool
+zo_prefetch_vfs::stat(const zo_string& pth, zo_vfs_stat& st, bool follow){
+	if(! follow){
+		return base->stat(pth, st, false);
+	}
+	zo_meta_stat ms = get_meta<zo_meta_stat>(all_stat, pth, false, [this, pth](){ return do_stat(pth); });
+	st = ms.st;
+	return ms.ok;
+}
+
+zo_string
+zo_prefetch_vfs::canonical(const zo_string& pth, std::error_code& ec){
+	zo_meta_canon mc = get_meta<zo_meta_canon>(all_canon, pth, false, [this, pth](){ return do_canonical(pth); });
+	ec = mc.ec;
+	return mc.pth;
+}
+
+zo_scan_res
+zo_prefetch_vfs::scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent,
+						  zo_inode_set* all_visited, zo_inode_key* dir_key)
+{
+	zo_meta_list lst = get_meta<zo_meta_list>(all_list, dir_pth, true, [this, dir_pth](){ return do_list(dir_pth); });
+	if(lst.sres != zo_scan_res::ok){
+		return lst.sres;
+	}
+	if(dir_key != zo_null){
+		*dir_key = lst.key;
+	}
+	if((all_visited != zo_null) && lst.key.is_valid()){
+		bool is_nw = all_visited->insert(lst.key).second;
+		if(! is_nw){
+			return zo_scan_res::visited;
+		}
+	}
+	all_ent.insert(all_ent.end(), lst.all_ent.begin(), lst.all_ent.end());
+	return zo_scan_res::ok;
+}
+
+zo_istream_pt
+zo_prefetch_vfs::open_read(const zo_string& pth){
+	bool is_queued = false;
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		is_queued = (all_data.count(pth) > 0);
+	}
+	if(! is_queued){
+		return base->open_read(pth);
+	}
+	zo_meta_data dat = get_meta<zo_meta_data>(all_data, pth, true, [this, pth](){ return do_read_sfz(pth); });
+	if(! dat.ok){
+		return base->open_read(pth);	// to set errno
+	}
+	return zo_istream_pt{new std::istringstream(std::move(dat.data))};
+}
+
+zo_ostream_pt
+zo_prefetch_vfs::open_write(const zo_string& pth){
+	zo_invalidate_at_end inv(*this);
+	return base->open_write(pth);
+}
+
+long
+zo_prefetch_vfs::copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec){
+	zo_invalidate_at_end inv(*this);
+	return base->copy_file(orig, dest, replace, ec);
+}
+
+void
+zo_prefetch_vfs::rename(const zo_string& orig, const zo_string& dest){
+	zo_invalidate_at_end inv(*this);
+	base->rename(orig, dest);
+}
+
+void
+zo_prefetch_vfs::remove(const zo_string& pth){
+	zo_invalidate_at_end inv(*this);
+	base->remove(pth);
+}
+
+void
+zo_prefetch_vfs::create_directories(const zo_string& pth){
+	zo_invalidate_at_end inv(*this);
+	base->create_directories(pth);
+}
+
+void
+zo_prefetch_vfs::hard_link(const zo_string& orig, const zo_string& dest, std::error_code& ec){
+	zo_invalidate_at_end inv(*this);
+	base->hard_link(orig, dest, ec);
+}
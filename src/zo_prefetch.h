@@ -0,0 +1,158 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+
+zo_prefetch.h
+
+metadata prefetch (--prefetch <threads>).
+Wraps ZO_VFS. The scanner queues the listing of the sub directories
+and the read of the sfz files of a directory once its ignore rules
+have accepted them. Reading an sfz file queues
+the canonical (and stat) of every sample it references. A pool of
+threads runs the queue ahead of the scanner and of get_opcodes, that
+then find the results in the cache. A lookup of a queued entry is done
+by the caller, so it never waits for the queue. Any change to the tree
+clears the cache.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_PREFETCH_H
+#define ZO_PREFETCH_H
+
+#include <condition_variable>
+#include <functional>
+
+#include "zo_vfs.h"
+#include "zo_pool.h"
+
+enum class zo_meta_state : uint8_t {
+	queued,
+	running,
+	ready
+};
+
+template<class T>
+class zo_meta_ent {
+public:
+	zo_meta_state 	st{zo_meta_state::queued};
+	T 				val;
+};
+
+template<class T>
+using zo_meta_map = std::map<zo_string, zo_meta_ent<T>>;
+
+class zo_meta_canon {
+public:
+	zo_string 		pth{""};
+	std::error_code ec;
+};
+
+class zo_meta_stat {
+public:
+	bool 			ok{false};
+	zo_vfs_stat 	st;
+};
+
+class zo_meta_list {
+public:
+	zo_scan_res 	sres{zo_scan_res::ok};
+	zo_inode_key 	key;
+	zo_dir_ent_vec 	all_ent;
+};
+
+class zo_meta_data {
+public:
+	bool 			ok{false};
+	zo_string 		data{""};
+};
+
+// the sample paths an sfz references as passed to canonical.
+using zo_ref_paths_fn = void (*)(std::istream& istm, const zo_string& sfz_dir, std::vector<zo_string>& all_pth);
+
+class zo_prefetch_vfs : public zo_vfs {
+public:
+	zo_vfs* 					base{zo_null};
+	zo_ref_paths_fn 			ref_paths_fn{zo_null};
+	
+	zo_thread_pool 				pool;
+	std::mutex 					mtx;
+	std::condition_variable 	cv_ready;
+	long 						gen{0};
+	
+	zo_meta_map<zo_meta_canon> 	all_canon;
+	zo_meta_map<zo_meta_stat> 	all_stat;	// following links
+	zo_meta_map<zo_meta_list> 	all_list;	// taken by the first scan_dir
+	zo_meta_map<zo_meta_data> 	all_data;	// taken by the first open_read
+	
+	zo_prefetch_vfs(zo_vfs* bs, long tot_thd){
+		base = bs;
+		pool.start(tot_thd);
+	}
+	
+	void stop(){
+		pool.stop();
+	}
+	
+	void invalidate();
+	
+	void queue_list(const zo_string& dir_pth);
+	void queue_read_sfz(const zo_string& pth);
+	
+	const char* get_name(){ return "prefetch"; }
+	
+	bool stat(const zo_string& pth, zo_vfs_stat& st, bool follow = true);
+	zo_string canonical(const zo_string& pth, std::error_code& ec);
+	zo_scan_res scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent, 
+						zo_inode_set* all_visited = zo_null, zo_inode_key* dir_key = zo_null);
+	zo_istream_pt open_read(const zo_string& pth);
+	zo_ostream_pt open_write(const zo_string& pth);
+	long copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec);
+	void rename(const zo_string& orig, const zo_string& dest);
+	void remove(const zo_string& pth);
+	void create_directories(const zo_string& pth);
+	void hard_link(const zo_string& orig, const zo_string& dest, std::error_code& ec);
+	
+private:
+	template<class T> 
+	T get_meta(zo_meta_map<T>& all_ent, const zo_string& key, bool take, std::function<T()> fn);
+	template<class T> 
+	void queue_meta(zo_meta_map<T>& all_ent, const zo_string& key, std::function<T()> fn);
+	template<class T> 
+	void set_ready(zo_meta_map<T>& all_ent, const zo_string& key, long old_gen, T& val);
+	
+	zo_meta_canon do_canonical(const zo_string& pth);
+	zo_meta_stat do_stat(const zo_string& pth);
+	zo_meta_list do_list(const zo_string& dir_pth);
+	zo_meta_data do_read_sfz(const zo_string& pth);
+	
+	void queue_canonical(const zo_string& pth);
+	void queue_stat(const zo_string& pth);
+};
+
+#endif		// ZO_PREFETCH_H
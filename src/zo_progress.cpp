@@ -0,0 +1,166 @@
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "zo_progress.h"
+#include "zo_stats.h"
+
+constexpr long ZO_PROGRESS_TICK_MS = 1000;
+constexpr double ZO_RATE_SMOOTH = 0.3;
+
+zo_progress ZO_PROGRESS;
+
+static void
+zo_progress_at_exit(){
+	ZO_PROGRESS.stop();
+}
+
+void
+zo_progress::start(){
+	if(! is_active()){
+		return;
+	}
+	// exit() paths run this before any static is destroyed (the thread would std::terminate).
+	static bool at_exit_set = false;
+	if(! at_exit_set){
+		atexit(zo_progress_at_exit);
+		at_exit_set = true;
+	}
+	is_tty = isatty(STDERR_FILENO);
+	if(! is_tty){
+		show_line = false;
+	}
+	if(metrics_secs < 1){
+		metrics_secs = 1;
+	}
+	start_ns = zo_wall_ns();
+	last_ns = start_ns;
+	stop_it = false;
+	thd = std::thread(&zo_progress::run, this);
+}
+
+void
+zo_progress::stop(){
+	if(! thd.joinable()){
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lck(mtx);
+		stop_it = true;
+	}
+	cnd.notify_all();
+	thd.join();
+	
+	long now_ns = zo_wall_ns();
+	if(show_line){
+		print_line(now_ns);
+		fprintf(stderr, "\n");
+	}
+	if(! metrics_nam.empty()){
+		write_metrics(now_ns);
+	}
+}
+
+void
+zo_progress::run(){
+	long last_metrics_ns = 0;
+	std::unique_lock<std::mutex> lck(mtx);
+	while(! stop_it){
+		cnd.wait_for(lck, std::chrono::milliseconds(ZO_PROGRESS_TICK_MS));
+		if(stop_it){
+			break;
+		}
+		long now_ns = zo_wall_ns();
+		update_rate(now_ns, ZO_STATS.get(zo_cnt::actions_done));
+		if(show_line){
+			print_line(now_ns);
+		}
+		if(! metrics_nam.empty() && ((now_ns - last_metrics_ns) >= (metrics_secs * 1000000000L))){
+			write_metrics(now_ns);
+			last_metrics_ns = now_ns;
+		}
+	}
+}
+
+void
+zo_progress::update_rate(long now_ns, long done){
+	double secs = (now_ns - last_ns) / 1.0e9;
+	if(secs <= 0){
+		return;
+	}
+	double curr = (done - last_done) / secs;
+	rate = (rate == 0)?(curr):((ZO_RATE_SMOOTH * curr) + ((1 - ZO_RATE_SMOOTH) * rate));
+	last_ns = now_ns;
+	last_done = done;
+}
+
+long
+zo_progress::get_eta_secs(long done, long total){
+	if((rate <= 0) || (total <= done)){
+		return -1;
+	}
+	return (long)((total - done) / rate);
+}
+
+void
+zo_progress::print_line(long now_ns){
+	long secs = (now_ns - start_ns) / 1000000000L;
+	zo_phase ph = (zo_phase)ZO_STATS.curr_phase.load(std::memory_order_relaxed);
+	long done = ZO_STATS.get(zo_cnt::actions_done);
+	long total = ZO_STATS.get(zo_cnt::actions_total);
+	double mb_rd = ZO_STATS.get(zo_cnt::bytes_read) / 1.0e6;
+	double mb_wr = ZO_STATS.get(zo_cnt::bytes_written) / 1.0e6;
+	
+	if(ph != zo_phase::do_actions){
+		fprintf(stderr, "\r\033[K[%ldm%02lds] %s: %ld files, %ld dirs, %ld sfz, %.1f MB read", 
+				secs / 60, secs % 60, zo_phase_name(ph), ZO_STATS.get(zo_cnt::files_scanned), 
+				ZO_STATS.get(zo_cnt::dirs_listed), ZO_STATS.get(zo_cnt::sfz_parsed), mb_rd);
+		fflush(stderr);
+		return;
+	}
+	long eta = get_eta_secs(done, total);
+	fprintf(stderr, "\r\033[K[%ldm%02lds] %s: %ld/%ld files, %.1f MB written, %.1f files/s, ETA ", 
+			secs / 60, secs % 60, zo_phase_name(ph), done, total, mb_wr, rate);
+	if(eta < 0){
+		fprintf(stderr, "--");
+	} else {
+		fprintf(stderr, "%ldm%02lds", eta / 60, eta % 60);
+	}
+	fflush(stderr);
+}
+
+bool
+zo_progress::write_metrics(long now_ns){
+	zo_string tmp_nam = metrics_nam + ".tmp";
+	FILE* out = fopen(tmp_nam.c_str(), "wb");
+	if(out == zo_null){
+		return false;
+	}
+	const zo_cnt all_exported[] = {
+		zo_cnt::files_scanned, zo_cnt::dirs_listed, zo_cnt::sfz_parsed, zo_cnt::refs_resolved, 
+		zo_cnt::bad_refs, zo_cnt::conflicts, zo_cnt::bytes_read, zo_cnt::bytes_written, 
+		zo_cnt::files_copied, zo_cnt::files_linked, zo_cnt::files_moved, zo_cnt::actions_done
+	};
+	for(zo_cnt cc : all_exported){
+		const char* nm = zo_counter_name(cc);
+		fprintf(out, "# TYPE sfz_organizer_%s_total counter\nsfz_organizer_%s_total %ld\n", nm, nm, ZO_STATS.get(cc));
+	}
+	long done = ZO_STATS.get(zo_cnt::actions_done);
+	long total = ZO_STATS.get(zo_cnt::actions_total);
+	int ph = ZO_STATS.curr_phase.load(std::memory_order_relaxed);
+	fprintf(out, "# TYPE sfz_organizer_actions_planned gauge\nsfz_organizer_actions_planned %ld\n", total);
+	fprintf(out, "# TYPE sfz_organizer_phase gauge\n");
+	for(int aa = 0; aa < (int)zo_phase::tot_phases; aa++){
+		fprintf(out, "sfz_organizer_phase{phase=\"%s\"} %d\n", zo_phase_name((zo_phase)aa), (aa == ph)?(1):(0));
+	}
+	fprintf(out, "# TYPE sfz_organizer_files_per_second gauge\nsfz_organizer_files_per_second %.3f\n", rate);
+	fprintf(out, "# TYPE sfz_organizer_eta_seconds gauge\nsfz_organizer_eta_seconds %ld\n", get_eta_secs(done, total));
+	fprintf(out, "# TYPE sfz_organizer_elapsed_seconds gauge\nsfz_organizer_elapsed_seconds %.3f\n", (now_ns - start_ns) / 1.0e9);
+	bool ok = (fclose(out) == 0);
+	if(! ok){
+		return false;
+	}
+	return (rename(tmp_nam.c_str(), metrics_nam.c_str()) == 0);
+}
@@ -0,0 +1,82 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+zo_progress.h
+
+progress reporter for long runs (--progress, --metrics).
+A background thread samples the ZO_STATS counters every second. It
+refreshes one status line on stderr when it is a TTY and rewrites a
+Prometheus text file every --metrics_interval seconds.
+Workers only bump the counters they already bump for --stats.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_PROGRESS_H
+#define ZO_PROGRESS_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "dbg_util.h"
+
+class zo_progress {
+public:
+	bool 			show_line{false};
+	zo_string 		metrics_nam{""};
+	long 			metrics_secs{10};
+
+	bool 			is_tty{false};
+	bool 			stop_it{false};
+	long 			start_ns{0};
+	long 			last_ns{0};
+	long 			last_done{0};
+	double 			rate{0};	// actions per second (smoothed)
+
+	std::mutex 		mtx;
+	std::condition_variable cnd;
+	std::thread 	thd;
+
+	bool is_active(){
+		return (show_line || ! metrics_nam.empty());
+	}
+
+	void start();
+	void stop();
+
+	void run();
+	void update_rate(long now_ns, long done);
+	long get_eta_secs(long done, long total);
+	void print_line(long now_ns);
+	bool write_metrics(long now_ns);
+};
+
+extern zo_progress ZO_PROGRESS;
+
+#endif		// ZO_PROGRESS_H
@@ -0,0 +1,122 @@
+
+
+#include <stdio.h>
+
+#include <fstream>
+
+#include "zo_saved_plan.h"
+#include "zo_snapshot.h"
+
+#define ZO_SAVED_PLAN_MAGIC "ZO_SAVED_PLAN_1"
+
+bool
+zo_saved_file::set_stat(){
+	zo_vfs_stat st;
+	if(! ZO_VFS->stat(orig, st)){
+		return false;
+	}
+	size = st.size;
+	mtime_sec = st.mtime_sec;
+	mtime_nsec = st.mtime_nsec;
+	return true;
+}
+
+bool
+zo_saved_file::is_stale(){
+	zo_vfs_stat st;
+	if(! ZO_VFS->stat(orig, st) || (st.typ != zo_ent_type::regular)){
+		return true;
+	}
+	return (st.size != size) || (st.mtime_sec != mtime_sec) || (st.mtime_nsec != mtime_nsec);
+}
+
+bool
+zo_saved_plan::save(const zo_string& fnam){
+	zo_string tmp_nam = fnam + ".tmp";
+	std::ofstream ostm;
+	ostm.open(tmp_nam.c_str(), std::ios::binary);
+	if(! ostm.good() || ! ostm.is_open()){
+		fprintf(stderr, "Cannot open file:'%s'\n", tmp_nam.c_str());
+		return false;
+	}
+	ostm << ZO_SAVED_PLAN_MAGIC << ' ' << (int)keep << ' ';
+	zo_write_str(ostm, action);
+	zo_write_str(ostm, from);
+	for(const auto& fl : all_file){
+		ostm << "F " << (int)fl.is_sfz << ' ' << (int)fl.rewrite << ' ' << fl.size << ' ' << fl.mtime_sec << ' ' 
+			<< fl.mtime_nsec << ' ' << fl.all_line.size() << ' ';
+		zo_write_str(ostm, fl.orig);
+		zo_write_str(ostm, fl.nxt);
+		for(const auto& ln : fl.all_line){
+			ostm << "L " << ln.lnum << ' ';
+			zo_write_str(ostm, ln.txt);
+		}
+	}
+	ostm << "END\n";
+	ostm.close();
+	if(! ostm){
+		return false;
+	}
+	ZO_SYS_INC(rename);
+	return (rename(tmp_nam.c_str(), fnam.c_str()) == 0);
+}
+
+bool
+zo_saved_plan::load(const zo_string& fnam){
+	std::ifstream istm;
+	istm.open(fnam.c_str(), std::ios::binary);
+	if(! istm.good() || ! istm.is_open()){
+		fprintf(stderr, "Cannot open file:'%s'\n", fnam.c_str());
+		return false;
+	}
+	
+	zo_string magic;
+	int kp = 0;
+	istm >> magic >> kp;
+	if(! istm.good() || (magic != ZO_SAVED_PLAN_MAGIC) || (istm.get() != ' ') 
+		|| ! zo_read_str(istm, action) || ! zo_read_str(istm, from))
+	{
+		fprintf(stderr, "Invalid plan file '%s'\n", fnam.c_str());
+		return false;
+	}
+	keep = (kp != 0);
+	for(;;){
+		zo_string tag;
+		istm >> tag;
+		if(! istm.good()){
+			break;
+		}
+		if(tag == "END"){
+			return true;
+		}
+		if(tag != "F"){
+			break;
+		}
+		zo_saved_file fl;
+		int is_sfz = 0;
+		int rewr = 0;
+		long tot_line = 0;
+		istm >> is_sfz >> rewr >> fl.size >> fl.mtime_sec >> fl.mtime_nsec >> tot_line;
+		if(! istm.good() || (istm.get() != ' ') || ! zo_read_str(istm, fl.orig) || ! zo_read_str(istm, fl.nxt)){
+			break;
+		}
+		fl.is_sfz = (is_sfz != 0);
+		fl.rewrite = (rewr != 0);
+		bool ok = true;
+		for(long aa = 0; aa < tot_line; aa++){
+			zo_saved_line ln;
+			istm >> tag >> ln.lnum;
+			if(! istm.good() || (tag != "L") || (istm.get() != ' ') || ! zo_read_str(istm, ln.txt)){
+				ok = false;
+				break;
+			}
+			fl.all_line.push_back(std::move(ln));
+		}
+		if(! ok){
+			break;
+		}
+		all_file.push_back(std::move(fl));
+	}
+	fprintf(stderr, "Truncated plan file '%s'\n", fnam.c_str());
+	return false;
+}
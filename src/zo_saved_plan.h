@@ -0,0 +1,79 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+
+zo_saved_plan.h
+
+plans written by --save-plan and done by --apply-plan.
+Each moved or copied file keeps the size and mtime it had when planned,
+so only the files of the plan are checked before doing it.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_SAVED_PLAN_H
+#define ZO_SAVED_PLAN_H
+
+#include <vector>
+
+#include "zo_vfs.h"
+
+// a line of an sfz and the text (with its new lines) that replaces it.
+class zo_saved_line {
+public:
+	long 		lnum{0};
+	zo_string 	txt{""};
+};
+
+class zo_saved_file {
+public:
+	bool 		is_sfz{false};
+	bool 		rewrite{false};	// sfz with refs, written line by line
+	zo_string 	orig{""};
+	zo_string 	nxt{""};
+	long 		size{0};
+	long 		mtime_sec{0};
+	long 		mtime_nsec{0};
+	std::vector<zo_saved_line>	all_line;	// in line order
+	
+	bool set_stat();
+	bool is_stale();
+};
+
+class zo_saved_plan {
+public:
+	zo_string 	action{""};
+	bool 		keep{true};	// --keep policy
+	zo_string 	from{""};
+	std::vector<zo_saved_file>	all_file;	// sfz first, as they are done
+	
+	bool save(const zo_string& fnam);
+	bool load(const zo_string& fnam);
+};
+
+#endif		// ZO_SAVED_PLAN_H
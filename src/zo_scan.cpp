@@ -0,0 +1,122 @@
+
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "zo_scan.h"
+#include "zo_stats.h"
+
+constexpr long ZO_DENTS_BUFFER_SZ = 32 * 1024;
+
+struct zo_linux_dirent64 {
+	ino64_t			d_ino;
+	off64_t			d_off;
+	unsigned short	d_reclen;
+	unsigned char	d_type;
+	char			d_name[];
+};
+
+static
+zo_ent_type
+get_st_type(const struct stat& st){
+	if(S_ISREG(st.st_mode)){
+		return zo_ent_type::regular;
+	}
+	if(S_ISDIR(st.st_mode)){
+		return zo_ent_type::directory;
+	}
+	return zo_ent_type::other;
+}
+
+static
+void
+stat_entry(int dir_fd, zo_dir_ent& ent){
+	struct stat st;
+	ZO_SYS_INC(fstatat);
+	if(fstatat(dir_fd, ent.name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0){
+		ent.typ = zo_ent_type::unknown;
+		return;
+	}
+	if(S_ISLNK(st.st_mode)){
+		ent.is_lnk = true;
+		ZO_SYS_INC(fstatat);
+		if(fstatat(dir_fd, ent.name.c_str(), &st, 0) != 0){
+			ent.typ = zo_ent_type::unknown;	// dangling symlink
+			return;
+		}
+	}
+	ent.typ = get_st_type(st);
+}
+
+zo_scan_res
+zo_scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent, zo_inode_set* all_visited, zo_inode_key* dir_key){
+	ZO_SYS_INC(open);
+	int dir_fd = open(dir_pth.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(dir_fd < 0){
+		return zo_scan_res::cannot_open;
+	}
+	
+	zo_inode_key d_key;
+	if((all_visited != zo_null) || (dir_key != zo_null)){
+		struct stat st;
+		ZO_SYS_INC(fstat);
+		if(fstat(dir_fd, &st) == 0){
+			d_key.dev = st.st_dev;
+			d_key.ino = st.st_ino;
+		}
+		if(dir_key != zo_null){
+			*dir_key = d_key;
+		}
+		if((all_visited != zo_null) && d_key.is_valid()){
+			bool is_nw = all_visited->insert(d_key).second;
+			if(! is_nw){
+				close(dir_fd);
+				return zo_scan_res::visited;
+			}
+		}
+	}
+
+	ZO_STAT_INC(dirs_listed);
+	alignas(zo_linux_dirent64) char buff[ZO_DENTS_BUFFER_SZ];
+	for(;;){
+		ZO_SYS_INC(getdents64);
+		long nread = syscall(SYS_getdents64, dir_fd, buff, ZO_DENTS_BUFFER_SZ);
+		if(nread <= 0){
+			break;
+		}
+		for(long bpos = 0; bpos < nread;){
+			zo_linux_dirent64* dd = (zo_linux_dirent64*)(buff + bpos);
+			bpos += dd->d_reclen;
+
+			const char* nam = dd->d_name;
+			if((nam[0] == '.') && ((nam[1] == '\0') || ((nam[1] == '.') && (nam[2] == '\0')))){
+				continue;
+			}
+
+			all_ent.emplace_back();
+			zo_dir_ent& ent = all_ent.back();
+			ent.name = nam;
+			ent.ino = dd->d_ino;
+			switch(dd->d_type){
+				case DT_REG:
+					ent.typ = zo_ent_type::regular;
+					break;
+				case DT_DIR:
+					ent.typ = zo_ent_type::directory;
+					break;
+				case DT_LNK:
+				case DT_UNKNOWN:
+					stat_entry(dir_fd, ent);
+					break;
+				default:
+					ent.typ = zo_ent_type::other;
+					break;
+			}
+		}
+	}
+	close(dir_fd);
+	return zo_scan_res::ok;
+}
@@ -0,0 +1,102 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+zo_scan.h
+
+low level directory scanner.
+Reads directories with getdents64 and classifies entries by d_type.
+Only calls fstatat when d_type is unknown or the entry is a symlink.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_SCAN_H
+#define ZO_SCAN_H
+
+#include <sys/types.h>
+
+#include <vector>
+#include <set>
+
+#include "dbg_util.h"
+
+enum class zo_ent_type : uint8_t {
+	unknown,
+	regular,
+	directory,
+	other
+};
+
+class zo_dir_ent {
+public:
+	zo_string 		name{""};
+	zo_ent_type 	typ{zo_ent_type::unknown};
+	bool 			is_lnk{false};	// typ is the type of the symlink target
+	ino_t			ino{0};
+};
+
+using zo_dir_ent_vec = std::vector<zo_dir_ent>;
+
+class zo_inode_key {
+public:
+	dev_t 	dev{0};
+	ino_t	ino{0};
+
+	bool is_valid() const {
+		return (ino != 0);
+	}
+
+	bool operator < (const zo_inode_key& rr) const {
+		if(dev != rr.dev){
+			return (dev < rr.dev);
+		}
+		return (ino < rr.ino);
+	}
+};
+
+using zo_inode_set = std::set<zo_inode_key>;
+
+enum class zo_scan_res {
+	ok,
+	cannot_open,
+	visited
+};
+
+zo_scan_res zo_scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent, 
+						zo_inode_set* all_visited = zo_null, zo_inode_key* dir_key = zo_null);
+
+inline
+zo_string
+zo_join_path(const zo_string& dir_pth, const zo_string& nam){
+	if(! dir_pth.empty() && (dir_pth.back() == '/')){
+		return dir_pth + nam;
+	}
+	return dir_pth + '/' + nam;
+}
+
+#endif		// ZO_SCAN_H
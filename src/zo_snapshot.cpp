@@ -0,0 +1,214 @@
+
+
+#include <stdio.h>
+#include <time.h>
+
+#include <fstream>
+
+#include "zo_snapshot.h"
+#include "zo_stats.h"
+#include "zo_vfs.h"
+
+#define ZO_SNAPSHOT_MAGIC "ZO_DIR_SNAPSHOT_1"
+
+constexpr long ZO_NSEC_PER_SEC = 1000000000L;
+constexpr long ZO_COARSE_GRAN_NSEC = 2 * ZO_NSEC_PER_SEC;	// FAT has 2s mtimes
+constexpr long ZO_FINE_GRAN_NSEC = ZO_NSEC_PER_SEC / 10;
+
+bool
+zo_read_str(std::istream& istm, zo_string& str){
+	long len = -1;
+	istm >> len;
+	if(! istm.good() || (len < 0) || (istm.get() != ' ')){
+		return false;
+	}
+	str.resize(len);
+	istm.read(&str[0], len);
+	return (istm.gcount() == len) && (istm.get() == '\n');
+}
+
+void
+zo_write_str(std::ostream& ostm, const zo_string& str){
+	ostm << str.size() << ' ' << str << '\n';
+}
+
+bool
+zo_dir_snapshot::load(const zo_string& f_nam){
+	fnam = f_nam;
+
+	struct timespec tm;
+	clock_gettime(CLOCK_REALTIME, &tm);
+	start_sec = tm.tv_sec;
+	start_nsec = tm.tv_nsec;
+
+	std::ifstream istm;
+	istm.open(fnam.c_str(), std::ios::binary);
+	if(! istm.good() || ! istm.is_open()){
+		return false;
+	}
+
+	zo_string magic;
+	istm >> magic >> old_start_sec >> old_start_nsec;
+	if(! istm.good() || (magic != ZO_SNAPSHOT_MAGIC)){
+		fprintf(stderr, "Ignoring invalid snapshot file '%s'\n", fnam.c_str());
+		return false;
+	}
+	for(;;){
+		zo_string tag;
+		istm >> tag;
+		if(! istm.good() || (tag != "D")){
+			break;
+		}
+		zo_snap_dir sd;
+		long tot_ent = 0;
+		istm >> sd.mtime_sec >> sd.mtime_nsec >> sd.nlink >> sd.key.dev >> sd.key.ino >> tot_ent;
+		zo_string pth;
+		if(! zo_read_str(istm, pth)){
+			break;
+		}
+		bool ok = true;
+		for(long aa = 0; aa < tot_ent; aa++){
+			zo_dir_ent ent;
+			int typ = 0;
+			int is_lnk = 0;
+			istm >> tag >> typ >> is_lnk >> ent.ino;
+			if(! istm.good() || (tag != "E") || ! zo_read_str(istm, ent.name)){
+				ok = false;
+				break;
+			}
+			ent.typ = (zo_ent_type)typ;
+			ent.is_lnk = (is_lnk != 0);
+			sd.all_ent.push_back(ent);
+		}
+		if(! ok){
+			fprintf(stderr, "Truncated snapshot file '%s'\n", fnam.c_str());
+			break;
+		}
+		all_old[pth] = std::move(sd);
+	}
+	return true;
+}
+
+bool
+zo_dir_snapshot::save(){
+	if(! is_active()){
+		return false;
+	}
+	zo_string tmp_nam = fnam + ".tmp";
+	std::ofstream ostm;
+	ostm.open(tmp_nam.c_str(), std::ios::binary);
+	if(! ostm.good() || ! ostm.is_open()){
+		fprintf(stderr, "Cannot open file:'%s'\n", tmp_nam.c_str());
+		return false;
+	}
+	ostm << ZO_SNAPSHOT_MAGIC << ' ' << start_sec << ' ' << start_nsec << '\n';
+	for(const auto& dd : all_new){
+		const zo_snap_dir& sd = dd.second;
+		ostm << "D " << sd.mtime_sec << ' ' << sd.mtime_nsec << ' ' << sd.nlink << ' '
+			<< sd.key.dev << ' ' << sd.key.ino << ' ' << sd.all_ent.size() << ' ';
+		zo_write_str(ostm, dd.first);
+		for(const auto& ent : sd.all_ent){
+			ostm << "E " << (int)ent.typ << ' ' << (int)ent.is_lnk << ' ' << ent.ino << ' ';
+			zo_write_str(ostm, ent.name);
+		}
+	}
+	ostm.close();
+	if(! ostm){
+		return false;
+	}
+	ZO_SYS_INC(rename);
+	return (rename(tmp_nam.c_str(), fnam.c_str()) == 0);
+}
+
+static
+bool
+is_racy(const zo_snap_dir& sd, long ref_sec, long ref_nsec){
+	long gran = (sd.mtime_nsec == 0)?(ZO_COARSE_GRAN_NSEC):(ZO_FINE_GRAN_NSEC);
+	long double mt = (long double)sd.mtime_sec * ZO_NSEC_PER_SEC + sd.mtime_nsec;
+	long double rf = (long double)ref_sec * ZO_NSEC_PER_SEC + ref_nsec;
+	return ((mt + gran) >= rf);
+}
+
+static
+bool
+same_dir(const zo_snap_dir& sd, const zo_vfs_stat& st){
+	return ((sd.mtime_sec == st.mtime_sec) && (sd.mtime_nsec == st.mtime_nsec) &&
+			(sd.nlink == st.nlink) && (sd.key.dev == st.key.dev) && (sd.key.ino == st.key.ino));
+}
+
+static
+void
+restat_links(const zo_string& dir_pth, zo_dir_ent_vec& all_ent){
+	for(auto& ent : all_ent){
+		if(! ent.is_lnk && (ent.typ != zo_ent_type::unknown)){
+			continue;
+		}
+		zo_vfs_stat st;
+		zo_string pth = zo_join_path(dir_pth, ent.name);
+		if(! ZO_VFS->stat(pth, st)){
+			ent.typ = zo_ent_type::unknown;
+			continue;
+		}
+		ent.typ = st.typ;
+	}
+}
+
+zo_scan_res
+zo_dir_snapshot::scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent,
+						  zo_inode_set* all_visited, zo_inode_key* dir_key)
+{
+	zo_vfs_stat st;
+	if(! ZO_VFS->stat(dir_pth, st) || (st.typ != zo_ent_type::directory)){
+		return zo_scan_res::cannot_open;
+	}
+	zo_inode_key d_key = st.key;
+	if(dir_key != zo_null){
+		*dir_key = d_key;
+	}
+	if(all_visited != zo_null){
+		bool is_nw = all_visited->insert(d_key).second;
+		if(! is_nw){
+			return zo_scan_res::visited;
+		}
+	}
+
+	const zo_snap_dir* prv = zo_null;
+	auto it_nw = all_new.find(dir_pth);
+	if(it_nw != all_new.end()){
+		if(same_dir(it_nw->second, st) && ! is_racy(it_nw->second, start_sec, start_nsec)){
+			prv = &(it_nw->second);
+		}
+	} else {
+		auto it_old = all_old.find(dir_pth);
+		if((it_old != all_old.end()) && same_dir(it_old->second, st)){
+			if(! is_racy(it_old->second, old_start_sec, old_start_nsec)){
+				prv = &(it_old->second);
+			} else {
+				tot_racy++;
+			}
+		}
+	}
+	if(prv != zo_null){
+		tot_reused++;
+		all_ent.insert(all_ent.end(), prv->all_ent.begin(), prv->all_ent.end());
+		if(it_nw == all_new.end()){
+			all_new[dir_pth] = *prv;
+		}
+		restat_links(dir_pth, all_ent);
+		return zo_scan_res::ok;
+	}
+
+	tot_listed++;
+	size_t fst = all_ent.size();
+	zo_scan_res res = ZO_VFS->scan_dir(dir_pth, all_ent);
+	if(res != zo_scan_res::ok){
+		return res;
+	}
+	zo_snap_dir& sd = all_new[dir_pth];
+	sd.mtime_sec = st.mtime_sec;
+	sd.mtime_nsec = st.mtime_nsec;
+	sd.nlink = st.nlink;
+	sd.key = d_key;
+	sd.all_ent.assign(all_ent.begin() + fst, all_ent.end());
+	return res;
+}
@@ -0,0 +1,89 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+zo_snapshot.h
+
+directory listings saved between runs.
+A listing is reused when the directory (path, mtime, nlink, dev, inode)
+did not change and its mtime is old enough to not be racy.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_SNAPSHOT_H
+#define ZO_SNAPSHOT_H
+
+#include <istream>
+#include <ostream>
+#include <map>
+
+#include "zo_scan.h"
+
+class zo_snap_dir {
+public:
+	long 			mtime_sec{0};
+	long 			mtime_nsec{0};
+	long 			nlink{0};
+	zo_inode_key	key;
+	zo_dir_ent_vec	all_ent;
+};
+
+using zo_snap_dir_map = std::map<zo_string, zo_snap_dir>;
+
+class zo_dir_snapshot {
+public:
+	zo_string 		fnam{""};
+
+	long 			old_start_sec{0};	// start time of the run that wrote the snapshot
+	long 			old_start_nsec{0};
+	long 			start_sec{0};		// start time of this run
+	long 			start_nsec{0};
+
+	zo_snap_dir_map	all_old;
+	zo_snap_dir_map	all_new;
+
+	long 			tot_reused{0};
+	long 			tot_listed{0};
+	long 			tot_racy{0};
+
+	bool is_active(){
+		return ! fnam.empty();
+	}
+
+	bool load(const zo_string& f_nam);
+	bool save();
+
+	zo_scan_res scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent,
+						 zo_inode_set* all_visited, zo_inode_key* dir_key);
+};
+
+// a string as its length, a space, its bytes and a new line.
+bool zo_read_str(std::istream& istm, zo_string& str);
+void zo_write_str(std::ostream& ostm, const zo_string& str);
+
+#endif		// ZO_SNAPSHOT_H
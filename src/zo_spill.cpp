@@ -0,0 +1,191 @@
+
+
+#ifdef HAS_FILESYSTEM
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <unistd.h>
+
+#include "zo_spill.h"
+#include "zo_mem.h"
+
+static
+void
+write_rec(std::ostream& os, const zo_run_rec& rec){
+	int64_t vv = rec.val;
+	uint32_t sz = (uint32_t)rec.key.size();
+	os.write((const char*)&vv, sizeof(vv));
+	os.write((const char*)&sz, sizeof(sz));
+	os.write(rec.key.data(), sz);
+}
+
+// false at the end of the run. bad is set when it ends in the middle of a record.
+static
+bool
+read_rec(std::istream& is, zo_run_rec& rec, bool& bad){
+	int64_t vv = 0;
+	uint32_t sz = 0;
+	if(! is.read((char*)&vv, sizeof(vv))){
+		bad = ! (is.eof() && (is.gcount() == 0));
+		return false;
+	}
+	if(! is.read((char*)&sz, sizeof(sz))){
+		bad = true;
+		return false;
+	}
+	rec.val = vv;
+	rec.key.resize(sz);
+	if(! is.read(&(rec.key[0]), sz)){
+		bad = true;
+		return false;
+	}
+	return true;
+}
+
+// a new directory for run files in the temp dir (TMPDIR), not in the organized tree.
+bool
+zo_make_spill_dir(const zo_string& nam, zo_string& dir){
+	std::error_code ec;
+	fs::path tdir = fs::temp_directory_path(ec);
+	if(ec){
+		fprintf(stderr, "Cannot find the temp directory for run files\n");
+		return false;
+	}
+	fs::path sdir = tdir / ("sfz_organizer_" + nam + "_" + std::to_string(getpid()));
+	fs::create_directories(sdir, ec);
+	if(ec){
+		fprintf(stderr, "Cannot create directory:'%s'\n", sdir.c_str());
+		return false;
+	}
+	dir = sdir;
+	return true;
+}
+
+void
+zo_remove_spill_dir(const zo_string& dir){
+	if(dir.empty()){
+		return;
+	}
+	std::error_code ec;
+	fs::remove_all(dir, ec);
+}
+
+void
+zo_run_writer::init(const zo_string& bs, long mx_bytes){
+	base = bs;
+	max_bytes = mx_bytes;
+}
+
+bool
+zo_run_writer::add(const zo_string& key, long val){
+	{
+		ZO_MEM_SCOPE(spill);
+		all_rec.push_back(zo_run_rec{key, val});
+	}
+	tot_rec++;
+	tot_bytes += (long)(sizeof(zo_run_rec) + key.size());
+	if(tot_bytes >= max_bytes){
+		return spill();
+	}
+	return ! bad;
+}
+
+bool
+zo_run_writer::spill(){
+	if(bad || all_rec.empty()){
+		return ! bad;
+	}
+	std::sort(all_rec.begin(), all_rec.end());
+	zo_string fnam = base + "_" + std::to_string(all_run.size());
+	std::ofstream ostm;
+	ostm.open(fnam.c_str(), std::ios::binary);
+	if(! ostm.good() || ! ostm.is_open()){
+		fprintf(stderr, "Cannot open file:'%s'\n", fnam.c_str());
+		bad = true;
+		return false;
+	}
+	all_run.push_back(fnam);
+	for(const auto& rec : all_rec){
+		write_rec(ostm, rec);
+	}
+	zo_run_rec_vec().swap(all_rec);
+	tot_bytes = 0;
+	ostm.close();
+	if(! ostm){
+		fprintf(stderr, "Cannot write file:'%s'\n", fnam.c_str());
+		bad = true;
+		return false;
+	}
+	return true;
+}
+
+void
+zo_run_writer::remove_runs(){
+	for(const auto& fnam : all_run){
+		std::remove(fnam.c_str());
+	}
+	all_run.clear();
+	zo_run_rec_vec().swap(all_rec);
+	tot_bytes = 0;
+}
+
+bool
+zo_run_merger::open(zo_run_writer& wrt){
+	if(! wrt.spill()){
+		return false;
+	}
+	for(const auto& fnam : wrt.all_run){
+		auto istm = std::make_unique<std::ifstream>(fnam.c_str(), std::ios::binary);
+		if(! istm->good()){
+			fprintf(stderr, "Cannot open file:'%s'\n", fnam.c_str());
+			return false;
+		}
+		zo_run_head hh;
+		hh.run = (long)all_in.size();
+		if(read_rec(*istm, hh.rec, bad)){
+			heads.push(hh);
+		}
+		if(bad){
+			fprintf(stderr, "Cannot read file:'%s'\n", fnam.c_str());
+			return false;
+		}
+		all_in.push_back(std::move(istm));
+		all_nam.push_back(fnam);
+	}
+	return true;
+}
+
+void
+zo_run_merger::pop(){
+	zo_run_head hh = heads.top();
+	heads.pop();
+	if(read_rec(*(all_in[hh.run]), hh.rec, bad)){
+		heads.push(hh);
+	}
+	if(bad){
+		fprintf(stderr, "Cannot read file:'%s'\n", all_nam[hh.run].c_str());
+	}
+}
+
+bool
+zo_run_merger::next_key(zo_string& key, long& val, long& tot){
+	if(! has_next()){
+		return false;
+	}
+	key = top().key;
+	val = 0;
+	tot = 0;
+	while(has_next() && (top().key == key)){
+		val |= top().val;
+		tot++;
+		pop();
+	}
+	return ! bad;
+}
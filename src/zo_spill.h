@@ -0,0 +1,134 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+
+
+zo_spill.h
+
+sorted runs of (key, value) records spilled to temporary files
+and their k-way merge, for --max_memory.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_SPILL_H
+#define ZO_SPILL_H
+
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "dbg_util.h"
+
+class zo_run_rec {
+public:
+	zo_string 	key{""};
+	long 		val{0};
+	
+	bool operator < (const zo_run_rec& rr) const {
+		if(key != rr.key){
+			return (key < rr.key);
+		}
+		return (val < rr.val);
+	}
+};
+
+using zo_run_rec_vec = std::vector<zo_run_rec>;
+
+// keeps records until they take max_bytes, then writes them sorted as one run file.
+class zo_run_writer {
+	zo_run_writer(zo_run_writer& rr) = delete;
+	zo_run_writer& operator = (const zo_run_writer& rr) = delete;
+
+public:
+	zo_string 				base{""};	// run files are base_N
+	long 					max_bytes{0};
+	long 					tot_bytes{0};
+	long 					tot_rec{0};
+	bool 					bad{false};	// a run could not be written. No later run is either
+	zo_run_rec_vec 			all_rec;
+	std::vector<zo_string> 	all_run;
+	
+	zo_run_writer(){}
+	
+	~zo_run_writer(){
+		remove_runs();
+	}
+	
+	void init(const zo_string& bs, long mx_bytes);
+	bool add(const zo_string& key, long val);
+	bool spill();
+	void remove_runs();
+};
+
+class zo_run_head {
+public:
+	zo_run_rec 	rec;
+	long 		run{0};
+	
+	bool operator > (const zo_run_head& hh) const {
+		if(hh.rec < rec){ return true; }
+		if(rec < hh.rec){ return false; }
+		return (run > hh.run);
+	}
+};
+
+// reads all runs of a zo_run_writer in key order.
+class zo_run_merger {
+	zo_run_merger(zo_run_merger& rr) = delete;
+	zo_run_merger& operator = (const zo_run_merger& rr) = delete;
+
+public:
+	std::vector<std::unique_ptr<std::ifstream>> 	all_in;
+	std::vector<zo_string> 	all_nam;
+	std::priority_queue<zo_run_head, std::vector<zo_run_head>, std::greater<zo_run_head>> 	heads;
+	bool 	bad{false};	// a run ended in the middle of a record. No more records are given
+	
+	zo_run_merger(){}
+	
+	bool open(zo_run_writer& wrt);
+	
+	bool has_next(){
+		return (! bad && ! heads.empty());
+	}
+	
+	const zo_run_rec& top(){
+		return heads.top().rec;
+	}
+	
+	void pop();
+	
+	// the next key, with its values or-ed and how many records had it. false at the end or when bad.
+	bool next_key(zo_string& key, long& val, long& tot);
+};
+
+bool zo_make_spill_dir(const zo_string& nam, zo_string& dir);
+void zo_remove_spill_dir(const zo_string& dir);
+
+#endif		// ZO_SPILL_H
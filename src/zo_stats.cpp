@@ -0,0 +1,161 @@
+
+
+#include <stdio.h>
+#include <time.h>
+
+#include "zo_stats.h"
+
+zo_stats ZO_STATS;
+
+static const char* ZO_PHASE_NAMES[ZO_TOT_PHASES] = {
+	"total",
+	"read_selected",
+	"parse_sfz",
+	"prepare",
+	"calc_next",
+	"print_actions",
+	"do_actions"
+};
+
+static const char* ZO_COUNTER_NAMES[ZO_TOT_COUNTERS] = {
+	"files_scanned",
+	"dirs_listed",
+	"sfz_parsed",
+	"refs_resolved",
+	"bad_refs",
+	"conflicts",
+	"bytes_read",
+	"bytes_written",
+	"files_copied",
+	"files_linked",
+	"files_moved",
+	"actions_total",
+	"actions_done",
+	"meta_prefetched",
+	"meta_hits",
+	"meta_waits",
+	"meta_misses",
+	"rel_paths"
+};
+
+static const char* ZO_SYSCALL_NAMES[ZO_TOT_SYSCALLS] = {
+	"open",
+	"getdents64",
+	"stat",
+	"fstat",
+	"fstatat",
+	"realpath",
+	"rename",
+	"copy",
+	"link",
+	"unlink",
+	"mkdir",
+	"io_uring_enter"
+};
+
+const char*
+zo_phase_name(zo_phase ph){
+	return ZO_PHASE_NAMES[(int)ph];
+}
+
+const char*
+zo_counter_name(zo_cnt cc){
+	return ZO_COUNTER_NAMES[(int)cc];
+}
+
+const char*
+zo_syscall_name(zo_sys cc){
+	return ZO_SYSCALL_NAMES[(int)cc];
+}
+
+static
+long
+get_clock_ns(clockid_t clk){
+	struct timespec tm;
+	clock_gettime(clk, &tm);
+	return (tm.tv_sec * 1000000000L) + tm.tv_nsec;
+}
+
+long
+zo_wall_ns(){
+	return get_clock_ns(CLOCK_MONOTONIC);
+}
+
+long
+zo_cpu_ns(){
+	return get_clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+zo_string
+zo_json_str(const zo_string& str){
+	zo_string js = "\"";
+	for(unsigned char cc : str){
+		switch(cc){
+			case '"': js += "\\\""; break;
+			case '\\': js += "\\\\"; break;
+			case '\n': js += "\\n"; break;
+			case '\r': js += "\\r"; break;
+			case '\t': js += "\\t"; break;
+			default:
+				if(cc < 0x20){
+					char hx[8];
+					snprintf(hx, sizeof(hx), "\\u%04x", cc);
+					js += hx;
+				} else {
+					js += (char)cc;
+				}
+				break;
+		}
+	}
+	js += "\"";
+	return js;
+}
+
+void
+zo_stats::print_json(zo_ostream& os, const zo_string& extra){
+	os << "{\n";
+	if(! extra.empty()){
+		os << extra << ",\n";
+	}
+	os << "\"phases\": {\n";
+	for(int aa = 0; aa < ZO_TOT_PHASES; aa++){
+		zo_phase_time& pt = all_phase[aa];
+		os << "\t" << zo_json_str(ZO_PHASE_NAMES[aa]) << ": {"
+			<< "\"calls\": " << pt.calls.load()
+			<< ", \"wall_ms\": " << (pt.wall_ns.load() / 1.0e6)
+			<< ", \"cpu_ms\": ";
+		if(pt.has_cpu.load()){
+			os << (pt.cpu_ns.load() / 1.0e6);
+		} else {
+			os << "null";
+		}
+		os << "}"
+			<< (((aa + 1) < ZO_TOT_PHASES)?(","):("")) << "\n";
+	}
+	os << "},\n";
+	os << "\"counters\": {\n";
+	for(int aa = 0; aa < ZO_TOT_COUNTERS; aa++){
+		os << "\t" << zo_json_str(ZO_COUNTER_NAMES[aa]) << ": " << all_cnt[aa].load()
+			<< (((aa + 1) < ZO_TOT_COUNTERS)?(","):("")) << "\n";
+	}
+	os << "},\n";
+	os << "\"syscalls\": {\n";
+	for(int aa = 0; aa < ZO_TOT_SYSCALLS; aa++){
+		os << "\t" << zo_json_str(ZO_SYSCALL_NAMES[aa]) << ": " << all_sys[aa].load()
+			<< (((aa + 1) < ZO_TOT_SYSCALLS)?(","):("")) << "\n";
+	}
+	os << "}\n";
+	os << "}\n";
+}
+
+bool
+zo_stats::write_json(const zo_string& fnam, const zo_string& extra){
+	std::ofstream ostm;
+	ostm.open(fnam.c_str(), std::ios::binary);
+	if(! ostm.good() || ! ostm.is_open()){
+		fprintf(stderr, "Cannot open file:'%s'\n", fnam.c_str());
+		return false;
+	}
+	print_json(ostm, extra);
+	return ostm.good();
+}
@@ -0,0 +1,194 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+zo_stats.h
+
+phase timers and run counters. Written as JSON with --stats.
+Counters are always updated (relaxed atomics). Phases may nest,
+each one accumulates its own wall and cpu time. Phases timed per
+file (parse_sfz, calc_next) skip the cpu clock and report null.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_STATS_H
+#define ZO_STATS_H
+
+#include <atomic>
+
+#include "dbg_util.h"
+#include "zo_trace.h"
+
+enum class zo_phase : int {
+	total,
+	read_selected,
+	parse_sfz,
+	prepare,
+	calc_next,
+	print_actions,
+	do_actions,
+	tot_phases
+};
+
+enum class zo_cnt : int {
+	files_scanned,
+	dirs_listed,
+	sfz_parsed,
+	refs_resolved,
+	bad_refs,
+	conflicts,
+	bytes_read,
+	bytes_written,
+	files_copied,
+	files_linked,
+	files_moved,
+	actions_total,
+	actions_done,
+	meta_prefetched,
+	meta_hits,
+	meta_waits,
+	meta_misses,
+	rel_paths,
+	tot_counters
+};
+
+enum class zo_sys : int {
+	open,
+	getdents64,
+	stat,
+	fstat,
+	fstatat,
+	realpath,
+	rename,
+	copy,
+	link,
+	unlink,
+	mkdir,
+	io_uring_enter,
+	tot_syscalls
+};
+
+constexpr int ZO_TOT_PHASES = (int)zo_phase::tot_phases;
+constexpr int ZO_TOT_COUNTERS = (int)zo_cnt::tot_counters;
+constexpr int ZO_TOT_SYSCALLS = (int)zo_sys::tot_syscalls;
+
+class zo_phase_time {
+public:
+	std::atomic<long> 	wall_ns{0};
+	std::atomic<long> 	cpu_ns{0};
+	std::atomic<long> 	calls{0};
+	std::atomic<bool> 	has_cpu{false};
+};
+
+class zo_stats {
+public:
+	zo_phase_time 		all_phase[ZO_TOT_PHASES];
+	std::atomic<long> 	all_cnt[ZO_TOT_COUNTERS];
+	std::atomic<long> 	all_sys[ZO_TOT_SYSCALLS];
+	std::atomic<int> 	curr_phase{(int)zo_phase::total};	// innermost phase timed with cpu
+
+	zo_stats(){
+		for(auto& cc : all_cnt){ cc = 0; }
+		for(auto& cc : all_sys){ cc = 0; }
+	}
+
+	void add(zo_cnt cc, long vv = 1){
+		all_cnt[(int)cc].fetch_add(vv, std::memory_order_relaxed);
+	}
+
+	void sys(zo_sys cc, long vv = 1){
+		all_sys[(int)cc].fetch_add(vv, std::memory_order_relaxed);
+	}
+
+	long get(zo_cnt cc){
+		return all_cnt[(int)cc].load(std::memory_order_relaxed);
+	}
+
+	void add_phase(zo_phase ph, long wall_ns, long cpu_ns){
+		zo_phase_time& pt = all_phase[(int)ph];
+		pt.wall_ns.fetch_add(wall_ns, std::memory_order_relaxed);
+		if(cpu_ns >= 0){
+			pt.cpu_ns.fetch_add(cpu_ns, std::memory_order_relaxed);
+			pt.has_cpu.store(true, std::memory_order_relaxed);
+		}
+		pt.calls.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void print_json(zo_ostream& os, const zo_string& extra);
+	bool write_json(const zo_string& fnam, const zo_string& extra);
+};
+
+extern zo_stats ZO_STATS;
+
+#define ZO_STAT_ADD(cnt, vv) ZO_STATS.add(zo_cnt::cnt, vv)
+#define ZO_STAT_INC(cnt) ZO_STATS.add(zo_cnt::cnt, 1)
+#define ZO_SYS_INC(cll) ZO_STATS.sys(zo_sys::cll, 1)
+
+long zo_wall_ns();
+long zo_cpu_ns();
+const char* zo_phase_name(zo_phase ph);
+const char* zo_counter_name(zo_cnt cc);
+const char* zo_syscall_name(zo_sys cc);
+
+class zo_phase_timer {
+	zo_phase_timer(zo_phase_timer& rr) = delete;
+	zo_phase_timer& operator = (const zo_phase_timer& rr) = delete;
+
+public:
+	zo_phase 	phase;
+	bool 		with_cpu{true};
+	long 		wall_0{0};
+	long 		cpu_0{0};
+	int 		prev_phase{0};
+
+	zo_phase_timer(zo_phase ph, bool w_cpu = true){
+		phase = ph;
+		with_cpu = w_cpu;
+		wall_0 = zo_wall_ns();
+		cpu_0 = (with_cpu)?(zo_cpu_ns()):(0);
+		if(with_cpu){
+			prev_phase = ZO_STATS.curr_phase.exchange((int)ph, std::memory_order_relaxed);
+		}
+	}
+
+	~zo_phase_timer(){
+		long wall_t = zo_wall_ns() - wall_0;
+		long cpu_t = (with_cpu)?(zo_cpu_ns() - cpu_0):(-1);
+		ZO_STATS.add_phase(phase, wall_t, cpu_t);
+		if(with_cpu){
+			ZO_STATS.curr_phase.store(prev_phase, std::memory_order_relaxed);
+		}
+		if(with_cpu && ZO_TRACE.is_on.load(std::memory_order_relaxed)){
+			ZO_TRACE.add(zo_phase_name(phase), "phase", wall_0, wall_t, "", 0);
+		}
+	}
+};
+
+zo_string zo_json_str(const zo_string& str);
+
+#endif		// ZO_STATS_H
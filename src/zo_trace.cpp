@@ -0,0 +1,122 @@
+
+
+#include <string.h>
+#include <unistd.h>
+
+#include "zo_trace.h"
+#include "zo_stats.h"
+
+constexpr long ZO_TRACE_FILE_BUFF_SZ = 1024 * 1024;
+
+zo_trace ZO_TRACE;
+
+thread_local zo_trace_ring* ZO_TRACE_THD_RING = zo_null;
+
+bool
+zo_trace::start(const zo_string& f_nam){
+	fnam = f_nam;
+	out = fopen(fnam.c_str(), "wb");
+	if(out == zo_null){
+		fprintf(stderr, "Cannot open file:'%s'\n", fnam.c_str());
+		return false;
+	}
+	setvbuf(out, zo_null, _IOFBF, ZO_TRACE_FILE_BUFF_SZ);
+	start_ns = zo_wall_ns();
+	fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": 0, \"args\": {\"name\": \"sfz_organizer\"}}", 
+			(int)getpid());
+	tot_written = 1;
+	is_on = true;
+	return true;
+}
+
+zo_trace_ring&
+zo_trace::get_ring(){
+	if(ZO_TRACE_THD_RING == zo_null){
+		zo_trace_ring* rng = new zo_trace_ring;
+		std::lock_guard<std::mutex> lck(mtx);
+		rng->tid = (long)all_rings.size();
+		all_rings.push_back(rng);
+		ZO_TRACE_THD_RING = rng;
+	}
+	return *ZO_TRACE_THD_RING;
+}
+
+void
+zo_trace::flush_ring(zo_trace_ring& rng){
+	int pid = (int)getpid();
+	for(long aa = 0; aa < rng.tot_ev; aa++){
+		zo_trace_event& ev = rng.all_ev[aa];
+		fprintf(out, ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %ld", 
+				ev.name, ev.cat, (ev.ts_ns - start_ns) / 1.0e3, ev.dur_ns / 1.0e3, pid, rng.tid);
+		if(ev.detail[0] != '\0'){
+			fprintf(out, ", \"args\": {\"path\": %s}", zo_json_str(ev.detail).c_str());
+		}
+		fprintf(out, "}");
+	}
+	tot_written += rng.tot_ev;
+	rng.tot_ev = 0;
+}
+
+void
+zo_trace::add(const char* name, const char* cat, long ts_ns, long dur_ns, const char* detail, long detail_sz){
+	zo_trace_ring& rng = get_ring();
+	if(rng.tot_ev == ZO_TRACE_RING_SZ){
+		std::lock_guard<std::mutex> lck(mtx);
+		flush_ring(rng);
+	}
+	zo_trace_event& ev = rng.all_ev[rng.tot_ev++];
+	ev.name = name;
+	ev.cat = cat;
+	ev.ts_ns = ts_ns;
+	ev.dur_ns = dur_ns;
+	zo_trace_copy_detail(ev.detail, detail, detail_sz);
+}
+
+long
+zo_trace_copy_detail(char* dst, const char* detail, long detail_sz){
+	// keep the tail of long paths. It has the file name.
+	long fst = 0;
+	if(detail_sz >= ZO_TRACE_DETAIL_SZ){
+		fst = detail_sz - (ZO_TRACE_DETAIL_SZ - 1);
+	}
+	long sz = detail_sz - fst;
+	memcpy(dst, detail + fst, sz);
+	dst[sz] = '\0';
+	return sz;
+}
+
+void
+zo_trace::finish(){
+	if(! is_on){
+		return;
+	}
+	is_on = false;
+	std::lock_guard<std::mutex> lck(mtx);
+	for(zo_trace_ring* rng : all_rings){
+		flush_ring(*rng);
+		fprintf(out, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %ld, \"args\": {\"name\": \"thread_%ld\"}}", 
+				(int)getpid(), rng->tid, rng->tid);
+	}
+	fprintf(out, "\n]}\n");
+	fclose(out);
+	out = zo_null;
+	fprintf(stderr, "Trace: %ld events written to '%s'\n", tot_written, fnam.c_str());
+}
+
+zo_trace_span::zo_trace_span(const char* nm, const char* ct, const zo_string& dt){
+	name = nm;
+	cat = ct;
+	if(ZO_TRACE.is_on.load(std::memory_order_relaxed)){
+		detail_sz = zo_trace_copy_detail(detail, dt.c_str(), (long)dt.size());
+		ts_ns = zo_wall_ns();
+	}
+}
+
+zo_trace_span::~zo_trace_span(){
+	if((ts_ns == 0) || ! ZO_TRACE.is_on.load(std::memory_order_relaxed)){
+		return;
+	}
+	long dur = zo_wall_ns() - ts_ns;
+	ZO_TRACE.add(name, cat, ts_ns, dur, detail, detail_sz);
+}
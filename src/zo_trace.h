@@ -0,0 +1,107 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+zo_trace.h
+
+Chrome / Perfetto trace-event export (--trace).
+Spans are kept in a per-thread ring of fixed size events. A full ring
+is flushed to the trace file by its own thread, so recording a span only
+takes two clock reads and a bounded copy of its detail string.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_TRACE_H
+#define ZO_TRACE_H
+
+#include <stdio.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "dbg_util.h"
+
+constexpr long ZO_TRACE_DETAIL_SZ = 120;
+constexpr long ZO_TRACE_RING_SZ = 4096;
+
+class zo_trace_event {
+public:
+	const char* 	name{zo_null};
+	const char* 	cat{zo_null};
+	long 			ts_ns{0};
+	long 			dur_ns{0};
+	char 			detail[ZO_TRACE_DETAIL_SZ];
+};
+
+class zo_trace_ring {
+public:
+	long 			tid{0};
+	long 			tot_ev{0};
+	zo_trace_event 	all_ev[ZO_TRACE_RING_SZ];
+};
+
+class zo_trace {
+public:
+	std::atomic<bool>	is_on{false};
+	FILE* 			out{zo_null};
+	zo_string 		fnam{""};
+	long 			start_ns{0};
+	long 			tot_written{0};
+
+	std::mutex 		mtx;	// guards out and all_rings
+	std::vector<zo_trace_ring*> all_rings;
+
+	bool start(const zo_string& f_nam);
+	void finish();
+
+	zo_trace_ring& get_ring();
+	void flush_ring(zo_trace_ring& rng);
+	void add(const char* name, const char* cat, long ts_ns, long dur_ns, const char* detail, long detail_sz);
+};
+
+long zo_trace_copy_detail(char* dst, const char* detail, long detail_sz);
+
+extern zo_trace ZO_TRACE;
+
+class zo_trace_span {
+	zo_trace_span(zo_trace_span& rr) = delete;
+	zo_trace_span& operator = (const zo_trace_span& rr) = delete;
+
+public:
+	const char* 	name;
+	const char* 	cat;
+	long 			ts_ns{0};
+	long 			detail_sz{0};
+	char 			detail[ZO_TRACE_DETAIL_SZ];
+
+	zo_trace_span(const char* nm, const char* ct, const zo_string& dt);
+	~zo_trace_span();
+};
+
+#endif		// ZO_TRACE_H
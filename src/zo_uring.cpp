@@ -0,0 +1,544 @@
+
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+#include "zo_uring.h"
+
+constexpr __u64 ZO_URING_TAG_OPEN_SRC = (1ULL << 40);
+constexpr __u64 ZO_URING_TAG_OPEN_DST = (1ULL << 40) + 1;
+constexpr __u64 ZO_URING_TAG_STATX = (1ULL << 40) + 2;
+
+static
+int
+sys_uring_setup(unsigned entries, io_uring_params* prm){
+	return (int)syscall(__NR_io_uring_setup, entries, prm);
+}
+
+static
+int
+sys_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags){
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, zo_null, 0);
+}
+
+static
+int
+sys_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args){
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+class zo_uring {
+	zo_uring(zo_uring& rr) = delete;
+	zo_uring& operator = (const zo_uring& rr) = delete;
+
+public:
+	int 			ring_fd{-1};
+	unsigned 		sq_entries{0};
+	
+	void* 			sq_ptr{MAP_FAILED};
+	size_t 			sq_sz{0};
+	void* 			cq_ptr{MAP_FAILED};
+	size_t 			cq_sz{0};
+	void* 			sqe_ptr{MAP_FAILED};
+	size_t 			sqe_sz{0};
+	
+	unsigned* 		sq_head{zo_null};
+	unsigned* 		sq_tail{zo_null};
+	unsigned* 		sq_mask{zo_null};
+	unsigned* 		sq_array{zo_null};
+	io_uring_sqe* 	all_sqe{zo_null};
+	unsigned* 		cq_head{zo_null};
+	unsigned* 		cq_tail{zo_null};
+	unsigned* 		cq_mask{zo_null};
+	io_uring_cqe* 	all_cqe{zo_null};
+	
+	unsigned 		local_tail{0};
+	unsigned 		to_submit{0};
+	
+	std::vector<char> 	buff;	// chunks of copy_file
+	
+	zo_uring(){}
+	~zo_uring();
+	
+	int init(unsigned entries);
+	bool has_all_ops();
+	io_uring_sqe* get_sqe();
+	int submit(unsigned wait_nr);
+	bool pop_cqe(__u64& tag, int& res);
+	void wait_cqe(__u64& tag, int& res);
+};
+
+zo_uring::~zo_uring(){
+	if(sqe_ptr != MAP_FAILED){
+		munmap(sqe_ptr, sqe_sz);
+	}
+	if((cq_ptr != MAP_FAILED) && (cq_ptr != sq_ptr)){
+		munmap(cq_ptr, cq_sz);
+	}
+	if(sq_ptr != MAP_FAILED){
+		munmap(sq_ptr, sq_sz);
+	}
+	if(ring_fd >= 0){
+		close(ring_fd);
+	}
+}
+
+int
+zo_uring::init(unsigned entries){
+	io_uring_params prm;
+	memset(&prm, 0, sizeof(prm));
+	ring_fd = sys_uring_setup(entries, &prm);
+	if(ring_fd < 0){
+		return -errno;
+	}
+	sq_entries = prm.sq_entries;
+	sq_sz = prm.sq_off.array + (prm.sq_entries * sizeof(unsigned));
+	cq_sz = prm.cq_off.cqes + (prm.cq_entries * sizeof(io_uring_cqe));
+	bool single = ((prm.features & IORING_FEAT_SINGLE_MMAP) != 0);
+	if(single){
+		sq_sz = std::max(sq_sz, cq_sz);
+	}
+	sq_ptr = mmap(zo_null, sq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+	if(sq_ptr == MAP_FAILED){
+		return -errno;
+	}
+	if(single){
+		cq_ptr = sq_ptr;
+	} else {
+		cq_ptr = mmap(zo_null, cq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+		if(cq_ptr == MAP_FAILED){
+			return -errno;
+		}
+	}
+	sqe_sz = prm.sq_entries * sizeof(io_uring_sqe);
+	sqe_ptr = mmap(zo_null, sqe_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+	if(sqe_ptr == MAP_FAILED){
+		return -errno;
+	}
+	
+	char* sq = (char*)sq_ptr;
+	sq_head = (unsigned*)(sq + prm.sq_off.head);
+	sq_tail = (unsigned*)(sq + prm.sq_off.tail);
+	sq_mask = (unsigned*)(sq + prm.sq_off.ring_mask);
+	sq_array = (unsigned*)(sq + prm.sq_off.array);
+	all_sqe = (io_uring_sqe*)sqe_ptr;
+	
+	char* cq = (char*)cq_ptr;
+	cq_head = (unsigned*)(cq + prm.cq_off.head);
+	cq_tail = (unsigned*)(cq + prm.cq_off.tail);
+	cq_mask = (unsigned*)(cq + prm.cq_off.ring_mask);
+	all_cqe = (io_uring_cqe*)(cq + prm.cq_off.cqes);
+	
+	local_tail = *sq_tail;
+	return 0;
+}
+
+bool
+zo_uring::has_all_ops(){
+	const unsigned tot_ops = 256;
+	std::vector<char> mem(sizeof(io_uring_probe) + (tot_ops * sizeof(io_uring_probe_op)), 0);
+	io_uring_probe* prb = (io_uring_probe*)mem.data();
+	if(sys_uring_register(ring_fd, IORING_REGISTER_PROBE, prb, tot_ops) < 0){
+		return false;
+	}
+	for(int op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_WRITE}){
+		if((op > prb->last_op) || ((prb->ops[op].flags & IO_URING_OP_SUPPORTED) == 0)){
+			return false;
+		}
+	}
+	return true;
+}
+
+io_uring_sqe*
+zo_uring::get_sqe(){
+	for(;;){
+		unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+		if((local_tail - head) < sq_entries){
+			break;
+		}
+		submit(0);
+	}
+	unsigned idx = local_tail & *sq_mask;
+	sq_array[idx] = idx;
+	io_uring_sqe* sqe = &all_sqe[idx];
+	memset(sqe, 0, sizeof(*sqe));
+	local_tail++;
+	to_submit++;
+	return sqe;
+}
+
+int
+zo_uring::submit(unsigned wait_nr){
+	__atomic_store_n(sq_tail, local_tail, __ATOMIC_RELEASE);
+	for(;;){
+		ZO_SYS_INC(io_uring_enter);
+		int rr = sys_uring_enter(ring_fd, to_submit, wait_nr, (wait_nr > 0)?(IORING_ENTER_GETEVENTS):(0));
+		if(rr < 0){
+			if((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY)){
+				continue;
+			}
+			return -errno;
+		}
+		to_submit -= std::min((unsigned)rr, to_submit);
+		return rr;
+	}
+}
+
+bool
+zo_uring::pop_cqe(__u64& tag, int& res){
+	unsigned head = *cq_head;
+	unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+	if(head == tail){
+		return false;
+	}
+	io_uring_cqe& cqe = all_cqe[head & *cq_mask];
+	tag = cqe.user_data;
+	res = cqe.res;
+	__atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+void
+zo_uring::wait_cqe(__u64& tag, int& res){
+	while(! pop_cqe(tag, res)){
+		int rr = submit(1);
+		if(rr < 0){
+			// operations in flight still own their buffers. Cannot go on.
+			fprintf(stderr, "io_uring_enter failed: %s\n", strerror(-rr));
+			exit(1);
+		}
+	}
+}
+
+static
+void
+prep_rw(io_uring_sqe* sqe, int op, int fd, const void* addr, unsigned len, __u64 off, __u64 tag){
+	sqe->opcode = op;
+	sqe->fd = fd;
+	sqe->addr = (unsigned long)addr;
+	sqe->len = len;
+	sqe->off = off;
+	sqe->user_data = tag;
+}
+
+static
+void
+prep_openat(io_uring_sqe* sqe, const char* pth, int flags, mode_t md, __u64 tag){
+	prep_rw(sqe, IORING_OP_OPENAT, AT_FDCWD, pth, md, 0, tag);
+	sqe->open_flags = flags;
+}
+
+static
+void
+prep_statx(io_uring_sqe* sqe, const char* pth, struct statx* stx, __u64 tag){
+	prep_rw(sqe, IORING_OP_STATX, AT_FDCWD, pth, STATX_SIZE | STATX_MODE, (unsigned long)stx, tag);
+}
+
+// opens pth and gets its statx in one submit. The fd, or -errno.
+static
+int
+open_statx(zo_uring& rng, const zo_string& pth, struct statx& stx, int& stx_res){
+	prep_openat(rng.get_sqe(), pth.c_str(), O_RDONLY | O_CLOEXEC, 0, ZO_URING_TAG_OPEN_SRC);
+	prep_statx(rng.get_sqe(), pth.c_str(), &stx, ZO_URING_TAG_STATX);
+	int fd = -1;
+	for(int aa = 0; aa < 2; aa++){
+		__u64 tag = 0;
+		int res = 0;
+		rng.wait_cqe(tag, res);
+		if(tag == ZO_URING_TAG_OPEN_SRC){
+			fd = res;
+		} else {
+			stx_res = res;
+		}
+	}
+	return fd;
+}
+
+class zo_uring_slot {
+public:
+	long 	off{0};		// of the chunk in the file
+	long 	len{0};
+	long 	done{0};	// read, or written when writing
+	bool 	writing{false};
+	bool 	parked{false};	// read, waiting for the open of the destination
+	char* 	buf{zo_null};
+};
+
+// keeps up to depth chunks in flight. Reads go to mem (the whole file) when
+// given, otherwise to the ring buffer and then are written to dst_fd.
+class zo_uring_pipe {
+public:
+	zo_uring& 					rng;
+	int 						src_fd{-1};
+	long 						fsz{0};
+	char* 						mem{zo_null};
+	int 						dst_fd{-1};
+	bool 						dst_opening{false};
+	int 						dst_err{0};
+	int 						err{0};
+	long 						tot_done{0};	// bytes read into mem, or written
+	long 						nxt_off{0};
+	long 						in_flight{0};
+	std::vector<zo_uring_slot> 	all_slot;
+	
+	zo_uring_pipe(zo_uring& rg, long depth, int fd, long sz) : rng(rg) {
+		src_fd = fd;
+		fsz = sz;
+		all_slot.resize(depth);
+	}
+	
+	void run();
+	
+private:
+	void start_read(long idx);
+	void submit_read(long idx);
+	void submit_write(long idx);
+	void on_done(long idx, int res);
+	void on_dst_open(int res);
+};
+
+void
+zo_uring_pipe::run(){
+	if(mem == zo_null){
+		long need = (long)all_slot.size() * ZO_URING_CHUNK_SZ;
+		if((long)rng.buff.size() < need){
+			rng.buff.resize(need);
+		}
+	}
+	for(long aa = 0; aa < (long)all_slot.size(); aa++){
+		start_read(aa);
+	}
+	while((in_flight > 0) || dst_opening){
+		__u64 tag = 0;
+		int res = 0;
+		rng.wait_cqe(tag, res);
+		if(tag == ZO_URING_TAG_OPEN_DST){
+			on_dst_open(res);
+		} else {
+			on_done((long)tag, res);
+		}
+	}
+}
+
+void
+zo_uring_pipe::start_read(long idx){
+	zo_uring_slot& sl = all_slot[idx];
+	if((err != 0) || (nxt_off >= fsz)){
+		return;
+	}
+	sl.off = nxt_off;
+	sl.len = std::min(ZO_URING_CHUNK_SZ, fsz - nxt_off);
+	sl.done = 0;
+	sl.writing = false;
+	sl.parked = false;
+	sl.buf = (mem != zo_null)?(mem + sl.off):(rng.buff.data() + (idx * ZO_URING_CHUNK_SZ));
+	nxt_off += sl.len;
+	submit_read(idx);
+}
+
+void
+zo_uring_pipe::submit_read(long idx){
+	zo_uring_slot& sl = all_slot[idx];
+	prep_rw(rng.get_sqe(), IORING_OP_READ, src_fd, sl.buf + sl.done, sl.len - sl.done, sl.off + sl.done, idx);
+	in_flight++;
+}
+
+void
+zo_uring_pipe::submit_write(long idx){
+	zo_uring_slot& sl = all_slot[idx];
+	prep_rw(rng.get_sqe(), IORING_OP_WRITE, dst_fd, sl.buf + sl.done, sl.len - sl.done, sl.off + sl.done, idx);
+	in_flight++;
+}
+
+void
+zo_uring_pipe::on_dst_open(int res){
+	dst_opening = false;
+	if(res < 0){
+		dst_err = -res;
+		if(err == 0){
+			err = dst_err;
+		}
+		return;
+	}
+	dst_fd = res;
+	for(long aa = 0; aa < (long)all_slot.size(); aa++){
+		if(all_slot[aa].parked){
+			all_slot[aa].parked = false;
+			submit_write(aa);
+		}
+	}
+}
+
+void
+zo_uring_pipe::on_done(long idx, int res){
+	zo_uring_slot& sl = all_slot[idx];
+	in_flight--;
+	if(res < 0){
+		if(err == 0){
+			err = -res;
+		}
+		return;
+	}
+	if(sl.writing){
+		if(res == 0){
+			if(err == 0){
+				err = EIO;
+			}
+			return;
+		}
+		sl.done += res;
+		if(sl.done < sl.len){
+			submit_write(idx);
+			return;
+		}
+		tot_done += sl.len;
+		start_read(idx);
+		return;
+	}
+	if(res == 0){
+		// shorter than its statx
+		sl.len = sl.done;
+		fsz = std::min(fsz, sl.off + sl.done);
+	} else {
+		sl.done += res;
+		if(sl.done < sl.len){
+			submit_read(idx);
+			return;
+		}
+	}
+	if(mem != zo_null){
+		tot_done += sl.len;
+		start_read(idx);
+		return;
+	}
+	if(sl.len == 0){
+		start_read(idx);
+		return;
+	}
+	sl.writing = true;
+	sl.done = 0;
+	if(dst_opening){
+		sl.parked = true;
+		return;
+	}
+	if(dst_fd < 0){
+		return;
+	}
+	submit_write(idx);
+}
+
+static thread_local std::unique_ptr<zo_uring> ZO_THREAD_RING;
+static thread_local bool ZO_THREAD_RING_FAILED = false;
+
+bool
+zo_uring_supported(zo_string& why){
+	zo_uring rng;
+	int rr = rng.init(4);
+	if(rr < 0){
+		why = strerror(-rr);
+		return false;
+	}
+	if(! rng.has_all_ops()){
+		why = "kernel lacks openat, statx, read or write operations";
+		return false;
+	}
+	return true;
+}
+
+zo_uring*
+zo_uring_vfs::get_ring(){
+	if(ZO_THREAD_RING){
+		return ZO_THREAD_RING.get();
+	}
+	if(ZO_THREAD_RING_FAILED){
+		return zo_null;
+	}
+	std::unique_ptr<zo_uring> rng{new zo_uring()};
+	if((rng->init(depth + 2) < 0) || ! rng->has_all_ops()){
+		ZO_THREAD_RING_FAILED = true;
+		return zo_null;
+	}
+	ZO_THREAD_RING = std::move(rng);
+	return ZO_THREAD_RING.get();
+}
+
+zo_istream_pt
+zo_uring_vfs::open_read(const zo_string& pth){
+	zo_uring* rng = get_ring();
+	if(rng == zo_null){
+		return zo_posix_vfs::open_read(pth);
+	}
+	struct statx stx;
+	int stx_res = 0;
+	int fd = open_statx(*rng, pth, stx, stx_res);
+	if(fd < 0){
+		errno = -fd;
+		return zo_istream_pt{};
+	}
+	if(stx_res < 0){
+		close(fd);
+		return zo_posix_vfs::open_read(pth);
+	}
+	
+	zo_string data((size_t)stx.stx_size, '\0');
+	zo_uring_pipe pip(*rng, depth, fd, (long)stx.stx_size);
+	pip.mem = &data[0];
+	pip.run();
+	close(fd);
+	if(pip.err != 0){
+		errno = pip.err;
+		return zo_istream_pt{};
+	}
+	data.resize(pip.tot_done);
+	return zo_istream_pt{new std::istringstream(std::move(data))};
+}
+
+long
+zo_uring_vfs::copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec){
+	zo_uring* rng = get_ring();
+	if(rng == zo_null){
+		return zo_posix_vfs::copy_file(orig, dest, replace, ec);
+	}
+	struct statx stx;
+	int stx_res = 0;
+	int src_fd = open_statx(*rng, orig, stx, stx_res);
+	if(src_fd < 0){
+		ec = std::error_code(-src_fd, std::generic_category());
+		return ZO_VFS_CANNOT_OPEN_SRC;
+	}
+	if(stx_res < 0){
+		close(src_fd);
+		return zo_posix_vfs::copy_file(orig, dest, replace, ec);
+	}
+	
+	// the destination opens while the first chunks are read
+	zo_uring_pipe pip(*rng, depth, src_fd, (long)stx.stx_size);
+	int flg = O_WRONLY | O_CREAT | O_CLOEXEC | ((replace)?(O_TRUNC):(O_EXCL));
+	prep_openat(rng->get_sqe(), dest.c_str(), flg, 
+				stx.stx_mode & 07777, ZO_URING_TAG_OPEN_DST);
+	pip.dst_opening = true;
+	pip.run();
+	close(src_fd);
+	if(pip.dst_err != 0){
+		ec = std::error_code(pip.dst_err, std::generic_category());
+		return ZO_VFS_CANNOT_OPEN_DST;
+	}
+	if(pip.err != 0){
+		ec = std::error_code(pip.err, std::generic_category());
+	}
+	if((close(pip.dst_fd) != 0) && ! ec){
+		ec = std::error_code(errno, std::generic_category());
+	}
+	return pip.tot_done;
+}
@@ -0,0 +1,70 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+
+zo_uring.h
+
+io_uring backend (--io_uring <depth>), with raw syscalls (no liburing).
+Reading a file and copying a sample submit the opens and the statx
+together and then keep up to <depth> chunk reads and writes in flight.
+Each thread has its own ring. When the kernel has no io_uring (or lacks
+one of the needed operations) the posix calls are used.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_URING_H
+#define ZO_URING_H
+
+#include "zo_vfs.h"
+
+constexpr long ZO_URING_CHUNK_SZ = 128 * 1024;
+
+// false and the reason when io_uring cannot be used.
+bool zo_uring_supported(zo_string& why);
+
+class zo_uring;
+
+class zo_uring_vfs : public zo_posix_vfs {
+public:
+	long 	depth{32};
+	
+	zo_uring_vfs(long dpth){
+		depth = dpth;
+	}
+	
+	const char* get_name(){ return "io_uring"; }
+	
+	zo_istream_pt open_read(const zo_string& pth);
+	long copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec);
+	
+private:
+	zo_uring* get_ring();
+};
+
+#endif		// ZO_URING_H
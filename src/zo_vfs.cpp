@@ -0,0 +1,693 @@
+
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+#ifdef HAS_FILESYSTEM
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include "zo_vfs.h"
+
+zo_posix_vfs ZO_POSIX_VFS;
+zo_vfs* ZO_VFS = &ZO_POSIX_VFS;
+
+constexpr long ZO_VFS_COPY_CHUNK_SZ = 1024 * 1024;
+constexpr long ZO_VFS_COPY_BUFFER_SZ = 64 * 1024;
+static thread_local unsigned char ZO_VFS_COPY_BUFFER[ZO_VFS_COPY_BUFFER_SZ];
+
+constexpr long ZO_MEM_VFS_FULL_SZ = 64 * 1024;	// bigger files keep only their head in memory
+constexpr long ZO_MEM_VFS_HEAD_SZ = 4 * 1024;
+
+static
+zo_ent_type
+get_st_type(mode_t md){
+	if(S_ISREG(md)){
+		return zo_ent_type::regular;
+	}
+	if(S_ISDIR(md)){
+		return zo_ent_type::directory;
+	}
+	return zo_ent_type::other;
+}
+
+zo_string
+zo_normal_path(const zo_string& pth){
+	zo_string apth = fs::absolute(pth);
+	std::vector<zo_string> all_part;
+	size_t pos = 0;
+	while(pos <= apth.size()){
+		size_t nx = apth.find('/', pos);
+		if(nx == zo_string::npos){
+			nx = apth.size();
+		}
+		zo_string part = apth.substr(pos, nx - pos);
+		pos = nx + 1;
+		if(part.empty() || (part == ".")){
+			continue;
+		}
+		if(part == ".."){
+			if(! all_part.empty()){
+				all_part.pop_back();
+			}
+			continue;
+		}
+		all_part.push_back(part);
+	}
+	zo_string nrm = "";
+	for(const auto& part : all_part){
+		nrm += '/';
+		nrm += part;
+	}
+	return (nrm.empty())?("/"):(nrm);
+}
+
+// posix
+
+bool
+zo_posix_vfs::stat(const zo_string& pth, zo_vfs_stat& st, bool follow){
+	struct stat sb;
+	ZO_SYS_INC(stat);
+	int rr = (follow)?(::stat(pth.c_str(), &sb)):(::lstat(pth.c_str(), &sb));
+	if(rr != 0){
+		return false;
+	}
+	st.is_lnk = S_ISLNK(sb.st_mode);
+	st.typ = (st.is_lnk)?(zo_ent_type::unknown):(get_st_type(sb.st_mode));
+	st.key.dev = sb.st_dev;
+	st.key.ino = sb.st_ino;
+	st.nlink = sb.st_nlink;
+	st.size = sb.st_size;
+	st.mode = sb.st_mode & 07777;
+	st.mtime_sec = sb.st_mtim.tv_sec;
+	st.mtime_nsec = sb.st_mtim.tv_nsec;
+	return true;
+}
+
+zo_string
+zo_posix_vfs::canonical(const zo_string& pth, std::error_code& ec){
+	ZO_SYS_INC(realpath);
+	return fs::canonical(pth, ec);
+}
+
+zo_scan_res
+zo_posix_vfs::scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent,
+					   zo_inode_set* all_visited, zo_inode_key* dir_key)
+{
+	return zo_scan_dir(dir_pth, all_ent, all_visited, dir_key);
+}
+
+zo_istream_pt
+zo_posix_vfs::open_read(const zo_string& pth){
+	std::ifstream* istm = new std::ifstream();
+	zo_istream_pt pt{istm};
+	ZO_SYS_INC(open);
+	istm->open(pth.c_str(), std::ios::binary);
+	if(! istm->good() || ! istm->is_open()){
+		return zo_istream_pt{};
+	}
+	return pt;
+}
+
+zo_ostream_pt
+zo_posix_vfs::open_write(const zo_string& pth){
+	std::ofstream* ostm = new std::ofstream();
+	zo_ostream_pt pt{ostm};
+	ZO_SYS_INC(open);
+	ostm->open(pth.c_str(), std::ios::binary);
+	if(! ostm->good() || ! ostm->is_open()){
+		return zo_ostream_pt{};
+	}
+	return pt;
+}
+
+long
+zo_posix_vfs::copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec){
+	ZO_SYS_INC(open);
+	int src_fd = open(orig.c_str(), O_RDONLY | O_CLOEXEC);
+	if(src_fd < 0){
+		ec = std::error_code(errno, std::generic_category());
+		return ZO_VFS_CANNOT_OPEN_SRC;
+	}
+	struct stat st;
+	ZO_SYS_INC(fstat);
+	if(fstat(src_fd, &st) != 0){
+		st.st_mode = 0644;
+		st.st_size = 0;
+	}
+	ZO_SYS_INC(open);
+	int flg = O_WRONLY | O_CREAT | O_CLOEXEC | ((replace)?(O_TRUNC):(O_EXCL));
+	int dst_fd = open(dest.c_str(), flg, st.st_mode & 07777);
+	if(dst_fd < 0){
+		ec = std::error_code(errno, std::generic_category());
+		close(src_fd);
+		return ZO_VFS_CANNOT_OPEN_DST;
+	}
+
+	long tot_cp = 0;
+	bool in_kernel = true;
+	for(;;){
+		ssize_t nn = 0;
+		if(in_kernel){
+			ZO_SYS_INC(copy);
+			nn = copy_file_range(src_fd, zo_null, dst_fd, zo_null, ZO_VFS_COPY_CHUNK_SZ, 0);
+			if((nn < 0) && (tot_cp == 0) && ((errno == EXDEV) || (errno == ENOSYS) ||
+					(errno == EINVAL) || (errno == EOPNOTSUPP)))
+			{
+				in_kernel = false;
+				continue;
+			}
+		} else {
+			nn = read(src_fd, ZO_VFS_COPY_BUFFER, ZO_VFS_COPY_BUFFER_SZ);
+			if(nn > 0){
+				ssize_t wr = 0;
+				while(wr < nn){
+					ssize_t ww = write(dst_fd, ZO_VFS_COPY_BUFFER + wr, nn - wr);
+					if(ww <= 0){
+						nn = -1;
+						break;
+					}
+					wr += ww;
+				}
+			}
+		}
+		if(nn <= 0){
+			if(nn < 0){
+				ec = std::error_code(errno, std::generic_category());
+			}
+			break;
+		}
+		tot_cp += nn;
+	}
+	close(src_fd);
+	if((close(dst_fd) != 0) && ! ec){	// NFS reports write errors here
+		ec = std::error_code(errno, std::generic_category());
+	}
+	return tot_cp;
+}
+
+void
+zo_posix_vfs::rename(const zo_string& orig, const zo_string& dest){
+	ZO_SYS_INC(rename);
+	fs::rename(orig, dest);
+}
+
+void
+zo_posix_vfs::remove(const zo_string& pth){
+	ZO_SYS_INC(unlink);
+	fs::remove(pth);
+}
+
+void
+zo_posix_vfs::create_directories(const zo_string& pth){
+	ZO_SYS_INC(mkdir);
+	fs::create_directories(pth);
+}
+
+void
+zo_posix_vfs::hard_link(const zo_string& orig, const zo_string& dest, std::error_code& ec){
+	ZO_SYS_INC(link);
+	fs::create_hard_link(orig, dest, ec);
+}
+
+// memory
+
+class zo_mem_ostream : public std::ostringstream {
+public:
+	zo_mem_vfs& 	vfs;
+	zo_string 		pth;
+
+	zo_mem_ostream(zo_mem_vfs& the_vfs, const zo_string& the_pth) : vfs(the_vfs), pth(the_pth) {}
+
+	~zo_mem_ostream(){
+		vfs.put_data(pth, str());
+	}
+};
+
+static
+std::error_code
+no_entry_err(){
+	return std::make_error_code(std::errc::no_such_file_or_directory);
+}
+
+zo_mem_vfs::zo_mem_vfs(){
+	root = make_node(zo_ent_type::directory);
+}
+
+zo_mem_node_pt
+zo_mem_vfs::make_node(zo_ent_type typ){
+	zo_mem_node_pt nd = std::make_shared<zo_mem_node>();
+	nd->typ = typ;
+	nd->ino = ++last_ino;
+	nd->mtime = clock++;
+	if(typ == zo_ent_type::directory){
+		nd->mode = 0755;
+		nd->nlink = 2;
+	}
+	return nd;
+}
+
+zo_mem_node_pt
+zo_mem_vfs::find_node(const zo_string& pth){
+	zo_string nrm = zo_normal_path(pth);
+	zo_mem_node_pt nd = root;
+	size_t pos = 1;
+	while((pos < nrm.size()) && (nd != zo_null)){
+		size_t nx = nrm.find('/', pos);
+		if(nx == zo_string::npos){
+			nx = nrm.size();
+		}
+		auto it = nd->all_child.find(nrm.substr(pos, nx - pos));
+		nd = (it == nd->all_child.end())?(zo_null):(it->second);
+		pos = nx + 1;
+	}
+	return nd;
+}
+
+zo_mem_node_pt
+zo_mem_vfs::find_parent(const zo_string& pth, zo_string& nam){
+	zo_string nrm = zo_normal_path(pth);
+	size_t pos = nrm.rfind('/');
+	nam = nrm.substr(pos + 1);
+	if(nam.empty()){
+		return zo_null;
+	}
+	zo_mem_node_pt pnt = find_node((pos == 0)?("/"):(nrm.substr(0, pos)));
+	if((pnt == zo_null) || (pnt->typ != zo_ent_type::directory)){
+		return zo_null;
+	}
+	return pnt;
+}
+
+zo_mem_node_pt
+zo_mem_vfs::make_dirs(const zo_string& pth){
+	zo_string nrm = zo_normal_path(pth);
+	zo_mem_node_pt nd = root;
+	size_t pos = 1;
+	while(pos < nrm.size()){
+		size_t nx = nrm.find('/', pos);
+		if(nx == zo_string::npos){
+			nx = nrm.size();
+		}
+		zo_string part = nrm.substr(pos, nx - pos);
+		pos = nx + 1;
+		auto it = nd->all_child.find(part);
+		if(it == nd->all_child.end()){
+			zo_mem_node_pt dd = make_node(zo_ent_type::directory);
+			nd->all_child[part] = dd;
+			nd->mtime = clock++;
+			nd = dd;
+			continue;
+		}
+		if(it->second->typ != zo_ent_type::directory){
+			return zo_null;
+		}
+		nd = it->second;
+	}
+	return nd;
+}
+
+void
+zo_mem_vfs::load_dir(const zo_string& real_dir, zo_mem_node_pt dir){
+	std::error_code ec;
+	for(const auto& entry : fs::directory_iterator(real_dir, ec)){
+		zo_string pth = entry.path();
+		zo_string nam = entry.path().filename();
+		auto st = fs::symlink_status(pth, ec);
+		if(ec || fs::is_symlink(st)){
+			continue;
+		}
+		if(fs::is_directory(st)){
+			zo_mem_node_pt dd = make_node(zo_ent_type::directory);
+			dir->all_child[nam] = dd;
+			load_dir(pth, dd);
+			continue;
+		}
+		if(! fs::is_regular_file(st)){
+			continue;
+		}
+		zo_mem_node_pt nd = make_node(zo_ent_type::regular);
+		nd->size = fs::file_size(pth, ec);
+		zo_string ext = entry.path().extension();
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		long to_read = ((ext == ".sfz") || (nd->size <= ZO_MEM_VFS_FULL_SZ))?(nd->size):(ZO_MEM_VFS_HEAD_SZ);
+		std::ifstream istm;
+		istm.open(pth.c_str(), std::ios::binary);
+		if(istm.good() && istm.is_open()){
+			nd->data.resize(to_read);
+			istm.read(&(nd->data[0]), to_read);
+			nd->data.resize(istm.gcount());
+		}
+		dir->all_child[nam] = nd;
+		tot_loaded++;
+	}
+}
+
+bool
+zo_mem_vfs::load_tree(const zo_string& real_dir){
+	std::error_code ec;
+	zo_string rpth = fs::canonical(real_dir, ec);
+	if(ec || ! fs::is_directory(rpth)){
+		return false;
+	}
+	std::lock_guard<std::mutex> lck(mtx);
+	zo_mem_node_pt dir = make_dirs(rpth);
+	if(dir == zo_null){
+		return false;
+	}
+	load_dir(rpth, dir);
+	return true;
+}
+
+void
+zo_mem_vfs::put_data(const zo_string& pth, const zo_string& data){
+	std::lock_guard<std::mutex> lck(mtx);
+	zo_mem_node_pt nd = find_node(pth);
+	if((nd == zo_null) || (nd->typ != zo_ent_type::regular)){
+		return;
+	}
+	nd->data = data;
+	nd->size = data.size();
+	nd->mtime = clock++;
+}
+
+bool
+zo_mem_vfs::stat(const zo_string& pth, zo_vfs_stat& st, bool follow){
+	ZO_SYS_INC(stat);
+	std::lock_guard<std::mutex> lck(mtx);
+	zo_mem_node_pt nd = find_node(pth);
+	if(nd == zo_null){
+		return false;
+	}
+	st.typ = nd->typ;
+	st.is_lnk = false;
+	st.key.dev = 0;
+	st.key.ino = nd->ino;
+	st.nlink = nd->nlink;
+	st.size = nd->size;
+	st.mode = nd->mode;
+	st.mtime_sec = nd->mtime;
+	st.mtime_nsec = 0;
+	return true;
+}
+
+zo_string
+zo_mem_vfs::canonical(const zo_string& pth, std::error_code& ec){
+	ZO_SYS_INC(realpath);
+	std::lock_guard<std::mutex> lck(mtx);
+	if(find_node(pth) == zo_null){
+		ec = no_entry_err();
+		return "";
+	}
+	ec.clear();
+	return zo_normal_path(pth);
+}
+
+zo_scan_res
+zo_mem_vfs::scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent,
+					 zo_inode_set* all_visited, zo_inode_key* dir_key)
+{
+	ZO_SYS_INC(open);
+	std::lock_guard<std::mutex> lck(mtx);
+	zo_mem_node_pt nd = find_node(dir_pth);
+	if((nd == zo_null) || (nd->typ != zo_ent_type::directory)){
+		return zo_scan_res::cannot_open;
+	}
+	zo_inode_key d_key;
+	d_key.ino = nd->ino;
+	if(dir_key != zo_null){
+		*dir_key = d_key;
+	}
+	if((all_visited != zo_null) && ! all_visited->insert(d_key).second){
+		return zo_scan_res::visited;
+	}
+	ZO_STAT_INC(dirs_listed);
+	ZO_SYS_INC(getdents64);
+	for(const auto& cc : nd->all_child){
+		all_ent.emplace_back();
+		zo_dir_ent& ent = all_ent.back();
+		ent.name = cc.first;
+		ent.typ = cc.second->typ;
+		ent.ino = cc.second->ino;
+	}
+	return zo_scan_res::ok;
+}
+
+zo_istream_pt
+zo_mem_vfs::open_read(const zo_string& pth){
+	ZO_SYS_INC(open);
+	std::lock_guard<std::mutex> lck(mtx);
+	zo_mem_node_pt nd = find_node(pth);
+	if((nd == zo_null) || (nd->typ != zo_ent_type::regular)){
+		return zo_istream_pt{};
+	}
+	return zo_istream_pt{new std::istringstream(nd->data, std::ios::binary)};
+}
+
+zo_ostream_pt
+zo_mem_vfs::open_write(const zo_string& pth){
+	ZO_SYS_INC(open);
+	std::lock_guard<std::mutex> lck(mtx);
+	zo_string nam;
+	zo_mem_node_pt pnt = find_parent(pth, nam);
+	if(pnt == zo_null){
+		return zo_ostream_pt{};
+	}
+	auto it = pnt->all_child.find(nam);
+	if(it == pnt->all_child.end()){
+		pnt->all_child[nam] = make_node(zo_ent_type::regular);
+		pnt->mtime = clock++;
+	} else if(it->second->typ != zo_ent_type::regular){
+		return zo_ostream_pt{};
+	}
+	return zo_ostream_pt{new zo_mem_ostream(*this, zo_normal_path(pth))};
+}
+
+long
+zo_mem_vfs::copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec){
+	ZO_SYS_INC(open);
+	std::lock_guard<std::mutex> lck(mtx);
+	zo_mem_node_pt src = find_node(orig);
+	if((src == zo_null) || (src->typ != zo_ent_type::regular)){
+		ec = no_entry_err();
+		return ZO_VFS_CANNOT_OPEN_SRC;
+	}
+	ZO_SYS_INC(open);
+	zo_string nam;
+	zo_mem_node_pt pnt = find_parent(dest, nam);
+	if(pnt == zo_null){
+		ec = no_entry_err();
+		return ZO_VFS_CANNOT_OPEN_DST;
+	}
+	zo_mem_node_pt dst = zo_null;
+	auto it = pnt->all_child.find(nam);
+	if(it != pnt->all_child.end()){
+		dst = it->second;
+		if(! replace || (dst->typ != zo_ent_type::regular)){
+			ec = std::make_error_code(std::errc::file_exists);
+			return ZO_VFS_CANNOT_OPEN_DST;
+		}
+	} else {
+		dst = make_node(zo_ent_type::regular);
+		dst->mode = src->mode;
+		pnt->all_child[nam] = dst;
+		pnt->mtime = clock++;
+	}
+	ZO_SYS_INC(copy);
+	if(dst != src){
+		dst->data = src->data;
+		dst->size = src->size;
+	}
+	dst->mtime = clock++;
+	return (long)src->data.size();	// only the head of big files was kept
+}
+
+void
+zo_mem_vfs::rename(const zo_string& orig, const zo_string& dest){
+	ZO_SYS_INC(rename);
+	std::lock_guard<std::mutex> lck(mtx);
+	zo_string o_nam;
+	zo_string d_nam;
+	zo_mem_node_pt o_pnt = find_parent(orig, o_nam);
+	zo_mem_node_pt d_pnt = find_parent(dest, d_nam);
+	auto it = (o_pnt == zo_null)?(zo_mem_node_map::iterator{}):(o_pnt->all_child.find(o_nam));
+	if((o_pnt == zo_null) || (d_pnt == zo_null) || (it == o_pnt->all_child.end())){
+		throw fs::filesystem_error("cannot rename", orig, dest, no_entry_err());
+	}
+	zo_mem_node_pt nd = it->second;
+	o_pnt->all_child.erase(it);
+	auto it_d = d_pnt->all_child.find(d_nam);
+	if(it_d != d_pnt->all_child.end()){
+		it_d->second->nlink--;
+	}
+	d_pnt->all_child[d_nam] = nd;
+	o_pnt->mtime = clock++;
+	d_pnt->mtime = clock++;
+}
+
+void
+zo_mem_vfs::remove(const zo_string& pth){
+	ZO_SYS_INC(unlink);
+	std::lock_guard<std::mutex> lck(mtx);
+	zo_string nam;
+	zo_mem_node_pt pnt = find_parent(pth, nam);
+	if(pnt == zo_null){
+		return;
+	}
+	auto it = pnt->all_child.find(nam);
+	if(it == pnt->all_child.end()){
+		return;
+	}
+	if((it->second->typ == zo_ent_type::directory) && ! it->second->all_child.empty()){
+		throw fs::filesystem_error("cannot remove", pth, std::make_error_code(std::errc::directory_not_empty));
+	}
+	it->second->nlink--;
+	pnt->all_child.erase(it);
+	pnt->mtime = clock++;
+}
+
+void
+zo_mem_vfs::create_directories(const zo_string& pth){
+	ZO_SYS_INC(mkdir);
+	std::lock_guard<std::mutex> lck(mtx);
+	if(make_dirs(pth) == zo_null){
+		throw fs::filesystem_error("cannot create directories", pth, std::make_error_code(std::errc::not_a_directory));
+	}
+}
+
+void
+zo_mem_vfs::hard_link(const zo_string& orig, const zo_string& dest, std::error_code& ec){
+	ZO_SYS_INC(link);
+	std::lock_guard<std::mutex> lck(mtx);
+	zo_mem_node_pt src = find_node(orig);
+	zo_string nam;
+	zo_mem_node_pt pnt = find_parent(dest, nam);
+	if((src == zo_null) || (src->typ != zo_ent_type::regular) || (pnt == zo_null)){
+		ec = no_entry_err();
+		return;
+	}
+	if(pnt->all_child.find(nam) != pnt->all_child.end()){
+		ec = std::make_error_code(std::errc::file_exists);
+		return;
+	}
+	ec.clear();
+	src->nlink++;
+	pnt->all_child[nam] = src;
+	pnt->mtime = clock++;
+}
+
+// latency
+
+bool
+zo_latency_vfs::set_latency(const zo_string& spec){
+	std::stringstream sstm(spec);
+	zo_string item;
+	while(getline(sstm, item, ',')){
+		size_t pos = item.find('=');
+		zo_string knd = (pos == zo_string::npos)?(""):(item.substr(0, pos));
+		long lat_ns = atol(item.substr((pos == zo_string::npos)?(0):(pos + 1)).c_str()) * 1000;
+		bool found = knd.empty();
+		for(int aa = 0; aa < ZO_TOT_SYSCALLS; aa++){
+			if(knd.empty() || (knd == zo_syscall_name((zo_sys)aa))){
+				all_lat_ns[aa] = lat_ns;
+				found = true;
+			}
+		}
+		if(! found){
+			fprintf(stderr, "Unknown call kind '%s' in --vfs_latency\n", knd.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+void
+zo_latency_vfs::delay(zo_sys kk){
+	long ns = all_lat_ns[(int)kk];
+	if(ns <= 0){
+		return;
+	}
+	struct timespec tm;
+	tm.tv_sec = ns / 1000000000L;
+	tm.tv_nsec = ns % 1000000000L;
+	while((nanosleep(&tm, &tm) != 0) && (errno == EINTR)){
+	}
+}
+
+bool
+zo_latency_vfs::stat(const zo_string& pth, zo_vfs_stat& st, bool follow){
+	delay(zo_sys::stat);
+	return base->stat(pth, st, follow);
+}
+
+zo_string
+zo_latency_vfs::canonical(const zo_string& pth, std::error_code& ec){
+	delay(zo_sys::realpath);
+	return base->canonical(pth, ec);
+}
+
+zo_scan_res
+zo_latency_vfs::scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent,
+						 zo_inode_set* all_visited, zo_inode_key* dir_key)
+{
+	delay(zo_sys::open);
+	delay(zo_sys::getdents64);
+	return base->scan_dir(dir_pth, all_ent, all_visited, dir_key);
+}
+
+zo_istream_pt
+zo_latency_vfs::open_read(const zo_string& pth){
+	delay(zo_sys::open);
+	return base->open_read(pth);
+}
+
+zo_ostream_pt
+zo_latency_vfs::open_write(const zo_string& pth){
+	delay(zo_sys::open);
+	return base->open_write(pth);
+}
+
+long
+zo_latency_vfs::copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec){
+	delay(zo_sys::open);
+	delay(zo_sys::open);
+	delay(zo_sys::copy);
+	return base->copy_file(orig, dest, replace, ec);
+}
+
+void
+zo_latency_vfs::rename(const zo_string& orig, const zo_string& dest){
+	delay(zo_sys::rename);
+	base->rename(orig, dest);
+}
+
+void
+zo_latency_vfs::remove(const zo_string& pth){
+	delay(zo_sys::unlink);
+	base->remove(pth);
+}
+
+void
+zo_latency_vfs::create_directories(const zo_string& pth){
+	delay(zo_sys::mkdir);
+	base->create_directories(pth);
+}
+
+void
+zo_latency_vfs::hard_link(const zo_string& orig, const zo_string& dest, std::error_code& ec){
+	delay(zo_sys::link);
+	base->hard_link(orig, dest, ec);
+}
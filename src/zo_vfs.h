@@ -0,0 +1,216 @@
+/*************************************************************
+
+This file is part of sfz_organizer.
+
+sfz_organizer is free software: you can redistribute it and/or modify
+it under the terms of the version 3 of the GNU General Public
+License as published by the Free Software Foundation.
+
+sfz_organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with sfz_organizer.  If not, see <http://www.gnu.org/licenses/>.
+
+------------------------------------------------------------
+
+Copyright (C) 2020. QUIROGA BELTRAN, Jose Luis.
+Id (cedula): 79523732 de Bogota - Colombia.
+See https://github.com/open-soundfonts/sfz_organizer
+
+sfz_organizer is free software thanks to The Glory of Our Lord
+	Yashua Melej Hamashiaj.
+Our Resurrected and Living, both in Body and Spirit,
+	Prince of Peace.
+
+------------------------------------------------------------
+
+
+zo_vfs.h
+
+virtual filesystem used for all access to the organized tree.
+ZO_VFS is the posix one unless --vfs_memory loads the tree into
+memory (nothing is written to disk) or --vfs_latency wraps it to
+add a delay per call kind (the zo_sys kinds of --stats).
+Backends count their calls in ZO_STATS.
+
+--------------------------------------------------------------*/
+
+#ifndef ZO_VFS_H
+#define ZO_VFS_H
+
+#include <istream>
+#include <ostream>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <system_error>
+
+#include "zo_scan.h"
+#include "zo_stats.h"
+
+class zo_vfs_stat {
+public:
+	zo_ent_type 	typ{zo_ent_type::unknown};
+	bool 			is_lnk{false};	// only when not following links
+	zo_inode_key	key;
+	long 			nlink{0};
+	long 			size{0};
+	long 			mode{0};
+	long 			mtime_sec{0};
+	long 			mtime_nsec{0};
+};
+
+using zo_istream_pt = std::unique_ptr<std::istream>;
+using zo_ostream_pt = std::unique_ptr<std::ostream>;
+
+constexpr long ZO_VFS_CANNOT_OPEN_SRC = -1;
+constexpr long ZO_VFS_CANNOT_OPEN_DST = -2;
+
+class zo_vfs {
+public:
+	virtual ~zo_vfs(){}
+	
+	virtual const char* get_name() = 0;
+	
+	virtual bool stat(const zo_string& pth, zo_vfs_stat& st, bool follow = true) = 0;
+	virtual zo_string canonical(const zo_string& pth, std::error_code& ec) = 0;
+	virtual zo_scan_res scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent, 
+						zo_inode_set* all_visited = zo_null, zo_inode_key* dir_key = zo_null) = 0;
+	
+	// null when it cannot be opened. Writes are complete when the stream is destroyed.
+	virtual zo_istream_pt open_read(const zo_string& pth) = 0;
+	virtual zo_ostream_pt open_write(const zo_string& pth) = 0;
+	
+	// bytes copied, or ZO_VFS_CANNOT_OPEN_SRC / ZO_VFS_CANNOT_OPEN_DST. ec is set on errors.
+	// An existing dest is overwritten when replace is given, else it cannot be opened.
+	virtual long copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec) = 0;
+	
+	// these throw fs::filesystem_error on failure, like the fs:: calls they replace.
+	virtual void rename(const zo_string& orig, const zo_string& dest) = 0;
+	virtual void remove(const zo_string& pth) = 0;
+	virtual void create_directories(const zo_string& pth) = 0;
+	
+	virtual void hard_link(const zo_string& orig, const zo_string& dest, std::error_code& ec) = 0;
+	
+	bool exists(const zo_string& pth){
+		zo_vfs_stat st;
+		return stat(pth, st);
+	}
+	
+	bool is_directory(const zo_string& pth){
+		zo_vfs_stat st;
+		return (stat(pth, st) && (st.typ == zo_ent_type::directory));
+	}
+	
+	bool is_symlink(const zo_string& pth){
+		zo_vfs_stat st;
+		return (stat(pth, st, false) && st.is_lnk);
+	}
+};
+
+class zo_posix_vfs : public zo_vfs {
+public:
+	const char* get_name(){ return "posix"; }
+	
+	bool stat(const zo_string& pth, zo_vfs_stat& st, bool follow = true);
+	zo_string canonical(const zo_string& pth, std::error_code& ec);
+	zo_scan_res scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent, 
+						zo_inode_set* all_visited = zo_null, zo_inode_key* dir_key = zo_null);
+	zo_istream_pt open_read(const zo_string& pth);
+	zo_ostream_pt open_write(const zo_string& pth);
+	long copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec);
+	void rename(const zo_string& orig, const zo_string& dest);
+	void remove(const zo_string& pth);
+	void create_directories(const zo_string& pth);
+	void hard_link(const zo_string& orig, const zo_string& dest, std::error_code& ec);
+};
+
+class zo_mem_node;
+using zo_mem_node_pt = std::shared_ptr<zo_mem_node>;
+using zo_mem_node_map = std::map<zo_string, zo_mem_node_pt>;
+
+class zo_mem_node {
+public:
+	zo_ent_type 	typ{zo_ent_type::regular};
+	ino_t 			ino{0};
+	long 			nlink{1};
+	long 			size{0};
+	long 			mode{0644};
+	long 			mtime{0};	// logical clock of the zo_mem_vfs
+	zo_string 		data{""};	// may be only the head of big files loaded from disk
+	zo_mem_node_map	all_child;
+};
+
+// deterministic in-memory tree. Entries are listed in name order. No symlinks.
+class zo_mem_vfs : public zo_vfs {
+public:
+	std::mutex 		mtx;
+	zo_mem_node_pt 	root;
+	ino_t 			last_ino{1};
+	long 			clock{1};
+	long 			tot_loaded{0};
+	
+	zo_mem_vfs();
+	
+	const char* get_name(){ return "memory"; }
+	
+	bool load_tree(const zo_string& real_dir);
+	void put_data(const zo_string& pth, const zo_string& data);
+	
+	bool stat(const zo_string& pth, zo_vfs_stat& st, bool follow = true);
+	zo_string canonical(const zo_string& pth, std::error_code& ec);
+	zo_scan_res scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent, 
+						zo_inode_set* all_visited = zo_null, zo_inode_key* dir_key = zo_null);
+	zo_istream_pt open_read(const zo_string& pth);
+	zo_ostream_pt open_write(const zo_string& pth);
+	long copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec);
+	void rename(const zo_string& orig, const zo_string& dest);
+	void remove(const zo_string& pth);
+	void create_directories(const zo_string& pth);
+	void hard_link(const zo_string& orig, const zo_string& dest, std::error_code& ec);
+	
+private:
+	zo_mem_node_pt make_node(zo_ent_type typ);
+	zo_mem_node_pt find_node(const zo_string& pth);
+	zo_mem_node_pt find_parent(const zo_string& pth, zo_string& nam);
+	zo_mem_node_pt make_dirs(const zo_string& pth);
+	void load_dir(const zo_string& real_dir, zo_mem_node_pt dir);
+};
+
+// adds a fixed delay per zo_sys kind before each call to base.
+class zo_latency_vfs : public zo_vfs {
+public:
+	zo_vfs* 	base{zo_null};
+	long 		all_lat_ns[ZO_TOT_SYSCALLS];
+	
+	zo_latency_vfs(zo_vfs* bs){
+		base = bs;
+		for(auto& ll : all_lat_ns){ ll = 0; }
+	}
+	
+	bool set_latency(const zo_string& spec);
+	void delay(zo_sys kk);
+	
+	const char* get_name(){ return "latency"; }
+	
+	bool stat(const zo_string& pth, zo_vfs_stat& st, bool follow = true);
+	zo_string canonical(const zo_string& pth, std::error_code& ec);
+	zo_scan_res scan_dir(const zo_string& dir_pth, zo_dir_ent_vec& all_ent, 
+						zo_inode_set* all_visited = zo_null, zo_inode_key* dir_key = zo_null);
+	zo_istream_pt open_read(const zo_string& pth);
+	zo_ostream_pt open_write(const zo_string& pth);
+	long copy_file(const zo_string& orig, const zo_string& dest, bool replace, std::error_code& ec);
+	void rename(const zo_string& orig, const zo_string& dest);
+	void remove(const zo_string& pth);
+	void create_directories(const zo_string& pth);
+	void hard_link(const zo_string& orig, const zo_string& dest, std::error_code& ec);
+};
+
+extern zo_vfs* ZO_VFS;
+
+zo_string zo_normal_path(const zo_string& pth);
+
+#endif		// ZO_VFS_H